@@ -0,0 +1,1295 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: bench.c - Microbenchmarks for the libsocket entry points.
+--
+--
+-- PROGRAM: bench
+--
+-- FUNCTIONS:
+-- int main(int argc, char ** argv)
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- NOTES:
+-- Built and run with "make bench". Every function in socket.h is timed, along with the tuning knobs that
+-- change its cost and the shared memory transport against TCP. Each benchmark reports the time per
+-- iteration and, where the kernel allows it, the number of system calls per iteration counted with the
+-- raw_syscalls:sys_enter tracepoint. The count needs tracefs and perf_event_paranoid <= 1, otherwise it
+-- shows as "-".
+--
+-- Like Google Benchmark, each benchmark is run with more iterations until it takes at least the minimum
+-- time, and only the timed region between startTimer and stopTimer is counted, so setup is excluded.
+-- Each tuning knob is also run against the same benchmark without it: receive buffer size under bursts,
+-- TOS and priority marking, busy polling and TCP_QUICKACK against Nagle with delayed acknowledgements.
+-- Error paths are timed too, since every error goes through logger and costs a file open and close.
+-- logger writes log.txt in the working directory, so the benchmarks run in a temporary directory.
+-- openUDP and releaseSocket are the ones the tests use, from tests/test.h.
+--
+-- Usage: bench [--filter=substring] [--min-time=seconds]
+----------------------------------------------------------------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <linux/perf_event.h>
+
+#include "../include/socket.h"
+#include "../include/shmtransport.h"
+#include "../include/capture.h"
+#include "../include/netem.h"
+#include "../tests/test.h"
+
+#define BENCH_PAYLOAD       64
+#define BENCH_LARGE_PAYLOAD 65536
+#define BENCH_GROUP_SIZE    8
+#define BENCH_MAX_CHURN     20000
+#define BENCH_BURST         1024
+#define BENCH_BURST_PAYLOAD 1024
+
+struct benchmark{
+    const char * name;
+    void (*function)(int64_t iterations);
+    int64_t maxIterations;
+};
+
+static int64_t timedNanoseconds;
+static int64_t timerStart;
+static uint64_t countedSyscalls;
+static int32_t syscallCounter = -1;
+static char payload[BENCH_LARGE_PAYLOAD];
+static char receiveBuffer[BENCH_LARGE_PAYLOAD];
+static struct destination loopback;
+
+static int64_t monotonicNanoseconds()
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: openSyscallCounter
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static void openSyscallCounter()
+--
+-- RETURNS: void.
+--
+-- NOTES:
+-- Opens a perf counter for system calls made by this thread. Forked echo processes are not counted. If the
+-- tracepoint is missing or perf is not permitted, syscallCounter stays -1.
+----------------------------------------------------------------------------------------------------------------------*/
+static void openSyscallCounter()
+{
+  static const char *paths[] = {"/sys/kernel/tracing/events/raw_syscalls/sys_enter/id",
+                                "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id"};
+  struct perf_event_attr attributes;
+  FILE *idFile;
+  uint64_t tracepoint;
+  uint32_t i;
+
+  for (i = 0; i < sizeof(paths) / sizeof(paths[0]); i++)
+  {
+    if ((idFile = fopen(paths[i], "r")) == 0)
+    {
+      continue;
+    }
+    if (fscanf(idFile, "%lu", &tracepoint) == 1)
+    {
+      memset(&attributes, 0, sizeof(attributes));
+      attributes.type = PERF_TYPE_TRACEPOINT;
+      attributes.size = sizeof(attributes);
+      attributes.config = tracepoint;
+      attributes.disabled = 1;
+      syscallCounter = syscall(SYS_perf_event_open, &attributes, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+    }
+    fclose(idFile);
+    if (syscallCounter >= 0)
+    {
+      return;
+    }
+  }
+  syscallCounter = -1;
+}
+
+static void startTimer()
+{
+  if (syscallCounter >= 0)
+  {
+    ioctl(syscallCounter, PERF_EVENT_IOC_RESET, 0);
+    ioctl(syscallCounter, PERF_EVENT_IOC_ENABLE, 0);
+  }
+  timerStart = monotonicNanoseconds();
+}
+
+static void stopTimer()
+{
+  uint64_t count;
+
+  timedNanoseconds += monotonicNanoseconds() - timerStart;
+  if (syscallCounter >= 0)
+  {
+    ioctl(syscallCounter, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(syscallCounter, &count, sizeof(count)) == sizeof(count))
+    {
+      countedSyscalls += count;
+    }
+  }
+}
+
+/*
+ * Fixtures
+ */
+
+static struct socketStruct *openListener(struct destination *bound)
+{
+  struct socketStruct *socketPointer = createSocket();
+  struct sockaddr_in address;
+  socklen_t addressLength = sizeof(address);
+
+  initSocketTCP(socketPointer);
+  bindPort(socketPointer, 0);
+  listenTCP(socketPointer, 128);
+  getsockname(socketPointer->socketDescriptor, (struct sockaddr *)&address, &addressLength);
+  bound->address = htonl(INADDR_LOOPBACK);
+  bound->port = address.sin_port;
+  return socketPointer;
+}
+
+static void connectTCP(struct socketStruct **client, struct socketStruct **server, int32_t noDelay)
+{
+  struct socketTuning tuning;
+  struct socketStruct *listener;
+  struct destination bound;
+
+  memset(&tuning, 0, sizeof(tuning));
+  tuning.receiveBufferSize = 1 << 20;
+  tuning.sendBufferSize = 1 << 20;
+  tuning.noDelay = noDelay;
+  listener = openListener(&bound);
+  *client = createSocket();
+  initSocketTCPTuned(*client, &tuning);
+  connectPort(*client, &bound);
+  *server = createSocket();
+  (*server)->socketDescriptor = acceptClient(listener);
+  tuneSocket(*server, &tuning);
+  releaseSocket(listener);
+}
+
+/*
+ * Socket lifetime
+ */
+
+static void benchCreateFree(int64_t iterations)
+{
+  int64_t i;
+
+  startTimer();
+  for (i = 0; i < iterations; i++)
+  {
+    freeSocket(createSocket());
+  }
+  stopTimer();
+}
+
+static void benchInitCloseUDP(int64_t iterations)
+{
+  struct socketStruct *socketPointer = createSocket();
+  int64_t i;
+
+  startTimer();
+  for (i = 0; i < iterations; i++)
+  {
+    initSocket(socketPointer);
+    closeSocket(socketPointer);
+  }
+  stopTimer();
+  freeSocket(socketPointer);
+}
+
+static void benchInitCloseTCP(int64_t iterations)
+{
+  struct socketStruct *socketPointer = createSocket();
+  int64_t i;
+
+  startTimer();
+  for (i = 0; i < iterations; i++)
+  {
+    initSocketTCP(socketPointer);
+    closeSocket(socketPointer);
+  }
+  stopTimer();
+  freeSocket(socketPointer);
+}
+
+static void benchInitTunedUDP(int64_t iterations)
+{
+  struct socketStruct *socketPointer = createSocket();
+  struct socketTuning tuning;
+  int64_t i;
+
+  memset(&tuning, 0, sizeof(tuning));
+  tuning.receiveBufferSize = 1 << 20;
+  tuning.sendBufferSize = 1 << 20;
+  tuning.reuseAddress = 1;
+  startTimer();
+  for (i = 0; i < iterations; i++)
+  {
+    initSocketTuned(socketPointer, &tuning);
+    closeSocket(socketPointer);
+  }
+  stopTimer();
+  freeSocket(socketPointer);
+}
+
+static void benchInitTunedTCP(int64_t iterations)
+{
+  struct socketStruct *socketPointer = createSocket();
+  struct socketTuning tuning;
+  int64_t i;
+
+  memset(&tuning, 0, sizeof(tuning));
+  tuning.noDelay = 1;
+  tuning.quickAck = 1;
+  tuning.reuseAddress = 1;
+  startTimer();
+  for (i = 0; i < iterations; i++)
+  {
+    initSocketTCPTuned(socketPointer, &tuning);
+    closeSocket(socketPointer);
+  }
+  stopTimer();
+  freeSocket(socketPointer);
+}
+
+static void benchBindPort(int64_t iterations)
+{
+  struct socketStruct *socketPointer = createSocket();
+  int64_t i;
+
+  for (i = 0; i < iterations; i++)
+  {
+    initSocket(socketPointer);
+    startTimer();
+    bindPort(socketPointer, 0);
+    stopTimer();
+    closeSocket(socketPointer);
+  }
+  freeSocket(socketPointer);
+}
+
+static void benchListenTCP(int64_t iterations)
+{
+  struct socketStruct *socketPointer = createSocket();
+  int64_t i;
+
+  for (i = 0; i < iterations; i++)
+  {
+    initSocketTCP(socketPointer);
+    bindPort(socketPointer, 0);
+    startTimer();
+    listenTCP(socketPointer, 128);
+    stopTimer();
+    closeSocket(socketPointer);
+  }
+  freeSocket(socketPointer);
+}
+
+/*
+ * Options
+ */
+
+static void benchTuneSocket(int64_t iterations)
+{
+  struct destination bound;
+  struct socketStruct *socketPointer = openUDP(&bound);
+  struct socketTuning tuning;
+  int64_t i;
+
+  memset(&tuning, 0, sizeof(tuning));
+  tuning.receiveBufferSize = 1 << 20;
+  tuning.typeOfService = 0x10;
+  startTimer();
+  for (i = 0; i < iterations; i++)
+  {
+    tuneSocket(socketPointer, &tuning);
+  }
+  stopTimer();
+  releaseSocket(socketPointer);
+}
+
+static void benchAttachTimeout(int64_t iterations)
+{
+  struct destination bound;
+  struct socketStruct *socketPointer = openUDP(&bound);
+  int64_t i;
+
+  startTimer();
+  for (i = 0; i < iterations; i++)
+  {
+    attachTimeout(socketPointer, 1);
+  }
+  stopTimer();
+  releaseSocket(socketPointer);
+}
+
+static void benchAttachReceiveTimeout(int64_t iterations)
+{
+  struct destination bound;
+  struct socketStruct *socketPointer = openUDP(&bound);
+  int64_t i;
+
+  startTimer();
+  for (i = 0; i < iterations; i++)
+  {
+    attachReceiveTimeout(socketPointer, 1000);
+  }
+  stopTimer();
+  releaseSocket(socketPointer);
+}
+
+static void benchAttachSendTimeout(int64_t iterations)
+{
+  struct destination bound;
+  struct socketStruct *socketPointer = openUDP(&bound);
+  int64_t i;
+
+  startTimer();
+  for (i = 0; i < iterations; i++)
+  {
+    attachSendTimeout(socketPointer, 1000);
+  }
+  stopTimer();
+  releaseSocket(socketPointer);
+}
+
+static void benchEnableTimestamping(int64_t iterations)
+{
+  struct destination bound;
+  struct socketStruct *socketPointer = openUDP(&bound);
+  int64_t i;
+
+  startTimer();
+  for (i = 0; i < iterations; i++)
+  {
+    enableTimestamping(socketPointer, TIMESTAMP_SOFTWARE);
+  }
+  stopTimer();
+  releaseSocket(socketPointer);
+}
+
+static void benchMulticastJoinLeave(int64_t iterations)
+{
+  struct destination bound;
+  struct socketStruct *socketPointer = openUDP(&bound);
+  int64_t i;
+
+  startTimer();
+  for (i = 0; i < iterations; i++)
+  {
+    joinMulticastGroup(socketPointer, inet_addr("239.255.42.1"), htonl(INADDR_LOOPBACK));
+    leaveMulticastGroup(socketPointer, inet_addr("239.255.42.1"), htonl(INADDR_LOOPBACK));
+  }
+  stopTimer();
+  releaseSocket(socketPointer);
+}
+
+static void benchMulticastOptions(int64_t iterations)
+{
+  struct destination bound;
+  struct socketStruct *socketPointer = openUDP(&bound);
+  int64_t i;
+
+  startTimer();
+  for (i = 0; i < iterations; i++)
+  {
+    setMulticastTTL(socketPointer, 1);
+    setMulticastLoopback(socketPointer, 1);
+    setMulticastInterface(socketPointer, htonl(INADDR_LOOPBACK));
+  }
+  stopTimer();
+  releaseSocket(socketPointer);
+}
+
+/*
+ * UDP data path
+ */
+
+static void runSendRecv(int64_t iterations, size_t length, struct socketStruct *sender)
+{
+  struct destination bound;
+  struct destination source;
+  struct socketStruct *receiver = openUDP(&bound);
+  int64_t i;
+
+  startTimer();
+  for (i = 0; i < iterations; i++)
+  {
+    sendData(sender, &bound, payload, length);
+    recvData(receiver, &source, receiveBuffer, sizeof(receiveBuffer));
+  }
+  stopTimer();
+  releaseSocket(receiver);
+}
+
+static void benchSendRecv(int64_t iterations)
+{
+  struct destination bound;
+  struct socketStruct *sender = openUDP(&bound);
+
+  runSendRecv(iterations, BENCH_PAYLOAD, sender);
+  releaseSocket(sender);
+}
+
+static void benchSendRecvLarge(int64_t iterations)
+{
+  struct destination bound;
+  struct socketStruct *sender = openUDP(&bound);
+
+  runSendRecv(iterations, 8192, sender);
+  releaseSocket(sender);
+}
+
+static void benchSendRecvCapture(int64_t iterations)
+{
+  struct destination bound;
+  struct socketStruct *sender = openUDP(&bound);
+  struct captureLog *log = openCapture("capture.bin", 0);
+
+  attachCapture(sender, log);
+  runSendRecv(iterations, BENCH_PAYLOAD, sender);
+  releaseSocket(sender);
+  closeCapture(log);
+  unlink("capture.bin");
+}
+
+static void benchSendRecvNetem(int64_t iterations)
+{
+  struct destination bound;
+  struct socketStruct *sender = openUDP(&bound);
+  struct netemConfig config;
+
+  memset(&config, 0, sizeof(config));
+  attachNetem(sender, &config);
+  runSendRecv(iterations, BENCH_PAYLOAD, sender);
+  detachNetem(sender);
+  releaseSocket(sender);
+}
+
+static void benchSendRecvTimeout(int64_t iterations)
+{
+  struct destination bound;
+  struct destination source;
+  struct socketStruct *sender = openUDP(&bound);
+  struct socketStruct *receiver = openUDP(&bound);
+  int64_t i;
+
+  startTimer();
+  for (i = 0; i < iterations; i++)
+  {
+    sendData(sender, &bound, payload, BENCH_PAYLOAD);
+    recvDataTimeout(receiver, &source, receiveBuffer, sizeof(receiveBuffer), 1000000);
+  }
+  stopTimer();
+  releaseSocket(receiver);
+  releaseSocket(sender);
+}
+
+static void benchSendRecvTimestamp(int64_t iterations)
+{
+  struct destination bound;
+  struct destination source;
+  struct packetTimestamp timestamp;
+  struct socketStruct *sender = openUDP(&bound);
+  struct socketStruct *receiver = openUDP(&bound);
+  int64_t i;
+
+  enableTimestamping(receiver, TIMESTAMP_SOFTWARE);
+  startTimer();
+  for (i = 0; i < iterations; i++)
+  {
+    sendData(sender, &bound, payload, BENCH_PAYLOAD);
+    recvDataTimestamp(receiver, &source, &timestamp, receiveBuffer, sizeof(receiveBuffer));
+  }
+  stopTimer();
+  releaseSocket(receiver);
+  releaseSocket(sender);
+}
+
+static void benchSendRecvTxTimestamp(int64_t iterations)
+{
+  struct destination bound;
+  struct destination source;
+  struct packetTimestamp timestamp;
+  struct socketStruct *sender = openUDP(&bound);
+  struct socketStruct *receiver = openUDP(&bound);
+  uint32_t sendIndex;
+  int64_t i;
+
+  enableTimestamping(sender, TIMESTAMP_SOFTWARE | TIMESTAMP_TX);
+  startTimer();
+  for (i = 0; i < iterations; i++)
+  {
+    sendData(sender, &bound, payload, BENCH_PAYLOAD);
+    recvData(receiver, &source, receiveBuffer, sizeof(receiveBuffer));
+    recvTxTimestamp(sender, &sendIndex, &timestamp);
+  }
+  stopTimer();
+  releaseSocket(receiver);
+  releaseSocket(sender);
+}
+
+// Per datagram cost of a full batch of RECV_BATCH_MAX, sent one by one
+static void benchRecvBatch(int64_t iterations)
+{
+  struct destination bound;
+  struct socketStruct *sender = openUDP(&bound);
+  struct socketStruct *receiver = openUDP(&bound);
+  struct receivedPacket packets[RECV_BATCH_MAX];
+  static char buffers[RECV_BATCH_MAX][BENCH_PAYLOAD];
+  struct socketTuning tuning;
+  int64_t received;
+  int32_t count;
+  int32_t i;
+
+  memset(&tuning, 0, sizeof(tuning));
+  tuning.receiveBufferSize = 1 << 20;
+  tuneSocket(receiver, &tuning);
+  for (i = 0; i < RECV_BATCH_MAX; i++)
+  {
+    packets[i].dataBuffer = buffers[i];
+    packets[i].dataBufferSize = BENCH_PAYLOAD;
+  }
+  for (received = 0; received < iterations; received += count)
+  {
+    count = iterations - received < RECV_BATCH_MAX ? iterations - received : RECV_BATCH_MAX;
+    for (i = 0; i < count; i++)
+    {
+      sendData(sender, &bound, payload, BENCH_PAYLOAD);
+    }
+    startTimer();
+    count = recvDataBatch(receiver, packets, count);
+    stopTimer();
+    if (count <= 0)
+    {
+      break;
+    }
+  }
+  releaseSocket(receiver);
+  releaseSocket(sender);
+}
+
+// Per destination cost of one datagram sent to BENCH_GROUP_SIZE receivers
+static void benchSendDataGroup(int64_t iterations)
+{
+  struct destination bound;
+  struct destination groups[BENCH_GROUP_SIZE];
+  struct socketStruct *receivers[BENCH_GROUP_SIZE];
+  struct socketStruct *sender = openUDP(&bound);
+  struct destination source;
+  int64_t sent;
+  int32_t i;
+
+  for (i = 0; i < BENCH_GROUP_SIZE; i++)
+  {
+    receivers[i] = openUDP(&groups[i]);
+  }
+  for (sent = 0; sent < iterations; sent += BENCH_GROUP_SIZE)
+  {
+    startTimer();
+    sendDataGroup(sender, groups, BENCH_GROUP_SIZE, payload, BENCH_PAYLOAD);
+    stopTimer();
+    for (i = 0; i < BENCH_GROUP_SIZE; i++)
+    {
+      recvData(receivers[i], &source, receiveBuffer, sizeof(receiveBuffer));
+    }
+  }
+  for (i = 0; i < BENCH_GROUP_SIZE; i++)
+  {
+    releaseSocket(receivers[i]);
+  }
+  releaseSocket(sender);
+}
+
+// Per datagram cost of a full batch of SEND_BATCH_MAX, received one by one
+static void benchSendDataBatch(int64_t iterations)
+{
+  struct destination bound;
+  struct destination source;
+  struct socketStruct *sender = openUDP(&bound);
+  struct socketStruct *receiver = openUDP(&bound);
+  struct sendPacket packets[SEND_BATCH_MAX];
+  struct socketTuning tuning;
+  int64_t sent;
+  int32_t count;
+  int32_t i;
+
+  memset(&tuning, 0, sizeof(tuning));
+  tuning.receiveBufferSize = 1 << 20;
+  tuneSocket(receiver, &tuning);
+  for (i = 0; i < SEND_BATCH_MAX; i++)
+  {
+    packets[i].dest = bound;
+    packets[i].data = payload;
+    packets[i].dataLength = BENCH_PAYLOAD;
+  }
+  for (sent = 0; sent < iterations; sent += count)
+  {
+    count = iterations - sent < SEND_BATCH_MAX ? iterations - sent : SEND_BATCH_MAX;
+    startTimer();
+    count = sendDataBatch(sender, packets, count);
+    stopTimer();
+    for (i = 0; i < count; i++)
+    {
+      recvData(receiver, &source, receiveBuffer, sizeof(receiveBuffer));
+    }
+    if (count <= 0)
+    {
+      break;
+    }
+  }
+  releaseSocket(receiver);
+  releaseSocket(sender);
+}
+
+/*
+ * TCP connections and data path
+ */
+
+static void benchConnectAccept(int64_t iterations)
+{
+  struct destination bound;
+  struct socketStruct *listener = openListener(&bound);
+  struct socketStruct *client = createSocket();
+  int32_t accepted;
+  int64_t i;
+
+  startTimer();
+  for (i = 0; i < iterations; i++)
+  {
+    initSocketTCP(client);
+    connectPort(client, &bound);
+    accepted = acceptClient(listener);
+    close(accepted);
+    closeSocket(client);
+  }
+  stopTimer();
+  freeSocket(client);
+  releaseSocket(listener);
+}
+
+static void benchConnectTimeoutAccept(int64_t iterations)
+{
+  struct destination bound;
+  struct socketStruct *listener = openListener(&bound);
+  struct socketStruct *client = createSocket();
+  int32_t accepted;
+  int64_t i;
+
+  startTimer();
+  for (i = 0; i < iterations; i++)
+  {
+    initSocketTCP(client);
+    connectPortTimeout(client, &bound, 1000000);
+    accepted = acceptClient(listener);
+    close(accepted);
+    closeSocket(client);
+  }
+  stopTimer();
+  freeSocket(client);
+  releaseSocket(listener);
+}
+
+// Per connection cost of accepting 16 pending connections in one call
+static void benchAcceptClients(int64_t iterations)
+{
+  struct destination bound;
+  struct socketStruct *listener = openListener(&bound);
+  struct socketStruct *connecting[16];
+  struct socketStruct *accepted[16];
+  int64_t done;
+  int32_t pending;
+  int32_t count;
+  int32_t i;
+
+  for (done = 0; done < iterations; done += count)
+  {
+    pending = iterations - done < 16 ? iterations - done : 16;
+    for (i = 0; i < pending; i++)
+    {
+      connecting[i] = createSocket();
+      initSocketTCP(connecting[i]);
+      connectPort(connecting[i], &bound);
+    }
+    startTimer();
+    count = acceptClients(listener, accepted, 0, pending);
+    stopTimer();
+    for (i = 0; i < count; i++)
+    {
+      releaseSocket(accepted[i]);
+    }
+    for (i = 0; i < pending; i++)
+    {
+      releaseSocket(connecting[i]);
+    }
+    if (count <= 0)
+    {
+      break;
+    }
+  }
+  releaseSocket(listener);
+}
+
+static void runTCPSendRecv(int64_t iterations, int32_t length, int32_t noDelay, int32_t useTimeout)
+{
+  struct socketStruct *client;
+  struct socketStruct *server;
+  int64_t i;
+
+  connectTCP(&client, &server, noDelay);
+  startTimer();
+  for (i = 0; i < iterations; i++)
+  {
+    sendDataTCP(client, payload, length);
+    if (useTimeout)
+    {
+      recvDataTCPTimeout(server, receiveBuffer, length, 1000000);
+    }
+    else
+    {
+      recvDataTCP(server, receiveBuffer, length);
+    }
+  }
+  stopTimer();
+  releaseSocket(server);
+  releaseSocket(client);
+}
+
+static void benchTCPSendRecv(int64_t iterations)
+{
+  runTCPSendRecv(iterations, BENCH_PAYLOAD, 0, 0);
+}
+
+static void benchTCPSendRecvNoDelay(int64_t iterations)
+{
+  runTCPSendRecv(iterations, BENCH_PAYLOAD, 1, 0);
+}
+
+static void benchTCPSendRecvLarge(int64_t iterations)
+{
+  runTCPSendRecv(iterations, BENCH_LARGE_PAYLOAD, 1, 0);
+}
+
+static void benchTCPSendRecvTimeout(int64_t iterations)
+{
+  runTCPSendRecv(iterations, BENCH_PAYLOAD, 1, 1);
+}
+
+/*
+ * Round trips to another process, shared memory against TCP
+ */
+
+static void benchRoundTripTCP(int64_t iterations)
+{
+  struct destination bound;
+  struct socketStruct *listener = openListener(&bound);
+  struct socketStruct *connection;
+  struct socketTuning tuning;
+  pid_t child;
+  int64_t i;
+
+  memset(&tuning, 0, sizeof(tuning));
+  tuning.noDelay = 1;
+  if ((child = fork()) == 0)
+  {
+    connection = createSocket();
+    initSocketTCPTuned(connection, &tuning);
+    connectPort(connection, &bound);
+    while (recvDataTCP(connection, receiveBuffer, BENCH_PAYLOAD) > 0 && sendDataTCP(connection, receiveBuffer, BENCH_PAYLOAD))
+    {
+    }
+    _exit(0);
+  }
+  connection = createSocket();
+  connection->socketDescriptor = acceptClient(listener);
+  tuneSocket(connection, &tuning);
+
+  startTimer();
+  for (i = 0; i < iterations; i++)
+  {
+    sendDataTCP(connection, payload, BENCH_PAYLOAD);
+    recvDataTCP(connection, receiveBuffer, BENCH_PAYLOAD);
+  }
+  stopTimer();
+  releaseSocket(connection);
+  releaseSocket(listener);
+  waitpid(child, 0, 0);
+}
+
+static void benchRoundTripShared(int64_t iterations)
+{
+  struct destination bound;
+  struct socketStruct *reserved = openListener(&bound);
+  struct localChannel *listener;
+  struct localChannel *channel;
+  pid_t child;
+  int32_t length;
+  int64_t i;
+
+  // Borrow a free port from the kernel for the channel
+  releaseSocket(reserved);
+  listener = listenLocal(bound.port, 0);
+  if ((child = fork()) == 0)
+  {
+    channel = connectLocal(&bound);
+    while ((length = recvLocal(channel, receiveBuffer, sizeof(receiveBuffer))) > 0 && sendLocal(channel, receiveBuffer, length))
+    {
+    }
+    _exit(0);
+  }
+  channel = acceptLocal(listener);
+
+  startTimer();
+  for (i = 0; i < iterations; i++)
+  {
+    sendLocal(channel, payload, BENCH_PAYLOAD);
+    recvLocal(channel, receiveBuffer, sizeof(receiveBuffer));
+  }
+  stopTimer();
+  closeLocal(channel);
+  closeLocal(listener);
+  waitpid(child, 0, 0);
+}
+
+/*
+ * Tuning knobs, each against the same run without it
+ */
+
+// Per delivered datagram cost of bursts that arrive faster than they are read. Datagrams dropped because
+// the receive buffer filled up have to be sent again, so a small buffer shows up as a higher cost.
+static void runBurst(int64_t iterations, int32_t receiveBufferSize)
+{
+  struct destination bound;
+  struct destination source;
+  struct socketStruct *sender = openUDP(&bound);
+  struct socketStruct *receiver = openUDP(&bound);
+  struct socketTuning tuning;
+  int64_t delivered = 0;
+  int32_t i;
+
+  memset(&tuning, 0, sizeof(tuning));
+  tuning.receiveBufferSize = receiveBufferSize;
+  tuneSocket(receiver, &tuning);
+  startTimer();
+  while (delivered < iterations)
+  {
+    for (i = 0; i < BENCH_BURST; i++)
+    {
+      sendData(sender, &bound, payload, BENCH_BURST_PAYLOAD);
+    }
+    while (recvDataTimeout(receiver, &source, receiveBuffer, sizeof(receiveBuffer), 0) > 0)
+    {
+      delivered++;
+    }
+  }
+  stopTimer();
+  releaseSocket(receiver);
+  releaseSocket(sender);
+}
+
+static void benchBurstDefaultBuffer(int64_t iterations)
+{
+  runBurst(iterations, 0);
+}
+
+static void benchBurstLargeBuffer(int64_t iterations)
+{
+  runBurst(iterations, 4 << 20);
+}
+
+// Marking only costs anything once a qdisc or the network acts on it, loopback shows the option overhead
+static void benchSendRecvMarked(int64_t iterations)
+{
+  struct destination bound;
+  struct socketStruct *sender = openUDP(&bound);
+  struct socketTuning tuning;
+
+  memset(&tuning, 0, sizeof(tuning));
+  tuning.typeOfService = 0xB8;
+  tuning.priority = 6;
+  tuneSocket(sender, &tuning);
+  runSendRecv(iterations, BENCH_PAYLOAD, sender);
+  releaseSocket(sender);
+}
+
+// Round trip to an echo process, both ends optionally busy polling instead of sleeping
+static void runRoundTripUDP(int64_t iterations, int32_t busyPollMicroseconds)
+{
+  struct destination bound;
+  struct destination echoBound;
+  struct destination source;
+  struct socketStruct *local = openUDP(&bound);
+  struct socketStruct *echo = openUDP(&echoBound);
+  struct socketTuning tuning;
+  pid_t child;
+  int32_t length;
+  int64_t i;
+
+  memset(&tuning, 0, sizeof(tuning));
+  tuning.busyPollMicroseconds = busyPollMicroseconds;
+  tuneSocket(local, &tuning);
+  tuneSocket(echo, &tuning);
+  if ((child = fork()) == 0)
+  {
+    while ((length = recvData(echo, &source, receiveBuffer, sizeof(receiveBuffer))) > 0 && sendData(echo, &source, receiveBuffer, length))
+    {
+    }
+    _exit(0);
+  }
+
+  startTimer();
+  for (i = 0; i < iterations; i++)
+  {
+    sendData(local, &echoBound, payload, BENCH_PAYLOAD);
+    recvData(local, &source, receiveBuffer, sizeof(receiveBuffer));
+  }
+  stopTimer();
+  kill(child, SIGKILL);
+  waitpid(child, 0, 0);
+  releaseSocket(echo);
+  releaseSocket(local);
+}
+
+static void benchRoundTripUDP(int64_t iterations)
+{
+  runRoundTripUDP(iterations, 0);
+}
+
+static void benchRoundTripUDPBusyPoll(int64_t iterations)
+{
+  runRoundTripUDP(iterations, 50);
+}
+
+// A request written as a 16 byte header and a 48 byte body. Nagle holds the body until the header is
+// acknowledged, and the server delays that acknowledgement because it is waiting to reply. TCP_NODELAY on
+// the client or TCP_QUICKACK on the server, re-armed after every reply, each break the stall.
+static void runWriteWriteRead(int64_t iterations, int32_t noDelay, int32_t quickAck)
+{
+  struct destination bound;
+  struct socketStruct *listener = openListener(&bound);
+  struct socketStruct *connection;
+  struct socketTuning tuning;
+  struct socketTuning ackTuning;
+  pid_t child;
+  int64_t i;
+
+  memset(&tuning, 0, sizeof(tuning));
+  tuning.noDelay = noDelay;
+  memset(&ackTuning, 0, sizeof(ackTuning));
+  ackTuning.quickAck = quickAck;
+  if ((child = fork()) == 0)
+  {
+    connection = createSocket();
+    initSocketTCP(connection);
+    connectPort(connection, &bound);
+    tuneSocket(connection, &ackTuning);
+    while (recvDataTCP(connection, receiveBuffer, BENCH_PAYLOAD) > 0 && sendDataTCP(connection, receiveBuffer, BENCH_PAYLOAD))
+    {
+      // Sending the reply puts the socket back into delayed acknowledgement mode
+      tuneSocket(connection, &ackTuning);
+    }
+    _exit(0);
+  }
+  connection = createSocket();
+  connection->socketDescriptor = acceptClient(listener);
+  tuneSocket(connection, &tuning);
+
+  startTimer();
+  for (i = 0; i < iterations; i++)
+  {
+    sendDataTCP(connection, payload, 16);
+    sendDataTCP(connection, payload + 16, BENCH_PAYLOAD - 16);
+    recvDataTCP(connection, receiveBuffer, BENCH_PAYLOAD);
+  }
+  stopTimer();
+  releaseSocket(connection);
+  releaseSocket(listener);
+  waitpid(child, 0, 0);
+}
+
+static void benchWriteWriteRead(int64_t iterations)
+{
+  runWriteWriteRead(iterations, 0, 0);
+}
+
+static void benchWriteWriteReadQuickAck(int64_t iterations)
+{
+  runWriteWriteRead(iterations, 0, 1);
+}
+
+static void benchWriteWriteReadNoDelay(int64_t iterations)
+{
+  runWriteWriteRead(iterations, 1, 0);
+}
+
+/*
+ * Error paths, each one goes through logger except timeouts
+ */
+
+static void benchLogger(int64_t iterations)
+{
+  int64_t i;
+
+  startTimer();
+  for (i = 0; i < iterations; i++)
+  {
+    logger("ERROR > benchmark", ERR_UNKNOWN);
+  }
+  stopTimer();
+}
+
+static void benchErrorNullSocket(int64_t iterations)
+{
+  int64_t i;
+
+  startTimer();
+  for (i = 0; i < iterations; i++)
+  {
+    sendData(0, &loopback, payload, BENCH_PAYLOAD);
+  }
+  stopTimer();
+}
+
+static void benchErrorBadDescriptor(int64_t iterations)
+{
+  struct socketStruct *socketPointer = createSocket();
+  int64_t i;
+
+  socketPointer->socketDescriptor = -1;
+  startTimer();
+  for (i = 0; i < iterations; i++)
+  {
+    sendData(socketPointer, &loopback, payload, BENCH_PAYLOAD);
+  }
+  stopTimer();
+  freeSocket(socketPointer);
+}
+
+static void benchErrorReceiveTimeout(int64_t iterations)
+{
+  struct destination bound;
+  struct destination source;
+  struct socketStruct *socketPointer = openUDP(&bound);
+  int64_t i;
+
+  startTimer();
+  for (i = 0; i < iterations; i++)
+  {
+    recvDataTimeout(socketPointer, &source, receiveBuffer, sizeof(receiveBuffer), 0);
+  }
+  stopTimer();
+  releaseSocket(socketPointer);
+}
+
+static void benchErrorConnectRefused(int64_t iterations)
+{
+  struct destination bound;
+  struct socketStruct *reserved = openListener(&bound);
+  struct socketStruct *client = createSocket();
+  int64_t i;
+
+  releaseSocket(reserved);
+  startTimer();
+  for (i = 0; i < iterations; i++)
+  {
+    initSocketTCP(client);
+    connectPort(client, &bound);
+    closeSocket(client);
+  }
+  stopTimer();
+  freeSocket(client);
+}
+
+static void benchGetSocketError(int64_t iterations)
+{
+  struct destination bound;
+  struct socketStruct *socketPointer = openUDP(&bound);
+  int64_t i;
+
+  startTimer();
+  for (i = 0; i < iterations; i++)
+  {
+    getSocketError(socketPointer);
+  }
+  stopTimer();
+  releaseSocket(socketPointer);
+}
+
+static struct benchmark benchmarks[] = {
+    {"createSocket/freeSocket", benchCreateFree, 0},
+    {"initSocket/closeSocket", benchInitCloseUDP, 0},
+    {"initSocketTCP/closeSocket", benchInitCloseTCP, 0},
+    {"initSocketTuned", benchInitTunedUDP, 0},
+    {"initSocketTCPTuned", benchInitTunedTCP, 0},
+    {"bindPort", benchBindPort, BENCH_MAX_CHURN},
+    {"listenTCP", benchListenTCP, BENCH_MAX_CHURN},
+    {"tuneSocket", benchTuneSocket, 0},
+    {"attachTimeout", benchAttachTimeout, 0},
+    {"attachReceiveTimeout", benchAttachReceiveTimeout, 0},
+    {"attachSendTimeout", benchAttachSendTimeout, 0},
+    {"enableTimestamping", benchEnableTimestamping, 0},
+    {"joinMulticastGroup/leaveMulticastGroup", benchMulticastJoinLeave, 0},
+    {"setMulticastTTL/Loopback/Interface", benchMulticastOptions, 0},
+    {"sendData/recvData/64", benchSendRecv, 0},
+    {"sendData/recvData/8192", benchSendRecvLarge, 0},
+    {"sendData/recvData/64/capture", benchSendRecvCapture, 0},
+    {"sendData/recvData/64/netem", benchSendRecvNetem, 0},
+    {"sendData/recvDataTimeout/64", benchSendRecvTimeout, 0},
+    {"sendData/recvDataTimestamp/64", benchSendRecvTimestamp, 0},
+    {"sendData/recvTxTimestamp/64", benchSendRecvTxTimestamp, 0},
+    {"recvDataBatch/64", benchRecvBatch, 0},
+    {"sendDataGroup/64", benchSendDataGroup, 0},
+    {"sendDataBatch/64", benchSendDataBatch, 0},
+    {"connectPort/acceptClient", benchConnectAccept, BENCH_MAX_CHURN},
+    {"connectPortTimeout/acceptClient", benchConnectTimeoutAccept, BENCH_MAX_CHURN},
+    {"acceptClients", benchAcceptClients, BENCH_MAX_CHURN},
+    {"sendDataTCP/recvDataTCP/64", benchTCPSendRecv, 0},
+    {"sendDataTCP/recvDataTCP/64/nodelay", benchTCPSendRecvNoDelay, 0},
+    {"sendDataTCP/recvDataTCP/65536/nodelay", benchTCPSendRecvLarge, 0},
+    {"sendDataTCP/recvDataTCPTimeout/64/nodelay", benchTCPSendRecvTimeout, 0},
+    {"roundTrip/tcp/64", benchRoundTripTCP, 0},
+    {"roundTrip/shared/64", benchRoundTripShared, 0},
+    {"burst/1024/rcvbuf-default", benchBurstDefaultBuffer, 0},
+    {"burst/1024/rcvbuf-4M", benchBurstLargeBuffer, 0},
+    {"sendData/recvData/64/tos+priority", benchSendRecvMarked, 0},
+    {"roundTrip/udp/64", benchRoundTripUDP, 0},
+    {"roundTrip/udp/64/busypoll", benchRoundTripUDPBusyPoll, 0},
+    {"writeWriteRead/tcp/64", benchWriteWriteRead, 0},
+    {"writeWriteRead/tcp/64/quickack", benchWriteWriteReadQuickAck, 0},
+    {"writeWriteRead/tcp/64/nodelay", benchWriteWriteReadNoDelay, 0},
+    {"logger", benchLogger, 0},
+    {"error/nullSocket", benchErrorNullSocket, 0},
+    {"error/badDescriptor", benchErrorBadDescriptor, 0},
+    {"error/receiveTimeout", benchErrorReceiveTimeout, 0},
+    {"error/connectRefused", benchErrorConnectRefused, BENCH_MAX_CHURN},
+    {"getSocketError", benchGetSocketError, 0},
+};
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: runBenchmark
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static void runBenchmark(struct benchmark * bench, int64_t minNanoseconds)
+--                struct benchmark * bench: The benchmark to run
+--                int64_t minNanoseconds: How long the timed region must take for the result to count
+--
+-- RETURNS: void.
+--
+-- NOTES:
+-- Starts with one iteration and grows the count from the time taken, at most tenfold per run, until the
+-- timed region is long enough or the benchmark's iteration cap is reached.
+----------------------------------------------------------------------------------------------------------------------*/
+static void runBenchmark(struct benchmark *bench, int64_t minNanoseconds)
+{
+  int64_t iterations = 1;
+  int64_t next;
+  char syscalls[32];
+
+  for (;;)
+  {
+    timedNanoseconds = 0;
+    countedSyscalls = 0;
+    bench->function(iterations);
+    if (timedNanoseconds >= minNanoseconds || (bench->maxIterations > 0 && iterations >= bench->maxIterations))
+    {
+      break;
+    }
+    next = timedNanoseconds > 0 ? (int64_t)(iterations * 1.4 * minNanoseconds / timedNanoseconds) : iterations * 10;
+    next = next > iterations * 10 ? iterations * 10 : next;
+    next = next <= iterations ? iterations + 1 : next;
+    iterations = bench->maxIterations > 0 && next > bench->maxIterations ? bench->maxIterations : next;
+  }
+
+  if (syscallCounter >= 0)
+  {
+    snprintf(syscalls, sizeof(syscalls), "%.2f", (double)countedSyscalls / iterations);
+  }
+  else
+  {
+    snprintf(syscalls, sizeof(syscalls), "-");
+  }
+  printf("%-44s %12.1f %12ld %14s\n", bench->name, (double)timedNanoseconds / iterations, iterations, syscalls);
+  fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+  const char *filter = 0;
+  double minSeconds = 0.2;
+  char directory[] = "/tmp/libsocket-bench-XXXXXX";
+  uint32_t i;
+
+  for (i = 1; i < (uint32_t)argc; i++)
+  {
+    if (strncmp(argv[i], "--filter=", 9) == 0)
+    {
+      filter = argv[i] + 9;
+    }
+    else if (strncmp(argv[i], "--min-time=", 11) == 0)
+    {
+      minSeconds = atof(argv[i] + 11);
+    }
+    else
+    {
+      fprintf(stderr, "usage: %s [--filter=substring] [--min-time=seconds]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (mkdtemp(directory) == 0 || chdir(directory) == -1)
+  {
+    perror("bench: temporary directory");
+    return 1;
+  }
+
+  openSyscallCounter();
+  memset(payload, 'x', sizeof(payload));
+  loopback.address = htonl(INADDR_LOOPBACK);
+  loopback.port = htons(9);
+
+  printf("%-44s %12s %12s %14s\n", "Benchmark", "Time(ns)", "Iterations", "Syscalls/iter");
+  for (i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++)
+  {
+    if (filter == 0 || strstr(benchmarks[i].name, filter) != 0)
+    {
+      runBenchmark(&benchmarks[i], (int64_t)(minSeconds * 1e9));
+    }
+  }
+
+  unlink("log.txt");
+  rmdir(directory);
+  return 0;
+}
@@ -0,0 +1,670 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: capture.c - Records the traffic of sockets to a memory mapped log and replays it.
+--
+--
+-- PROGRAM: libsocket
+--
+-- FUNCTIONS:
+-- struct captureLog * openCapture(const char * path, uint64_t capacity)
+-- int attachCapture(struct socketStruct * socketPointer, struct captureLog * log)
+-- int detachCapture(struct socketStruct * socketPointer)
+-- void capturePacket(struct captureLog * log, int32_t socketDescriptor, int32_t direction,
+--                    struct destination * peer, const char * data, int64_t dataLength)
+-- void getCaptureStats(struct captureLog * log, struct captureStats * stats)
+-- int closeCapture(struct captureLog * log)
+-- struct captureReader * openCaptureReader(const char * path)
+-- int nextCapturedPacket(struct captureReader * reader, struct capturedPacket * packet)
+-- void rewindCaptureReader(struct captureReader * reader)
+-- void closeCaptureReader(struct captureReader * reader)
+-- int64_t replayCapture(struct captureReader * reader, struct socketStruct * socketPointer,
+--                       struct destination * target, int32_t directions, double speed)
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- NOTES:
+-- A capture log is a file of fixed size mapped into memory. It starts with a captureHeader, followed by
+-- records packed back to back. Each record is a captureRecord followed by the payload, padded to 8 bytes.
+-- Once a log is attached to a socket, sendData, sendDataGroup, sendDataBatch, recvData, recvDataTimeout,
+-- recvDataTimestamp, recvDataBatch, recvDataRing, sendDataTCP, recvDataTCP and recvDataTCPTimeout record
+-- every datagram or stream chunk that succeeds. Messages on a shared memory localChannel never reach a
+-- socket and are not recorded; a channel that fell back to TCP records its framed stream. Each record holds the CLOCK_MONOTONIC time in nanoseconds, the peer, the
+-- direction and the socket.
+--
+-- Writers reserve space with one atomic add, copy the record in and publish it by storing recordSize last.
+-- Any number of sockets and threads may share a log without a lock, and no system call is made. When the
+-- log is full, later records are dropped and counted. A reader stops at the first record that was never
+-- published. Sockets without a log pay a single branch per call.
+--
+-- replayCapture sends the recorded payloads again through sendData or sendDataTCP. It keeps the original
+-- gaps between packets, divided by a speed factor, so a server can be fed the exact traffic it saw.
+----------------------------------------------------------------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include "include/capture.h"
+#include "include/internal.h"
+
+static int64_t clockNanoseconds(clockid_t clock);
+static void registerCaptureHooks();
+
+static pthread_once_t captureHooksOnce = PTHREAD_ONCE_INIT;
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: openCapture
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: struct captureLog * openCapture(const char * path, uint64_t capacity)
+--                const char * path: The file to write, replaced if it exists
+--                uint64_t capacity: The space for records in bytes, or 0 for CAPTURE_DEFAULT_SIZE
+--
+-- RETURNS: On success a log is returned. On error a null pointer is returned and lastSocketError is set
+--          appropriately.
+--
+-- NOTES:
+-- This function is used to create a capture log. The whole file is sized and mapped up front so that
+-- recording never has to grow it.
+----------------------------------------------------------------------------------------------------------------------*/
+struct captureLog *openCapture(const char *path, uint64_t capacity)
+{
+  struct captureLog *log;
+
+  if (path == 0)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid path passed to openCapture", lastSocketError);
+    return 0;
+  }
+  if ((log = calloc(1, sizeof(struct captureLog))) == 0)
+  {
+    lastSocketError = ERR_NOMEMORY;
+    logger("ERROR > unable to allocate capture log", lastSocketError);
+    return 0;
+  }
+  log->capacity = capacity == 0 ? CAPTURE_DEFAULT_SIZE : (capacity + 7) & ~7ULL;
+
+  if ((log->fileDescriptor = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)) == -1)
+  {
+    lastSocketError = errno == EACCES || errno == EPERM ? ERR_PERMISSION : ERR_UNKNOWN;
+    logger("ERROR > unable to create capture file", lastSocketError);
+    free(log);
+    return 0;
+  }
+  if (ftruncate(log->fileDescriptor, sizeof(struct captureHeader) + log->capacity) == -1 ||
+      (log->base = mmap(0, sizeof(struct captureHeader) + log->capacity, PROT_READ | PROT_WRITE, MAP_SHARED, log->fileDescriptor, 0)) == MAP_FAILED)
+  {
+    lastSocketError = ERR_NOMEMORY;
+    logger("ERROR > unable to map capture file", lastSocketError);
+    close(log->fileDescriptor);
+    free(log);
+    return 0;
+  }
+
+  log->header = (struct captureHeader *)log->base;
+  memcpy(log->header->magic, CAPTURE_MAGIC, sizeof(log->header->magic));
+  log->header->version = CAPTURE_VERSION;
+  log->header->headerSize = sizeof(struct captureHeader);
+  log->header->startRealtime = clockNanoseconds(CLOCK_REALTIME);
+  log->header->startMonotonic = clockNanoseconds(CLOCK_MONOTONIC);
+  atomic_init(&log->header->used, 0);
+  atomic_init(&log->header->dropped, 0);
+  return log;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: attachCapture
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS: October 18, 2026
+--              -Registers the capture functions with socket.c
+--              -The log is kept by descriptor and counts the sockets attached to it
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int attachCapture(struct socketStruct * socketPointer, struct captureLog * log)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct to record
+--                struct captureLog * log: The log to record into, or null to stop recording
+--
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used to start or stop recording a socket. A log already attached to the socket is
+-- replaced. Like initializing a socket, it must not overlap with other calls on the socket. The log
+-- belongs to the descriptor, so a socketStruct wrapping the descriptor of a ringReceiver records what
+-- recvDataRing returns.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t attachCapture(struct socketStruct *socketPointer, struct captureLog *log)
+{
+  void *previous;
+
+  if (socketPointer == 0)
+  {
+    logger("ERROR > invalid socket passed to attachCapture", -1);
+    return 0;
+  }
+  if (log != 0)
+  {
+    pthread_once(&captureHooksOnce, registerCaptureHooks);
+    atomic_fetch_add(&log->attachedSockets, 1);
+  }
+  if (!exchangeSocketHook(socketPointer->socketDescriptor, HOOK_CAPTURE, log, &previous))
+  {
+    if (log != 0)
+    {
+      atomic_fetch_sub(&log->attachedSockets, 1);
+    }
+    logger("ERROR > unable to attach capture log", lastSocketError);
+    return 0;
+  }
+  if (previous != 0)
+  {
+    atomic_fetch_sub(&((struct captureLog *)previous)->attachedSockets, 1);
+  }
+  return 1;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: detachCapture
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int detachCapture(struct socketStruct * socketPointer)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct being recorded
+--
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used to stop recording a socket. closeSocket calls it, so a log only has to be
+-- detached by hand from sockets that stay open. Sockets without a log are left alone.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t detachCapture(struct socketStruct *socketPointer)
+{
+  if (socketPointer == 0)
+  {
+    logger("ERROR > invalid socket passed to detachCapture", -1);
+    return 0;
+  }
+  if (getSocketHook(socketPointer->socketDescriptor, HOOK_CAPTURE) == 0)
+  {
+    return 1;
+  }
+  return attachCapture(socketPointer, 0);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: capturePacket
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: void capturePacket(struct captureLog * log, int32_t socketDescriptor, int32_t direction,
+--                               struct destination * peer, const char * data, int64_t dataLength)
+--                struct captureLog * log: The log to record into
+--                int32_t socketDescriptor: The socket the data went through
+--                int32_t direction: CAPTURE_SEND or CAPTURE_RECV, with CAPTURE_TCP for stream data
+--                struct destination * peer: The other end, or null if unknown
+--                const char * data: The payload
+--                int64_t dataLength: The length of the payload, nothing is recorded if negative
+--
+-- RETURNS: void.
+--
+-- NOTES:
+-- This function is called by the socket functions for attached logs, and may be called directly to
+-- record traffic that did not go through them, such as messages on a shared memory localChannel.
+----------------------------------------------------------------------------------------------------------------------*/
+void capturePacket(struct captureLog *log, int32_t socketDescriptor, int32_t direction, struct destination *peer, const char *data, int64_t dataLength)
+{
+  struct captureRecord *record;
+  uint64_t recordSize;
+  uint64_t offset;
+
+  if (dataLength < 0 || (uint64_t)dataLength > UINT32_MAX)
+  {
+    return;
+  }
+
+  recordSize = sizeof(struct captureRecord) + (((uint64_t)dataLength + 7) & ~7ULL);
+  offset = atomic_fetch_add_explicit(&log->header->used, recordSize, memory_order_relaxed);
+  if (offset + recordSize > log->capacity)
+  {
+    atomic_fetch_add_explicit(&log->header->dropped, 1, memory_order_relaxed);
+    return;
+  }
+
+  record = (struct captureRecord *)(log->base + sizeof(struct captureHeader) + offset);
+  record->length = dataLength;
+  record->timestamp = clockNanoseconds(CLOCK_MONOTONIC);
+  record->address = peer == 0 ? 0 : peer->address;
+  record->port = peer == 0 ? 0 : peer->port;
+  record->direction = direction;
+  record->socketDescriptor = socketDescriptor;
+  memcpy((char *)record + sizeof(struct captureRecord), data, dataLength);
+  atomic_store_explicit(&record->recordSize, recordSize, memory_order_release);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: getCaptureStats
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: void getCaptureStats(struct captureLog * log, struct captureStats * stats)
+--                struct captureLog * log: The log to read
+--                struct captureStats * stats: Filled with the records written, the bytes they use and the
+--                                             number dropped because the log was full
+--
+-- RETURNS: void.
+--
+-- NOTES:
+-- Records are counted by walking the log, so this is meant for reporting rather than the hot path.
+----------------------------------------------------------------------------------------------------------------------*/
+void getCaptureStats(struct captureLog *log, struct captureStats *stats)
+{
+  struct captureRecord *record;
+  uint64_t used = atomic_load(&log->header->used);
+  uint64_t offset = 0;
+  uint32_t recordSize;
+
+  used = used > log->capacity ? log->capacity : used;
+  stats->records = 0;
+  while (offset + sizeof(struct captureRecord) <= used)
+  {
+    record = (struct captureRecord *)(log->base + sizeof(struct captureHeader) + offset);
+    if ((recordSize = atomic_load_explicit(&record->recordSize, memory_order_acquire)) == 0)
+    {
+      break;
+    }
+    stats->records++;
+    offset += recordSize;
+  }
+  stats->bytes = offset;
+  stats->dropped = atomic_load(&log->header->dropped);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: closeCapture
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS: October 18, 2026
+--              -Refuses to close a log that is still attached
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int closeCapture(struct captureLog * log)
+--                struct captureLog * log: The log to close
+--
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used to finish a log. The file is cut down to the space actually used and the log is
+-- freed. A log still attached to a socket is left open and lastSocketError is set to ERR_ILLEGALOP, since
+-- the socket could still be writing into it; close or detach every socket first.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t closeCapture(struct captureLog *log)
+{
+  uint64_t used;
+  int32_t result = 1;
+
+  if (log == 0)
+  {
+    return 0;
+  }
+  if (atomic_load(&log->attachedSockets) != 0)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > capture log is still attached to a socket", lastSocketError);
+    return 0;
+  }
+
+  used = atomic_load(&log->header->used);
+  used = used > log->capacity ? log->capacity : used;
+  munmap(log->base, sizeof(struct captureHeader) + log->capacity);
+  if (ftruncate(log->fileDescriptor, sizeof(struct captureHeader) + used) == -1)
+  {
+    lastSocketError = ERR_UNKNOWN;
+    logger("ERROR > unable to trim capture file", lastSocketError);
+    result = 0;
+  }
+  close(log->fileDescriptor);
+  free(log);
+  return result;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: openCaptureReader
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: struct captureReader * openCaptureReader(const char * path)
+--                const char * path: A file written by openCapture
+--
+-- RETURNS: On success a reader positioned at the first record is returned. On error a null pointer is
+--          returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used to open a log for reading. The file is mapped read only, so a log that is still
+-- being written can be read up to its last published record.
+----------------------------------------------------------------------------------------------------------------------*/
+struct captureReader *openCaptureReader(const char *path)
+{
+  struct captureReader *reader;
+  struct stat fileStatus;
+  int32_t fileDescriptor;
+
+  if (path == 0)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid path passed to openCaptureReader", lastSocketError);
+    return 0;
+  }
+  if ((reader = calloc(1, sizeof(struct captureReader))) == 0)
+  {
+    lastSocketError = ERR_NOMEMORY;
+    logger("ERROR > unable to allocate capture reader", lastSocketError);
+    return 0;
+  }
+  if ((fileDescriptor = open(path, O_RDONLY | O_CLOEXEC)) == -1)
+  {
+    lastSocketError = errno == EACCES || errno == EPERM ? ERR_PERMISSION : ERR_UNKNOWN;
+    logger("ERROR > unable to open capture file", lastSocketError);
+    free(reader);
+    return 0;
+  }
+  if (fstat(fileDescriptor, &fileStatus) == -1 || (uint64_t)fileStatus.st_size < sizeof(struct captureHeader) ||
+      (reader->base = mmap(0, fileStatus.st_size, PROT_READ, MAP_SHARED, fileDescriptor, 0)) == MAP_FAILED)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > unable to map capture file", lastSocketError);
+    close(fileDescriptor);
+    free(reader);
+    return 0;
+  }
+  close(fileDescriptor);
+
+  reader->size = fileStatus.st_size;
+  reader->header = (struct captureHeader *)reader->base;
+  if (memcmp(reader->header->magic, CAPTURE_MAGIC, sizeof(reader->header->magic)) != 0 ||
+      reader->header->version != CAPTURE_VERSION || reader->header->headerSize != sizeof(struct captureHeader))
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > file is not a capture log", lastSocketError);
+    munmap(reader->base, reader->size);
+    free(reader);
+    return 0;
+  }
+  return reader;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: nextCapturedPacket
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS: October 18, 2026
+--              -Treat record sizes that are not a multiple of 8 as damage, the next record would be misaligned
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int nextCapturedPacket(struct captureReader * reader, struct capturedPacket * packet)
+--                struct captureReader * reader: The reader to advance
+--                struct capturedPacket * packet: Filled with the next record
+--
+-- RETURNS: 1 if a record was read, 0 at the end of the log.
+--
+-- NOTES:
+-- This function is used to walk a log in the order it was written. packet->data points into the mapped
+-- file and stays valid until the reader is closed. A truncated or damaged record ends the log.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t nextCapturedPacket(struct captureReader *reader, struct capturedPacket *packet)
+{
+  const struct captureRecord *record;
+  uint64_t limit = reader->size - sizeof(struct captureHeader);
+  uint64_t used = atomic_load(&reader->header->used);
+  uint32_t recordSize;
+
+  limit = used < limit ? used : limit;
+  if (reader->offset + sizeof(struct captureRecord) > limit)
+  {
+    return 0;
+  }
+  record = (const struct captureRecord *)(reader->base + sizeof(struct captureHeader) + reader->offset);
+  recordSize = atomic_load_explicit(&record->recordSize, memory_order_acquire);
+  if (recordSize < sizeof(struct captureRecord) || recordSize % 8 != 0 || reader->offset + recordSize > limit ||
+      record->length > recordSize - sizeof(struct captureRecord))
+  {
+    return 0;
+  }
+
+  packet->timestamp = record->timestamp;
+  packet->peer.address = record->address;
+  packet->peer.port = record->port;
+  packet->direction = record->direction;
+  packet->socketDescriptor = record->socketDescriptor;
+  packet->data = (const char *)record + sizeof(struct captureRecord);
+  packet->dataLength = record->length;
+  reader->offset += recordSize;
+  return 1;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: rewindCaptureReader
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: void rewindCaptureReader(struct captureReader * reader)
+--                struct captureReader * reader: The reader to move back to the first record
+--
+-- RETURNS: void.
+----------------------------------------------------------------------------------------------------------------------*/
+void rewindCaptureReader(struct captureReader *reader)
+{
+  reader->offset = 0;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: closeCaptureReader
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: void closeCaptureReader(struct captureReader * reader)
+--                struct captureReader * reader: The reader to close
+--
+-- RETURNS: void.
+----------------------------------------------------------------------------------------------------------------------*/
+void closeCaptureReader(struct captureReader *reader)
+{
+  if (reader == 0)
+  {
+    return;
+  }
+  munmap(reader->base, reader->size);
+  free(reader);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: replayCapture
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int64_t replayCapture(struct captureReader * reader, struct socketStruct * socketPointer,
+--                                  struct destination * target, int32_t directions, double speed)
+--                struct captureReader * reader: The log to replay, from its current position
+--                struct socketStruct * socketPointer: The socket to send from. A UDP socket for datagrams,
+--                                                     a connected TCP socket for CAPTURE_TCP records
+--                struct destination * target: Where to send datagrams, or null to send each one to the
+--                                             peer it was recorded with
+--                int32_t directions: CAPTURE_SEND, CAPTURE_RECV or both, the records to replay
+--                double speed: 1 for the original timing, 2 for twice as fast, or 0 to send without pauses
+--
+-- RETURNS: The number of records sent, or -1 if a send failed, with lastSocketError set appropriately.
+--
+-- NOTES:
+-- This function is used to feed recorded traffic back to a server. To reproduce what a server received,
+-- replay its CAPTURE_RECV records at the server's address. Timing is kept relative to the first replayed
+-- record, so how long the capture ran before it does not matter.
+----------------------------------------------------------------------------------------------------------------------*/
+int64_t replayCapture(struct captureReader *reader, struct socketStruct *socketPointer, struct destination *target, int32_t directions, double speed)
+{
+  struct capturedPacket packet;
+  struct timespec due;
+  int64_t firstTimestamp = -1;
+  int64_t startTime = 0;
+  int64_t dueTime;
+  int64_t replayed = 0;
+  int32_t result;
+
+  if (reader == 0 || socketPointer == 0)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid reader or socket passed to replayCapture", lastSocketError);
+    return -1;
+  }
+
+  while (nextCapturedPacket(reader, &packet))
+  {
+    if (!(packet.direction & directions))
+    {
+      continue;
+    }
+
+    if (firstTimestamp < 0)
+    {
+      firstTimestamp = packet.timestamp;
+      startTime = clockNanoseconds(CLOCK_MONOTONIC);
+    }
+    else if (speed > 0)
+    {
+      dueTime = startTime + (int64_t)((packet.timestamp - firstTimestamp) / speed);
+      due.tv_sec = dueTime / 1000000000;
+      due.tv_nsec = dueTime % 1000000000;
+      while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, 0) == EINTR)
+      {
+      }
+    }
+
+    if (packet.direction & CAPTURE_TCP)
+    {
+      result = sendDataTCP(socketPointer, packet.data, packet.dataLength);
+    }
+    else
+    {
+      result = sendData(socketPointer, target != 0 ? target : &packet.peer, packet.data, packet.dataLength);
+    }
+    if (!result)
+    {
+      return -1;
+    }
+    replayed++;
+  }
+  return replayed;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: clockNanoseconds
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static int64_t clockNanoseconds(clockid_t clock)
+--                clockid_t clock: The clock to read
+--
+-- RETURNS: The time of clock in nanoseconds.
+----------------------------------------------------------------------------------------------------------------------*/
+static int64_t clockNanoseconds(clockid_t clock)
+{
+  struct timespec now;
+
+  clock_gettime(clock, &now);
+  return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: registerCaptureHooks
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static void registerCaptureHooks()
+--
+-- RETURNS: void.
+--
+-- NOTES:
+-- Run once by the first attachCapture, before any log is published in the hook table. socket.c reaches
+-- capturePacket and detachCapture only through hookFunctions, so it links without capture.c, as in the
+-- macOS bundle.
+----------------------------------------------------------------------------------------------------------------------*/
+static void registerCaptureHooks()
+{
+  hookFunctions.capturePacket = capturePacket;
+  hookFunctions.detachCapture = detachCapture;
+}
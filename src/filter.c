@@ -0,0 +1,567 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: filter.c - Drops malformed, unauthenticated and flooding datagrams before they reach game logic.
+--
+--
+-- PROGRAM: libsocket
+--
+-- FUNCTIONS:
+-- struct packetFilter * createPacketFilter(struct filterConfig * config)
+-- int checkPacket(struct packetFilter * filter, struct destination * source, const char * data,
+--                 int32_t dataLength)
+-- uint64_t makeCookie(struct packetFilter * filter, struct destination * source)
+-- void writeFilterHeader(char * dataBuffer, uint32_t magic, uint8_t version, uint8_t flags, uint64_t cookie)
+-- int recvDataFiltered(struct socketStruct * socketPointer, struct packetFilter * filter,
+--                      struct destination * dest, char * dataBuffer, size_t dataBufferSize)
+-- int attachFilterBPF(struct socketStruct * socketPointer, struct packetFilter * filter)
+-- void getFilterStats(struct packetFilter * filter, struct filterStats * stats)
+-- void freePacketFilter(struct packetFilter * filter)
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- NOTES:
+-- Every datagram the filter accepts starts with a FILTER_HEADER_SIZE byte header, all fields in network
+-- byte order:
+--     bytes 0-3   magic, identifies the protocol
+--     byte  4     protocol version
+--     byte  5     flags, FILTER_PACKET_HELLO marks a handshake packet that has no cookie yet
+--     bytes 6-7   reserved
+--     bytes 8-15  cookie
+--
+-- The checks run from cheapest to most expensive: length, magic and version, then the cookie, then the
+-- per-source rate limit. A cookie is a SipHash-2-4 of the client address, port and the current cookie
+-- epoch under a secret key. The server hands it to the client during the handshake with makeCookie, and
+-- the client echoes it in every later packet, so spoofed or replayed traffic is rejected with no per-client
+-- state. Cookies from the previous epoch are still accepted so a client never loses one mid-session.
+--
+-- The rate limiter keeps a token bucket per source address in a fixed table of FILTER_SET_WAYS way sets,
+-- one cache line per set. A new address evicts the least recently refilled entry of its set, so the table
+-- never grows or allocates. Nothing in the receive path allocates. A filter is not thread safe; give
+-- each receive thread its own.
+----------------------------------------------------------------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include "include/filter.h"
+#include "include/internal.h"
+
+#define ROTATE(value, bits) (((value) << (bits)) | ((value) >> (64 - (bits))))
+#define SIPROUND(v0, v1, v2, v3)                                          \
+  do                                                                      \
+  {                                                                       \
+    v0 += v1; v1 = ROTATE(v1, 13); v1 ^= v0; v0 = ROTATE(v0, 32);         \
+    v2 += v3; v3 = ROTATE(v3, 16); v3 ^= v2;                              \
+    v0 += v3; v3 = ROTATE(v3, 21); v3 ^= v0;                              \
+    v2 += v1; v1 = ROTATE(v1, 17); v1 ^= v2; v2 = ROTATE(v2, 32);         \
+  } while (0)
+
+static uint64_t cookieHash(struct packetFilter *filter, struct destination *source, int64_t epoch);
+static int32_t allowSource(struct packetFilter *filter, uint32_t address, int64_t now);
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: createPacketFilter
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS: October 18, 2026
+--              -Rejects rateTableSets above FILTER_MAX_SETS instead of rounding it up forever
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: struct packetFilter * createPacketFilter(struct filterConfig * config)
+--                struct filterConfig * config: The checks to apply. config->key is generated randomly
+--                                              if left all zero. packetsPerSecond 0 turns rate limiting
+--                                              off, burst 0 allows one second of packets at once, and
+--                                              cookieLifetimeMicroseconds and rateTableSets 0 use the
+--                                              defaults. rateTableSets is rounded up to a power of two
+--                                              and may not exceed FILTER_MAX_SETS.
+--
+-- RETURNS: On success a filter is returned. On error a null pointer is returned and lastSocketError is set
+--          appropriately.
+--
+-- NOTES:
+-- This function is used to create a filter. The rate table is allocated here, once.
+----------------------------------------------------------------------------------------------------------------------*/
+struct packetFilter *createPacketFilter(struct filterConfig *config)
+{
+  struct packetFilter *filter;
+  uint8_t emptyKey[FILTER_KEY_SIZE];
+  uint32_t sets = 1;
+
+  // Rounding a count above 2^31 up to a power of two would shift sets to zero and never finish
+  if (config == 0 || config->minVersion > config->maxVersion || config->rateTableSets > FILTER_MAX_SETS)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid config passed to createPacketFilter", lastSocketError);
+    return 0;
+  }
+  if ((filter = calloc(1, sizeof(struct packetFilter))) == 0)
+  {
+    lastSocketError = ERR_NOMEMORY;
+    logger("ERROR > unable to allocate packet filter", lastSocketError);
+    return 0;
+  }
+
+  filter->config = *config;
+  if (filter->config.cookieLifetimeMicroseconds <= 0)
+  {
+    filter->config.cookieLifetimeMicroseconds = FILTER_DEFAULT_LIFETIME;
+  }
+  memset(emptyKey, 0, sizeof(emptyKey));
+  if (memcmp(filter->config.key, emptyKey, FILTER_KEY_SIZE) == 0 &&
+      getrandom(filter->config.key, FILTER_KEY_SIZE, 0) != FILTER_KEY_SIZE)
+  {
+    lastSocketError = ERR_UNKNOWN;
+    logger("ERROR > unable to generate packet filter key", lastSocketError);
+    free(filter);
+    return 0;
+  }
+  memcpy(filter->keyWords, filter->config.key, FILTER_KEY_SIZE);
+
+  if (filter->config.packetsPerSecond > 0)
+  {
+    if (filter->config.burst == 0)
+    {
+      filter->config.burst = filter->config.packetsPerSecond;
+    }
+    // Tokens are kept in thousandths of a packet in 32 bits
+    if (filter->config.burst > UINT32_MAX / 1000)
+    {
+      filter->config.burst = UINT32_MAX / 1000;
+    }
+    while (sets < (filter->config.rateTableSets == 0 ? FILTER_DEFAULT_SETS : filter->config.rateTableSets))
+    {
+      sets <<= 1;
+    }
+    filter->config.rateTableSets = sets;
+    if (getrandom(&filter->rateSeed, sizeof(filter->rateSeed), 0) != sizeof(filter->rateSeed) ||
+        (filter->rateTable = aligned_alloc(sizeof(struct rateSet), sets * sizeof(struct rateSet))) == 0)
+    {
+      lastSocketError = ERR_NOMEMORY;
+      logger("ERROR > unable to allocate rate table", lastSocketError);
+      free(filter);
+      return 0;
+    }
+    memset(filter->rateTable, 0, sets * sizeof(struct rateSet));
+  }
+
+  return filter;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: checkPacket
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int checkPacket(struct packetFilter * filter, struct destination * source, const char * data,
+--                            int32_t dataLength)
+--                struct packetFilter * filter: The filter to check against
+--                struct destination * source: The address and port the datagram came from
+--                const char * data: The datagram, starting with the filter header
+--                int32_t dataLength: The length of the datagram
+--
+-- RETURNS: FILTER_PASS if the datagram should be handled, otherwise the FILTER_ code of the first check it
+--          failed.
+--
+-- NOTES:
+-- This function is used to run the checks on a datagram that was received some other way, such as
+-- recvDataBatch or recvDataRing. The result is counted in the filter stats.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t checkPacket(struct packetFilter *filter, struct destination *source, const char *data, int32_t dataLength)
+{
+  const uint8_t *header = (const uint8_t *)data;
+  uint32_t magic;
+  uint64_t cookie;
+  uint64_t epoch;
+  int64_t now;
+
+  if (dataLength < FILTER_HEADER_SIZE)
+  {
+    filter->stats.shortPackets++;
+    return FILTER_SHORT;
+  }
+  memcpy(&magic, header, sizeof(magic));
+  if (ntohl(magic) != filter->config.magic)
+  {
+    filter->stats.badMagic++;
+    return FILTER_MAGIC;
+  }
+  if (header[4] < filter->config.minVersion || header[4] > filter->config.maxVersion)
+  {
+    filter->stats.badVersion++;
+    return FILTER_VERSION;
+  }
+
+  now = monotonicMicroseconds();
+  if (filter->config.requireCookie && !(header[5] & FILTER_PACKET_HELLO))
+  {
+    memcpy(&cookie, header + 8, sizeof(cookie));
+    cookie = be64toh(cookie);
+    epoch = now / filter->config.cookieLifetimeMicroseconds;
+    if (cookie != cookieHash(filter, source, epoch) && cookie != cookieHash(filter, source, epoch - 1))
+    {
+      filter->stats.badCookie++;
+      return FILTER_COOKIE;
+    }
+  }
+  if (filter->rateTable != 0 && !allowSource(filter, source->address, now))
+  {
+    filter->stats.rateLimited++;
+    return FILTER_RATE;
+  }
+
+  filter->stats.passed++;
+  return FILTER_PASS;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: makeCookie
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: uint64_t makeCookie(struct packetFilter * filter, struct destination * source)
+--                struct packetFilter * filter: The filter that will check the cookie
+--                struct destination * source: The address and port of the client
+--
+-- RETURNS: The cookie the client must put in its filter header.
+--
+-- NOTES:
+-- This function is used by a server to answer a hello packet. The cookie stays valid for one to two
+-- cookie lifetimes; a client should ask for a new one when its packets stop getting through.
+----------------------------------------------------------------------------------------------------------------------*/
+uint64_t makeCookie(struct packetFilter *filter, struct destination *source)
+{
+  return cookieHash(filter, source, monotonicMicroseconds() / filter->config.cookieLifetimeMicroseconds);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: writeFilterHeader
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: void writeFilterHeader(char * dataBuffer, uint32_t magic, uint8_t version, uint8_t flags,
+--                                   uint64_t cookie)
+--                char * dataBuffer: At least FILTER_HEADER_SIZE bytes to write the header into
+--                uint32_t magic: The protocol magic
+--                uint8_t version: The protocol version
+--                uint8_t flags: FILTER_PACKET_ flags
+--                uint64_t cookie: The cookie from the server, or 0 in a hello packet
+--
+-- RETURNS: void.
+--
+-- NOTES:
+-- This function is used by the sender to build the header the filter expects.
+----------------------------------------------------------------------------------------------------------------------*/
+void writeFilterHeader(char *dataBuffer, uint32_t magic, uint8_t version, uint8_t flags, uint64_t cookie)
+{
+  magic = htonl(magic);
+  cookie = htobe64(cookie);
+  memcpy(dataBuffer, &magic, sizeof(magic));
+  dataBuffer[4] = version;
+  dataBuffer[5] = flags;
+  dataBuffer[6] = 0;
+  dataBuffer[7] = 0;
+  memcpy(dataBuffer + 8, &cookie, sizeof(cookie));
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: recvDataFiltered
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int recvDataFiltered(struct socketStruct * socketPointer, struct packetFilter * filter,
+--                                 struct destination * dest, char * dataBuffer, size_t dataBufferSize)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct to read from
+--                struct packetFilter * filter: The filter to apply
+--                struct destination * dest: Filled with the address and port the datagram came from
+--                char * dataBuffer: An array for the datagram, including its filter header
+--                size_t dataBufferSize: The size of dataBuffer
+--
+-- RETURNS: The length of the first datagram that passes the filter, or -1 on error as recvData.
+--
+-- NOTES:
+-- This function is used in place of recvData. Rejected datagrams are dropped and counted, and the call
+-- keeps waiting. A timeout attached to the socket still applies to each datagram.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t recvDataFiltered(struct socketStruct *socketPointer, struct packetFilter *filter, struct destination *dest, char *dataBuffer, size_t dataBufferSize)
+{
+  int32_t bytesReceived;
+
+  if (filter == 0)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid filter passed to recvDataFiltered", lastSocketError);
+    return -1;
+  }
+
+  for (;;)
+  {
+    if ((bytesReceived = recvData(socketPointer, dest, dataBuffer, dataBufferSize)) < 0)
+    {
+      return bytesReceived;
+    }
+    if (checkPacket(filter, dest, dataBuffer, bytesReceived) == FILTER_PASS)
+    {
+      return bytesReceived;
+    }
+  }
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: attachFilterBPF
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int attachFilterBPF(struct socketStruct * socketPointer, struct packetFilter * filter)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct of a UDP socket
+--                struct packetFilter * filter: The filter whose checks should run in the kernel
+--
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used to have the kernel drop datagrams that are too short or have the wrong magic or
+-- version, before they are queued on the socket. Cookies and rate limits need the key and the table, so
+-- they stay in user space. Datagrams dropped in the kernel are not counted in the filter stats.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t attachFilterBPF(struct socketStruct *socketPointer, struct packetFilter *filter)
+{
+  // A UDP socket filter sees the datagram from the UDP header on
+  struct sock_filter instructions[] = {
+      BPF_STMT(BPF_LD | BPF_W | BPF_LEN, 0),
+      BPF_JUMP(BPF_JMP | BPF_JGE | BPF_K, sizeof(struct udphdr) + FILTER_HEADER_SIZE, 0, 6),
+      BPF_STMT(BPF_LD | BPF_W | BPF_ABS, sizeof(struct udphdr)),
+      BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, filter->config.magic, 0, 4),
+      BPF_STMT(BPF_LD | BPF_B | BPF_ABS, sizeof(struct udphdr) + 4),
+      BPF_JUMP(BPF_JMP | BPF_JGE | BPF_K, filter->config.minVersion, 0, 2),
+      BPF_JUMP(BPF_JMP | BPF_JGT | BPF_K, filter->config.maxVersion, 1, 0),
+      BPF_STMT(BPF_RET | BPF_K, 0xFFFFFFFF),
+      BPF_STMT(BPF_RET | BPF_K, 0),
+  };
+  struct sock_fprog program;
+
+  if (socketPointer == 0)
+  {
+    logger("ERROR > invalid socket passed to attachFilterBPF", -1);
+    return 0;
+  }
+
+  program.len = sizeof(instructions) / sizeof(instructions[0]);
+  program.filter = instructions;
+  if (setsockopt(socketPointer->socketDescriptor, SOL_SOCKET, SO_ATTACH_FILTER, &program, sizeof(program)) == -1)
+  {
+    lastSocketError = errno == ENOMEM ? ERR_NOMEMORY : ERR_ILLEGALOP;
+    logger("ERROR > unable to attach filter to socket", lastSocketError);
+    return 0;
+  }
+  return 1;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: getFilterStats
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: void getFilterStats(struct packetFilter * filter, struct filterStats * stats)
+--                struct packetFilter * filter: The filter to read
+--                struct filterStats * stats: Filled with the number of datagrams passed and rejected
+--
+-- RETURNS: void.
+----------------------------------------------------------------------------------------------------------------------*/
+void getFilterStats(struct packetFilter *filter, struct filterStats *stats)
+{
+  *stats = filter->stats;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: freePacketFilter
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: void freePacketFilter(struct packetFilter * filter)
+--                struct packetFilter * filter: The filter to free
+--
+-- RETURNS: void.
+--
+-- NOTES:
+-- The key is cleared before the memory is released.
+----------------------------------------------------------------------------------------------------------------------*/
+void freePacketFilter(struct packetFilter *filter)
+{
+  if (filter == 0)
+  {
+    return;
+  }
+  explicit_bzero(filter->config.key, FILTER_KEY_SIZE);
+  explicit_bzero(filter->keyWords, sizeof(filter->keyWords));
+  free(filter->rateTable);
+  free(filter);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: cookieHash
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static uint64_t cookieHash(struct packetFilter * filter, struct destination * source,
+--                                       int64_t epoch)
+--                struct packetFilter * filter: The filter holding the key
+--                struct destination * source: The address and port of the client
+--                int64_t epoch: The cookie epoch
+--
+-- RETURNS: SipHash-2-4 of the address, port and epoch.
+--
+-- NOTES:
+-- The input is always the same 16 bytes, so the message words are built directly instead of running the
+-- general byte loop.
+----------------------------------------------------------------------------------------------------------------------*/
+static uint64_t cookieHash(struct packetFilter *filter, struct destination *source, int64_t epoch)
+{
+  uint64_t v0 = filter->keyWords[0] ^ 0x736f6d6570736575ULL;
+  uint64_t v1 = filter->keyWords[1] ^ 0x646f72616e646f6dULL;
+  uint64_t v2 = filter->keyWords[0] ^ 0x6c7967656e657261ULL;
+  uint64_t v3 = filter->keyWords[1] ^ 0x7465646279746573ULL;
+  uint64_t words[3];
+  int32_t i;
+
+  words[0] = (uint64_t)source->address | (uint64_t)source->port << 32;
+  words[1] = (uint64_t)epoch;
+  words[2] = (uint64_t)16 << 56;
+
+  for (i = 0; i < 3; i++)
+  {
+    v3 ^= words[i];
+    SIPROUND(v0, v1, v2, v3);
+    SIPROUND(v0, v1, v2, v3);
+    v0 ^= words[i];
+  }
+  v2 ^= 0xFF;
+  SIPROUND(v0, v1, v2, v3);
+  SIPROUND(v0, v1, v2, v3);
+  SIPROUND(v0, v1, v2, v3);
+  SIPROUND(v0, v1, v2, v3);
+  return v0 ^ v1 ^ v2 ^ v3;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: allowSource
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static int allowSource(struct packetFilter * filter, uint32_t address, int64_t now)
+--                struct packetFilter * filter: The filter holding the rate table
+--                uint32_t address: The source address, in network byte order
+--                int64_t now: The current monotonic time in microseconds
+--
+-- RETURNS: 1 if the source still has a token, otherwise 0.
+--
+-- NOTES:
+-- The set is picked with a seeded multiplicative hash so an attacker cannot aim many addresses at one set.
+-- Only the one cache line holding the set is touched.
+----------------------------------------------------------------------------------------------------------------------*/
+static int32_t allowSource(struct packetFilter *filter, uint32_t address, int64_t now)
+{
+  struct rateSet *set;
+  struct rateEntry *entry;
+  uint64_t tokens;
+  uint64_t limit = (uint64_t)filter->config.burst * 1000;
+  int64_t elapsed;
+  int32_t i;
+
+  set = &filter->rateTable[(((address ^ filter->rateSeed) * 0x9E3779B97F4A7C15ULL) >> 32) & (filter->config.rateTableSets - 1)];
+  entry = &set->ways[0];
+  for (i = 0; i < FILTER_SET_WAYS; i++)
+  {
+    if (set->ways[i].address == address && set->ways[i].lastRefill != 0)
+    {
+      entry = &set->ways[i];
+      break;
+    }
+    if (set->ways[i].lastRefill < entry->lastRefill)
+    {
+      entry = &set->ways[i];
+    }
+  }
+
+  if (i == FILTER_SET_WAYS)
+  {
+    entry->address = address;
+    entry->milliTokens = limit - 1000;
+    entry->lastRefill = now;
+    return 1;
+  }
+
+  // Capping the gap keeps the product in 64 bits, the bucket is long full by then
+  elapsed = now - entry->lastRefill;
+  elapsed = elapsed > 1000000000 ? 1000000000 : elapsed;
+  tokens = entry->milliTokens + (uint64_t)elapsed * filter->config.packetsPerSecond / 1000;
+  tokens = tokens > limit ? limit : tokens;
+  entry->lastRefill = now;
+  if (tokens < 1000)
+  {
+    entry->milliTokens = tokens;
+    return 0;
+  }
+  entry->milliTokens = tokens - 1000;
+  return 1;
+}
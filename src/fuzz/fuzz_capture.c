@@ -0,0 +1,88 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: fuzz_capture.c - Fuzz target for the capture log reader.
+--
+--
+-- PROGRAM: fuzz_capture
+--
+-- FUNCTIONS:
+-- int LLVMFuzzerTestOneInput(const uint8_t * data, size_t size)
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- NOTES:
+-- Built with "make fuzz". Capture files may be truncated or damaged, so the reader must never step outside
+-- the mapping. Inputs starting with the capture magic are used as the whole file. Any other input is given
+-- a valid header and its first 8 bytes become the used size, so the fuzzer spends its time on the records.
+-- The file lives in a memfd and is opened through /proc like any other path.
+----------------------------------------------------------------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include "../include/capture.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+  struct captureHeader header;
+  struct captureReader *reader;
+  struct capturedPacket packet;
+  char path[64];
+  int32_t fileDescriptor;
+  uint64_t used;
+  volatile char sink;
+  uint32_t i;
+
+  if ((fileDescriptor = memfd_create("fuzz_capture", MFD_CLOEXEC)) == -1)
+  {
+    return 0;
+  }
+  if (size >= sizeof(CAPTURE_MAGIC) - 1 && memcmp(data, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC) - 1) == 0)
+  {
+    if (write(fileDescriptor, data, size) != (ssize_t)size)
+    {
+      close(fileDescriptor);
+      return 0;
+    }
+  }
+  else
+  {
+    if (size < sizeof(used))
+    {
+      close(fileDescriptor);
+      return 0;
+    }
+    memcpy(&used, data, sizeof(used));
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CAPTURE_MAGIC, sizeof(header.magic));
+    header.version = CAPTURE_VERSION;
+    header.headerSize = sizeof(struct captureHeader);
+    atomic_store(&header.used, used);
+    if (write(fileDescriptor, &header, sizeof(header)) != sizeof(header) ||
+        write(fileDescriptor, data + sizeof(used), size - sizeof(used)) != (ssize_t)(size - sizeof(used)))
+    {
+      close(fileDescriptor);
+      return 0;
+    }
+  }
+
+  snprintf(path, sizeof(path), "/proc/self/fd/%d", fileDescriptor);
+  if ((reader = openCaptureReader(path)) != 0)
+  {
+    while (nextCapturedPacket(reader, &packet))
+    {
+      for (i = 0; i < packet.dataLength; i++)
+      {
+        sink = packet.data[i];
+      }
+    }
+    (void)sink;
+    closeCaptureReader(reader);
+  }
+  close(fileDescriptor);
+  return 0;
+}
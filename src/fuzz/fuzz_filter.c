@@ -0,0 +1,67 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: fuzz_filter.c - Fuzz target for the packet filter header parser.
+--
+--
+-- PROGRAM: fuzz_filter
+--
+-- FUNCTIONS:
+-- int LLVMFuzzerTestOneInput(const uint8_t * data, size_t size)
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- NOTES:
+-- Built with "make fuzz". The first 6 bytes of the input choose the source address and port and the rest
+-- is the datagram given to checkPacket. Every so often a datagram is stamped with the cookie the filter
+-- expects, so the accept path and the rate limiter are reached as well as the rejections.
+----------------------------------------------------------------------------------------------------------------------*/
+
+#include "../include/filter.h"
+
+static struct packetFilter *filter;
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+  struct filterConfig config;
+  struct destination source;
+  char datagram[2048];
+  int32_t result;
+
+  if (filter == 0)
+  {
+    memset(&config, 0, sizeof(config));
+    config.magic = 0x4C534B54;
+    config.minVersion = 1;
+    config.maxVersion = 2;
+    config.requireCookie = 1;
+    memset(config.key, 0x5A, sizeof(config.key));
+    config.packetsPerSecond = 1000;
+    config.burst = 16;
+    config.rateTableSets = 4;
+    filter = createPacketFilter(&config);
+  }
+  if (size < 6 || size - 6 > sizeof(datagram))
+  {
+    return 0;
+  }
+
+  memcpy(&source.address, data, sizeof(source.address));
+  memcpy(&source.port, data + 4, sizeof(source.port));
+  memcpy(datagram, data + 6, size - 6);
+  if (size - 6 >= FILTER_HEADER_SIZE && (data[0] & 0x0F) == 0)
+  {
+    writeFilterHeader(datagram, 0x4C534B54, data[1], data[2], makeCookie(filter, &source));
+  }
+
+  result = checkPacket(filter, &source, datagram, size - 6);
+  if (result < FILTER_PASS || result > FILTER_RATE)
+  {
+    __builtin_trap();
+  }
+  return 0;
+}
@@ -0,0 +1,58 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: standalone.c - Runs a fuzz target over saved inputs without libFuzzer.
+--
+--
+-- PROGRAM: fuzz
+--
+-- FUNCTIONS:
+-- int main(int argc, char ** argv)
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- NOTES:
+-- Linked in place of libFuzzer with "make fuzz FUZZ_CC=gcc FUZZ_ENGINE=fuzz/standalone.c", so a corpus or
+-- crash file can be replayed under the sanitizers with compilers that have no libFuzzer. Each argument is
+-- a file to run once.
+----------------------------------------------------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+int main(int argc, char **argv)
+{
+  FILE *input;
+  uint8_t *data;
+  long size;
+  int i;
+
+  for (i = 1; i < argc; i++)
+  {
+    if ((input = fopen(argv[i], "rb")) == 0)
+    {
+      perror(argv[i]);
+      return 1;
+    }
+    fseek(input, 0, SEEK_END);
+    size = ftell(input);
+    fseek(input, 0, SEEK_SET);
+    if ((data = malloc(size > 0 ? size : 1)) == 0 || fread(data, 1, size, input) != (size_t)size)
+    {
+      fprintf(stderr, "%s: unable to read\n", argv[i]);
+      return 1;
+    }
+    fclose(input);
+    LLVMFuzzerTestOneInput(data, size);
+    free(data);
+    printf("%s: ok\n", argv[i]);
+  }
+  return 0;
+}
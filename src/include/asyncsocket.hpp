@@ -0,0 +1,725 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: asyncsocket.hpp - Header only C++20 coroutine interface to libsocket.
+--
+--
+-- PROGRAM: libsocket
+--
+-- CLASSES:
+-- libsocket::Task<T>      A lazily started coroutine returning T, awaitable from other coroutines
+-- libsocket::Reactor      An epoll event loop that resumes coroutines when their socket is ready
+-- libsocket::Socket       An owning handle that calls closeSocket and freeSocket when destroyed
+--
+-- FUNCTIONS:
+-- void spawn(Task<void> task)
+-- Task<int32_t> asyncRecv(Reactor& reactor, Socket& socket, destination& source, char* dataBuffer,
+--                         size_t dataBufferSize)
+-- Task<int32_t> asyncSend(Reactor& reactor, Socket& socket, const destination& dest, const char* data,
+--                         uint64_t dataLength)
+-- Task<int32_t> asyncRecvTCP(Reactor& reactor, Socket& socket, char* dataBuffer, int32_t packetSize)
+-- Task<int32_t> asyncSendTCP(Reactor& reactor, Socket& socket, const char* data, uint64_t dataLength)
+-- Task<Socket> asyncAccept(Reactor& reactor, Socket& listener)
+-- Task<int32_t> asyncConnect(Reactor& reactor, Socket& socket, const destination& dest)
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS: October 18, 2026
+--              -Awaiting a moved-from Task throws std::logic_error instead of using a null handle
+--              -asyncConnect maps errors with connectErrorCode from internal.h
+--              -asyncSendTCP sends through sendDataTCPTimeout instead of calling send itself
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- NOTES:
+-- Every async function first tries the operation without blocking through the C functions in socket.h.
+-- Only when the socket is not ready does the coroutine suspend, registering interest with the Reactor,
+-- and it retries once the Reactor reports readiness. Results and error reporting follow the matching C
+-- function, so getSocketError works as usual after a failed operation.
+--
+-- A Reactor is not thread safe: run one Reactor per thread and only await sockets on the thread that runs
+-- their Reactor. Sockets used with the async functions must be non-blocking, which Socket::udp, Socket::tcp,
+-- Socket::listener and asyncAccept take care of. A socket must not be destroyed while a coroutine is
+-- suspended on it. Requires Linux (epoll) and a C++20 compiler.
+----------------------------------------------------------------------------------------------------------------------*/
+
+#ifndef ASYNCSOCKET_HPP
+#define ASYNCSOCKET_HPP
+
+#include <coroutine>
+#include <exception>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+
+#include <sys/epoll.h>
+
+#include "socket.h"
+#include "internal.h"
+
+namespace libsocket
+{
+
+/*------------------------------------------------------------------------------------------------------------------
+-- CLASS: Task
+--
+-- NOTES:
+-- A coroutine that does not start until it is awaited. When it finishes it resumes the awaiting coroutine
+-- directly, so chains of tasks do not grow the stack. Exceptions propagate to the awaiting coroutine.
+-- Awaiting a Task that has been moved from throws std::logic_error.
+----------------------------------------------------------------------------------------------------------------------*/
+template <typename T = void>
+class Task;
+
+namespace detail
+{
+
+struct FinalAwaiter
+{
+  bool await_ready() const noexcept { return false; }
+  template <typename Promise>
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) const noexcept
+  {
+    std::coroutine_handle<> continuation = handle.promise().continuation;
+    return continuation ? continuation : std::noop_coroutine();
+  }
+  void await_resume() const noexcept {}
+};
+
+struct PromiseBase
+{
+  std::coroutine_handle<> continuation;
+  std::exception_ptr exception;
+
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+  FinalAwaiter final_suspend() const noexcept { return {}; }
+  void unhandled_exception() noexcept { exception = std::current_exception(); }
+};
+
+template <typename T>
+struct Promise : PromiseBase
+{
+  std::variant<std::monostate, T> value;
+
+  Task<T> get_return_object() noexcept;
+  template <typename U>
+  void return_value(U &&result) { value.template emplace<1>(std::forward<U>(result)); }
+  T take()
+  {
+    if (exception)
+    {
+      std::rethrow_exception(exception);
+    }
+    return std::move(std::get<1>(value));
+  }
+};
+
+template <>
+struct Promise<void> : PromiseBase
+{
+  Task<void> get_return_object() noexcept;
+  void return_void() const noexcept {}
+  void take()
+  {
+    if (exception)
+    {
+      std::rethrow_exception(exception);
+    }
+  }
+};
+
+} // namespace detail
+
+template <typename T>
+class Task
+{
+public:
+  using promise_type = detail::Promise<T>;
+
+  explicit Task(std::coroutine_handle<promise_type> handle) noexcept : handle(handle) {}
+  Task(Task &&other) noexcept : handle(std::exchange(other.handle, {})) {}
+  Task &operator=(Task &&other) noexcept
+  {
+    if (this != &other)
+    {
+      if (handle)
+      {
+        handle.destroy();
+      }
+      handle = std::exchange(other.handle, {});
+    }
+    return *this;
+  }
+  Task(const Task &) = delete;
+  Task &operator=(const Task &) = delete;
+  ~Task()
+  {
+    if (handle)
+    {
+      handle.destroy();
+    }
+  }
+
+  bool await_ready() const
+  {
+    if (!handle)
+    {
+      throw std::logic_error("awaited a Task that was moved from");
+    }
+    return handle.done();
+  }
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+  {
+    handle.promise().continuation = awaiting;
+    return handle;
+  }
+  T await_resume() { return handle.promise().take(); }
+
+private:
+  std::coroutine_handle<promise_type> handle;
+};
+
+namespace detail
+{
+
+template <typename T>
+Task<T> Promise<T>::get_return_object() noexcept
+{
+  return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object() noexcept
+{
+  return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+struct Detached
+{
+  struct promise_type
+  {
+    Detached get_return_object() const noexcept { return {}; }
+    std::suspend_never initial_suspend() const noexcept { return {}; }
+    std::suspend_never final_suspend() const noexcept { return {}; }
+    void return_void() const noexcept {}
+    void unhandled_exception() const noexcept { std::terminate(); }
+  };
+};
+
+} // namespace detail
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: spawn
+--
+-- INTERFACE: void spawn(Task<void> task)
+--                Task<void> task: The task to run
+--
+-- NOTES:
+-- Starts a task that nothing awaits, such as one client session. The task runs until its first suspension
+-- before spawn returns and frees itself when it finishes. An exception escaping the task terminates the
+-- program.
+----------------------------------------------------------------------------------------------------------------------*/
+inline detail::Detached spawn(Task<void> task)
+{
+  co_await std::move(task);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- CLASS: Reactor
+--
+-- NOTES:
+-- Waits on an epoll descriptor and resumes the coroutines waiting for each ready socket. Each socket may
+-- have one coroutine waiting to read and one waiting to write at a time. Registrations are one-shot, so a
+-- socket costs nothing once no coroutine is waiting on it.
+----------------------------------------------------------------------------------------------------------------------*/
+class Reactor
+{
+public:
+  class ReadinessAwaiter
+  {
+  public:
+    ReadinessAwaiter(Reactor &reactor, int32_t socketDescriptor, uint32_t events) noexcept
+        : reactor(reactor), socketDescriptor(socketDescriptor), events(events) {}
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> handle) { return reactor.wait(socketDescriptor, events, handle); }
+    void await_resume() const noexcept {}
+
+  private:
+    Reactor &reactor;
+    int32_t socketDescriptor;
+    uint32_t events;
+  };
+
+  Reactor() : epollDescriptor(epoll_create1(EPOLL_CLOEXEC)), running(false) {}
+  Reactor(const Reactor &) = delete;
+  Reactor &operator=(const Reactor &) = delete;
+  ~Reactor()
+  {
+    if (epollDescriptor != -1)
+    {
+      close(epollDescriptor);
+    }
+  }
+
+  bool valid() const noexcept { return epollDescriptor != -1; }
+
+  ReadinessAwaiter readable(int32_t socketDescriptor) noexcept { return {*this, socketDescriptor, EPOLLIN}; }
+  ReadinessAwaiter writable(int32_t socketDescriptor) noexcept { return {*this, socketDescriptor, EPOLLOUT}; }
+
+  /*--------------------------------------------------------------------------------------------------------------
+  -- FUNCTION: run
+  --
+  -- NOTES:
+  -- Dispatches events until stop is called or no coroutine is waiting on any socket.
+  --------------------------------------------------------------------------------------------------------------*/
+  void run()
+  {
+    running = true;
+    while (running && !waiters.empty())
+    {
+      runOnce(-1);
+    }
+    running = false;
+  }
+
+  /*--------------------------------------------------------------------------------------------------------------
+  -- FUNCTION: runOnce
+  --
+  -- INTERFACE: int runOnce(int timeoutMilliseconds)
+  --                int timeoutMilliseconds: The longest time to wait for an event, -1 to wait indefinitely
+  --
+  -- RETURNS: The number of coroutines resumed, or -1 if epoll_wait failed.
+  --
+  -- NOTES:
+  -- Waits once for socket events and resumes the coroutines waiting on them. Lets a game loop poll the
+  -- reactor between its own work.
+  --------------------------------------------------------------------------------------------------------------*/
+  int32_t runOnce(int32_t timeoutMilliseconds)
+  {
+    epoll_event events[64];
+    std::coroutine_handle<> ready[128];
+    int32_t readyCount = 0;
+    int32_t eventCount;
+
+    if ((eventCount = epoll_wait(epollDescriptor, events, 64, timeoutMilliseconds)) == -1)
+    {
+      return errno == EINTR ? 0 : -1;
+    }
+
+    for (int32_t i = 0; i < eventCount; i++)
+    {
+      auto found = waiters.find(events[i].data.fd);
+      if (found == waiters.end())
+      {
+        continue;
+      }
+      if ((events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) && found->second.reader)
+      {
+        ready[readyCount++] = std::exchange(found->second.reader, {});
+      }
+      if ((events[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) && found->second.writer)
+      {
+        ready[readyCount++] = std::exchange(found->second.writer, {});
+      }
+      if (!found->second.reader && !found->second.writer)
+      {
+        waiters.erase(found);
+      }
+      else
+      {
+        arm(found->first, found->second);
+      }
+    }
+
+    for (int32_t i = 0; i < readyCount; i++)
+    {
+      ready[i].resume();
+    }
+    return readyCount;
+  }
+
+  void stop() noexcept { running = false; }
+
+private:
+  struct Waiters
+  {
+    std::coroutine_handle<> reader;
+    std::coroutine_handle<> writer;
+  };
+
+  bool wait(int32_t socketDescriptor, uint32_t events, std::coroutine_handle<> handle)
+  {
+    Waiters &entry = waiters[socketDescriptor];
+    if (events & EPOLLIN)
+    {
+      entry.reader = handle;
+    }
+    else
+    {
+      entry.writer = handle;
+    }
+    if (!arm(socketDescriptor, entry))
+    {
+      // Could not register, resume straight away so the retried call reports the error
+      if (events & EPOLLIN)
+      {
+        entry.reader = {};
+      }
+      else
+      {
+        entry.writer = {};
+      }
+      if (!entry.reader && !entry.writer)
+      {
+        waiters.erase(socketDescriptor);
+      }
+      return false;
+    }
+    return true;
+  }
+
+  bool arm(int32_t socketDescriptor, const Waiters &entry)
+  {
+    epoll_event event{};
+    event.events = EPOLLONESHOT | (entry.reader ? (uint32_t)EPOLLIN : 0u) | (entry.writer ? (uint32_t)EPOLLOUT : 0u);
+    event.data.fd = socketDescriptor;
+    if (epoll_ctl(epollDescriptor, EPOLL_CTL_MOD, socketDescriptor, &event) == 0)
+    {
+      return true;
+    }
+    return errno == ENOENT && epoll_ctl(epollDescriptor, EPOLL_CTL_ADD, socketDescriptor, &event) == 0;
+  }
+
+  int32_t epollDescriptor;
+  bool running;
+  std::unordered_map<int32_t, Waiters> waiters;
+};
+
+/*------------------------------------------------------------------------------------------------------------------
+-- CLASS: Socket
+--
+-- NOTES:
+-- Owns a socketStruct and releases it with closeSocket and freeSocket. Move only. The static constructors
+-- create non-blocking sockets ready for the async functions; on failure they return an invalid Socket and
+-- getSocketError reports why. closeSocket detaches any capture log or network emulator attached to the
+-- socket, so destroying a Socket leaves nothing pointing at its descriptor; a capture log can be closed
+-- once every Socket it was attached to is gone.
+----------------------------------------------------------------------------------------------------------------------*/
+class Socket
+{
+public:
+  Socket() noexcept : socketPointer(nullptr), peerAddress{} {}
+  explicit Socket(struct socketStruct *socketPointer, destination peer = {}) noexcept
+      : socketPointer(socketPointer), peerAddress(peer) {}
+  Socket(Socket &&other) noexcept
+      : socketPointer(std::exchange(other.socketPointer, nullptr)), peerAddress(other.peerAddress) {}
+  Socket &operator=(Socket &&other) noexcept
+  {
+    if (this != &other)
+    {
+      reset();
+      socketPointer = std::exchange(other.socketPointer, nullptr);
+      peerAddress = other.peerAddress;
+    }
+    return *this;
+  }
+  Socket(const Socket &) = delete;
+  Socket &operator=(const Socket &) = delete;
+  ~Socket() { reset(); }
+
+  /*--------------------------------------------------------------------------------------------------------------
+  -- FUNCTION: udp
+  --
+  -- INTERFACE: static Socket udp(uint16_t port, struct socketTuning * tuning = nullptr)
+  --                uint16_t port: The port to bind, in the same form bindPort takes. 0 for an ephemeral port.
+  --                struct socketTuning * tuning: Options to apply before binding, or null. Options that could
+  --                                              not be applied are left out of tuning->applied.
+  --------------------------------------------------------------------------------------------------------------*/
+  static Socket udp(uint16_t port, struct socketTuning *tuning = nullptr)
+  {
+    Socket socket(createSocket());
+    if (!socket.valid())
+    {
+      lastSocketError = ERR_NOMEMORY;
+      return socket;
+    }
+    if (!initSocket(socket.get()))
+    {
+      socket.release();
+      return socket;
+    }
+    if (tuning)
+    {
+      tuneSocket(socket.get(), tuning);
+    }
+    if (!bindPort(socket.get(), port) || !socket.setNonBlocking())
+    {
+      socket.reset();
+    }
+    return socket;
+  }
+
+  /*--------------------------------------------------------------------------------------------------------------
+  -- FUNCTION: tcp
+  --
+  -- INTERFACE: static Socket tcp(struct socketTuning * tuning = nullptr)
+  --                struct socketTuning * tuning: Options to apply, or null
+  --------------------------------------------------------------------------------------------------------------*/
+  static Socket tcp(struct socketTuning *tuning = nullptr)
+  {
+    Socket socket(createSocket());
+    if (!socket.valid())
+    {
+      lastSocketError = ERR_NOMEMORY;
+      return socket;
+    }
+    if (!initSocketTCP(socket.get()))
+    {
+      socket.release();
+      return socket;
+    }
+    if (tuning)
+    {
+      tuneSocket(socket.get(), tuning);
+    }
+    if (!socket.setNonBlocking())
+    {
+      socket.reset();
+    }
+    return socket;
+  }
+
+  /*--------------------------------------------------------------------------------------------------------------
+  -- FUNCTION: listener
+  --
+  -- INTERFACE: static Socket listener(uint16_t port, int32_t backlog = 0, struct socketTuning * tuning = nullptr)
+  --                uint16_t port: The port to listen on, in the same form bindPort takes
+  --                int32_t backlog: The listen backlog, 0 for SOMAXCONN
+  --                struct socketTuning * tuning: Options to apply before binding, or null
+  --------------------------------------------------------------------------------------------------------------*/
+  static Socket listener(uint16_t port, int32_t backlog = 0, struct socketTuning *tuning = nullptr)
+  {
+    Socket socket = tcp(tuning);
+    if (socket.valid() && (!bindPort(socket.get(), port) || !listenTCP(socket.get(), backlog)))
+    {
+      socket.reset();
+    }
+    return socket;
+  }
+
+  bool valid() const noexcept { return socketPointer != nullptr; }
+  explicit operator bool() const noexcept { return valid(); }
+  struct socketStruct *get() const noexcept { return socketPointer; }
+  int32_t descriptor() const noexcept { return socketPointer ? socketPointer->socketDescriptor : -1; }
+  const destination &peer() const noexcept { return peerAddress; }
+
+  void reset() noexcept
+  {
+    if (socketPointer)
+    {
+      closeSocket(socketPointer);
+      freeSocket(socketPointer);
+      socketPointer = nullptr;
+    }
+  }
+
+private:
+  void release() noexcept
+  {
+    freeSocket(socketPointer);
+    socketPointer = nullptr;
+  }
+
+  bool setNonBlocking() noexcept
+  {
+    int32_t flags = fcntl(descriptor(), F_GETFL);
+    if (flags == -1 || fcntl(descriptor(), F_SETFL, flags | O_NONBLOCK) == -1)
+    {
+      lastSocketError = ERR_BADSOCK;
+      return false;
+    }
+    return true;
+  }
+
+  struct socketStruct *socketPointer;
+  destination peerAddress;
+};
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: asyncRecv
+--
+-- RETURNS: As recvData: the number of bytes received, or -1 on error.
+--
+-- NOTES:
+-- Receives one datagram, suspending until one arrives.
+----------------------------------------------------------------------------------------------------------------------*/
+inline Task<int32_t> asyncRecv(Reactor &reactor, Socket &socket, destination &source, char *dataBuffer, size_t dataBufferSize)
+{
+  for (;;)
+  {
+    int32_t result = recvDataTimeout(socket.get(), &source, dataBuffer, dataBufferSize, 0);
+    if (result >= 0 || lastSocketError != ERR_TIMEOUT)
+    {
+      co_return result;
+    }
+    co_await reactor.readable(socket.descriptor());
+  }
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: asyncSend
+--
+-- RETURNS: As sendData: 1 on success, 0 on error.
+--
+-- NOTES:
+-- Sends one datagram, suspending while the socket send buffer is full.
+----------------------------------------------------------------------------------------------------------------------*/
+inline Task<int32_t> asyncSend(Reactor &reactor, Socket &socket, const destination &dest, const char *data, uint64_t dataLength)
+{
+  destination target = dest;
+  for (;;)
+  {
+    if (sendData(socket.get(), &target, data, dataLength))
+    {
+      co_return 1;
+    }
+    if (lastSocketError != ERR_TIMEOUT)
+    {
+      co_return 0;
+    }
+    co_await reactor.writable(socket.descriptor());
+  }
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: asyncRecvTCP
+--
+-- RETURNS: As recvDataTCP: packetSize once that many bytes have been read, 0 if the other side
+--          disconnected, or -1 on error.
+--
+-- NOTES:
+-- Reads exactly packetSize bytes from a connected socket, suspending whenever no data is available.
+----------------------------------------------------------------------------------------------------------------------*/
+inline Task<int32_t> asyncRecvTCP(Reactor &reactor, Socket &socket, char *dataBuffer, int32_t packetSize)
+{
+  int32_t received = 0;
+  while (received < packetSize)
+  {
+    int32_t result = recvDataTCPTimeout(socket.get(), dataBuffer + received, packetSize - received, 0);
+    if (result == 0)
+    {
+      co_return 0;
+    }
+    if (result > 0)
+    {
+      received += result;
+      continue;
+    }
+    if (lastSocketError != ERR_TIMEOUT)
+    {
+      co_return -1;
+    }
+    co_await reactor.readable(socket.descriptor());
+  }
+  co_return received;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: asyncSendTCP
+--
+-- RETURNS: As sendDataTCP: 1 once all of data has been sent, 0 on error.
+--
+-- NOTES:
+-- Sends all of data on a connected socket, suspending while the send buffer is full. Each attempt goes
+-- through sendDataTCPTimeout without waiting, which reports how much was sent so partial writes continue
+-- from where they stopped, and records what was sent in an attached capture log.
+----------------------------------------------------------------------------------------------------------------------*/
+inline Task<int32_t> asyncSendTCP(Reactor &reactor, Socket &socket, const char *data, uint64_t dataLength)
+{
+  uint64_t sent = 0;
+  while (sent < dataLength)
+  {
+    int64_t result = sendDataTCPTimeout(socket.get(), data + sent, dataLength - sent, 0);
+    if (result > 0)
+    {
+      sent += result;
+      continue;
+    }
+    if (lastSocketError != ERR_TIMEOUT)
+    {
+      co_return 0;
+    }
+    co_await reactor.writable(socket.descriptor());
+  }
+  co_return 1;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: asyncAccept
+--
+-- RETURNS: The accepted client with its peer address, or an invalid Socket on error.
+--
+-- NOTES:
+-- Accepts one connection on a listening socket, suspending until a client connects.
+----------------------------------------------------------------------------------------------------------------------*/
+inline Task<Socket> asyncAccept(Reactor &reactor, Socket &listener)
+{
+  for (;;)
+  {
+    struct socketStruct *client;
+    destination peer;
+    int32_t result = acceptClients(listener.get(), &client, &peer, 1);
+    if (result == 1)
+    {
+      co_return Socket(client, peer);
+    }
+    if (result == -1 || lastSocketError != ERR_TIMEOUT)
+    {
+      co_return Socket();
+    }
+    co_await reactor.readable(listener.descriptor());
+  }
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: asyncConnect
+--
+-- RETURNS: As connectPort: 1 on success, 0 on error.
+--
+-- NOTES:
+-- Connects a TCP socket, suspending until the connection is established or fails.
+----------------------------------------------------------------------------------------------------------------------*/
+inline Task<int32_t> asyncConnect(Reactor &reactor, Socket &socket, const destination &dest)
+{
+  destination target = dest;
+  int32_t socketErrorValue = 0;
+  socklen_t socketErrorLength = sizeof(socketErrorValue);
+
+  if (connectPortTimeout(socket.get(), &target, 0))
+  {
+    co_return 1;
+  }
+  if (lastSocketError != ERR_TIMEOUT)
+  {
+    co_return 0;
+  }
+
+  co_await reactor.writable(socket.descriptor());
+
+  if (getsockopt(socket.descriptor(), SOL_SOCKET, SO_ERROR, &socketErrorValue, &socketErrorLength) == -1)
+  {
+    socketErrorValue = errno;
+  }
+  if (socketErrorValue == 0)
+  {
+    co_return 1;
+  }
+  lastSocketError = connectErrorCode(socketErrorValue);
+  logger((char *)"ERROR > unable to connect to server", lastSocketError);
+  co_return 0;
+}
+
+} // namespace libsocket
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "socket.h"
+
+#define CAPTURE_MAGIC           "LSCAPLOG"
+#define CAPTURE_VERSION         1
+#define CAPTURE_DEFAULT_SIZE    (64ULL << 20)
+
+#define CAPTURE_SEND            0x01
+#define CAPTURE_RECV            0x02
+#define CAPTURE_TCP             0x04
+
+struct captureHeader{
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    int64_t startRealtime;
+    int64_t startMonotonic;
+    _Alignas(64) _Atomic uint64_t used;
+    _Atomic uint64_t dropped;
+};
+
+struct captureRecord{
+    _Atomic uint32_t recordSize;
+    uint32_t length;
+    int64_t timestamp;
+    uint32_t address;
+    uint16_t port;
+    uint8_t direction;
+    uint8_t reserved;
+    int32_t socketDescriptor;
+    uint32_t padding;
+};
+
+struct captureLog{
+    int32_t fileDescriptor;
+    char * base;
+    uint64_t capacity;
+    struct captureHeader * header;
+    _Atomic uint32_t attachedSockets;
+};
+
+struct captureReader{
+    char * base;
+    uint64_t size;
+    uint64_t offset;
+    struct captureHeader * header;
+};
+
+struct capturedPacket{
+    int64_t timestamp;
+    struct destination peer;
+    int32_t direction;
+    int32_t socketDescriptor;
+    const char * data;
+    uint32_t dataLength;
+};
+
+struct captureStats{
+    uint64_t records;
+    uint64_t bytes;
+    uint64_t dropped;
+};
+
+struct captureLog * openCapture(const char * path, uint64_t capacity);
+int32_t attachCapture(struct socketStruct * socketPointer, struct captureLog * log);
+int32_t detachCapture(struct socketStruct * socketPointer);
+void capturePacket(struct captureLog * log, int32_t socketDescriptor, int32_t direction, struct destination * peer, const char * data, int64_t dataLength);
+void getCaptureStats(struct captureLog * log, struct captureStats * stats);
+int32_t closeCapture(struct captureLog * log);
+
+struct captureReader * openCaptureReader(const char * path);
+int32_t nextCapturedPacket(struct captureReader * reader, struct capturedPacket * packet);
+void rewindCaptureReader(struct captureReader * reader);
+void closeCaptureReader(struct captureReader * reader);
+int64_t replayCapture(struct captureReader * reader, struct socketStruct * socketPointer, struct destination * target, int32_t directions, double speed);
+
+#endif
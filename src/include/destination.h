@@ -1,4 +1,11 @@
+#ifndef DESTINATION_H
+#define DESTINATION_H
+
+#include <stdint.h>
+
 struct destination {
     uint32_t address;
     uint16_t port;
-};
\ No newline at end of file
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef FILTER_H
+#define FILTER_H
+
+#include <sys/random.h>
+#include <netinet/udp.h>
+#include <linux/filter.h>
+
+#include "socket.h"
+
+#define FILTER_HEADER_SIZE      16
+#define FILTER_KEY_SIZE         16
+#define FILTER_SET_WAYS         4
+
+#define FILTER_DEFAULT_LIFETIME 30000000
+#define FILTER_DEFAULT_SETS     4096
+#define FILTER_MAX_SETS         (1u << 24)
+
+#define FILTER_PACKET_HELLO     0x01
+
+#define FILTER_PASS             0
+#define FILTER_SHORT            1
+#define FILTER_MAGIC            2
+#define FILTER_VERSION          3
+#define FILTER_COOKIE           4
+#define FILTER_RATE             5
+
+struct filterConfig{
+    uint32_t magic;
+    uint8_t minVersion;
+    uint8_t maxVersion;
+    int32_t requireCookie;
+    int64_t cookieLifetimeMicroseconds;
+    uint8_t key[FILTER_KEY_SIZE];
+    uint32_t packetsPerSecond;
+    uint32_t burst;
+    uint32_t rateTableSets;
+};
+
+struct filterStats{
+    uint64_t passed;
+    uint64_t shortPackets;
+    uint64_t badMagic;
+    uint64_t badVersion;
+    uint64_t badCookie;
+    uint64_t rateLimited;
+};
+
+struct rateEntry{
+    uint32_t address;
+    uint32_t milliTokens;
+    int64_t lastRefill;
+};
+
+struct rateSet{
+    _Alignas(64) struct rateEntry ways[FILTER_SET_WAYS];
+};
+
+struct packetFilter{
+    struct filterConfig config;
+    uint64_t keyWords[2];
+    uint64_t rateSeed;
+    struct rateSet * rateTable;
+    struct filterStats stats;
+};
+
+struct packetFilter * createPacketFilter(struct filterConfig * config);
+int32_t checkPacket(struct packetFilter * filter, struct destination * source, const char * data, int32_t dataLength);
+uint64_t makeCookie(struct packetFilter * filter, struct destination * source);
+void writeFilterHeader(char * dataBuffer, uint32_t magic, uint8_t version, uint8_t flags, uint64_t cookie);
+int32_t recvDataFiltered(struct socketStruct * socketPointer, struct packetFilter * filter, struct destination * dest, char * dataBuffer, size_t dataBufferSize);
+int32_t attachFilterBPF(struct socketStruct * socketPointer, struct packetFilter * filter);
+void getFilterStats(struct packetFilter * filter, struct filterStats * stats);
+void freePacketFilter(struct packetFilter * filter);
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef INTERNAL_H
+#define INTERNAL_H
+
+#include <pthread.h>
+#include <time.h>
+
+#include "socket.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LIBSOCKET_INTERNAL      __attribute__((visibility("hidden")))
+
+#define HOOK_CAPTURE            0
+#define HOOK_NETEM              1
+#define HOOK_COUNT              2
+
+#define HOOK_PAGE_SIZE          1024
+#define HOOK_PAGES              1024
+
+struct captureLog;
+struct netemShim;
+
+// Set by capture.c and netem.c when they are linked in, so socket.c also builds and links on its own
+struct hookFunctions{
+    void (*capturePacket)(struct captureLog * log, int32_t socketDescriptor, int32_t direction, struct destination * peer, const char * data, int64_t dataLength);
+    int32_t (*detachCapture)(struct socketStruct * socketPointer);
+    int32_t (*netemSend)(struct netemShim * shim, struct destination * dest, const char * data, size_t dataLength);
+    void (*detachNetem)(struct socketStruct * socketPointer);
+};
+
+extern LIBSOCKET_INTERNAL void ** hookPages[HOOK_PAGES];
+extern LIBSOCKET_INTERNAL uint32_t hooksAttached;
+extern LIBSOCKET_INTERNAL struct hookFunctions hookFunctions;
+
+LIBSOCKET_INTERNAL int32_t exchangeSocketHook(int32_t socketDescriptor, int32_t hook, void * value, void ** previous);
+LIBSOCKET_INTERNAL int32_t receiveBatch(struct socketStruct * socketPointer, struct receivedPacket * packets, int32_t packetCount, int32_t waitForFirst);
+
+// Exported, because asyncsocket.hpp calls it from code compiled into the application
+int32_t connectErrorCode(int32_t errorNumber);
+
+// CLOCK_MONOTONIC in microseconds, for deadlines that are unaffected by wall clock changes
+static inline int64_t monotonicMicroseconds()
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+static inline void *getSocketHook(int32_t socketDescriptor, int32_t hook)
+{
+  void **page;
+
+  if (__atomic_load_n(&hooksAttached, __ATOMIC_RELAXED) == 0 || socketDescriptor < 0 ||
+      socketDescriptor >= HOOK_PAGES * HOOK_PAGE_SIZE ||
+      (page = __atomic_load_n(&hookPages[socketDescriptor / HOOK_PAGE_SIZE], __ATOMIC_ACQUIRE)) == 0)
+  {
+    return 0;
+  }
+  return __atomic_load_n(&page[(socketDescriptor % HOOK_PAGE_SIZE) * HOOK_COUNT + hook], __ATOMIC_ACQUIRE);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef IOTHREAD_H
+#define IOTHREAD_H
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "socket.h"
+#include "packetqueue.h"
+
+#define IO_POLL_BUSY        0
+#define IO_POLL_BACKOFF     1
+
+#define IO_DEFAULT_BACKOFF  1000
+#define IO_ERROR_BACKOFF    1000000
+
+struct ioThreadConfig{
+    int32_t cpu;
+    int32_t pollPolicy;
+    int64_t backoffLimitMicroseconds;
+};
+
+struct ioThreadStats{
+    uint64_t packetsReceived;
+    uint64_t receiveDrops;
+    uint64_t packetsSent;
+    uint64_t sendErrors;
+};
+
+struct ioThreads{
+    struct socketStruct * socket;
+    struct packetQueue * inbound;
+    struct packetQueue * outbound;
+    struct ioThreadConfig receiveConfig;
+    struct ioThreadConfig sendConfig;
+    uint32_t maxPacketSize;
+    char * receiveBuffer;
+    char * sendBuffer;
+    pthread_t receiveThread;
+    pthread_t sendThread;
+    _Atomic int32_t running;
+    _Atomic uint64_t packetsReceived;
+    _Atomic uint64_t receiveDrops;
+    _Atomic uint64_t packetsSent;
+    _Atomic uint64_t sendErrors;
+};
+
+struct ioThreads * startIoThreads(struct socketStruct* socketPointer, uint32_t queueCapacity, uint32_t maxPacketSize, struct ioThreadConfig * receiveConfig, struct ioThreadConfig * sendConfig);
+int32_t ioRecv(struct ioThreads * threads, struct destination * dest, char * dataBuffer, size_t dataBufferSize);
+int32_t ioSend(struct ioThreads * threads, struct destination * dest, const char * data, uint32_t dataLength);
+void getIoThreadStats(struct ioThreads * threads, struct ioThreadStats * stats);
+void stopIoThreads(struct ioThreads * threads);
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef NETEM_H
+#define NETEM_H
+
+#include <pthread.h>
+#include <math.h>
+
+#include "socket.h"
+
+#define NETEM_UNIFORM           0
+#define NETEM_NORMAL            1
+#define NETEM_PARETO            2
+
+#define NETEM_DEFAULT_QUEUE     1000
+
+struct netemConfig{
+    uint64_t seed;
+    double lossRate;
+    int64_t delayMicroseconds;
+    int64_t jitterMicroseconds;
+    int32_t delayDistribution;
+    double duplicateRate;
+    double reorderRate;
+    uint64_t rateBitsPerSecond;
+    uint32_t queueLimit;
+};
+
+struct netemStats{
+    uint64_t packets;
+    uint64_t lost;
+    uint64_t duplicated;
+    uint64_t reordered;
+    uint64_t queueDrops;
+    uint64_t delivered;
+    uint64_t sendErrors;
+};
+
+struct netemPacket{
+    int64_t due;
+    uint64_t sequence;
+    struct destination dest;
+    size_t dataLength;
+    char data[];
+};
+
+struct netemShim{
+    struct netemConfig config;
+    int32_t socketDescriptor;
+    uint64_t randomState;
+    uint64_t sequence;
+    int64_t lastDeparture;
+    struct netemPacket ** queue;
+    uint32_t queueLength;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_t deliveryThread;
+    int32_t running;
+    struct netemStats stats;
+};
+
+int32_t attachNetem(struct socketStruct * socketPointer, struct netemConfig * config);
+int32_t netemSend(struct netemShim * shim, struct destination * dest, const char * data, size_t dataLength);
+void getNetemStats(struct socketStruct * socketPointer, struct netemStats * stats);
+void detachNetem(struct socketStruct * socketPointer);
+
+#endif
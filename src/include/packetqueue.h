@@ -0,0 +1,28 @@
+#ifndef PACKETQUEUE_H
+#define PACKETQUEUE_H
+
+#include <stdatomic.h>
+
+#include "socket.h"
+
+#define QUEUE_SPSC          0
+#define QUEUE_MPSC          1
+
+#define QUEUE_CACHE_LINE    64
+
+struct packetQueue{
+    _Alignas(QUEUE_CACHE_LINE) _Atomic uint64_t tail;
+    _Alignas(QUEUE_CACHE_LINE) _Atomic uint64_t head;
+    _Alignas(QUEUE_CACHE_LINE) uint64_t mask;
+    uint32_t slotSize;
+    uint32_t maxPacketSize;
+    int32_t mode;
+    char * slots;
+};
+
+struct packetQueue * createPacketQueue(uint32_t capacity, uint32_t maxPacketSize, int32_t mode);
+int32_t pushPacket(struct packetQueue * queue, struct destination * dest, const char * data, uint32_t dataLength);
+int32_t popPacket(struct packetQueue * queue, struct destination * dest, char * dataBuffer, size_t dataBufferSize);
+void freePacketQueue(struct packetQueue * queue);
+
+#endif
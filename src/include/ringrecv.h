@@ -0,0 +1,44 @@
+#ifndef RINGRECV_H
+#define RINGRECV_H
+
+#include <sys/mman.h>
+#include <net/if.h>
+#include <net/ethernet.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+#include <linux/if_packet.h>
+#include <linux/filter.h>
+
+#include "socket.h"
+
+#define RING_DEFAULT_BLOCK_SIZE     (1 << 20)
+#define RING_DEFAULT_BLOCK_COUNT    64
+#define RING_FRAME_SIZE             2048
+#define RING_BLOCK_TIMEOUT          1
+
+struct ringStats{
+    uint64_t packets;
+    uint64_t drops;
+    uint64_t freezes;
+};
+
+struct ringReceiver{
+    int32_t socketDescriptor;
+    uint16_t port;
+    char * ring;
+    size_t ringSize;
+    uint32_t blockSize;
+    uint32_t blockCount;
+    uint32_t currentBlock;
+    uint32_t packetsLeft;
+    char * nextPacket;
+    struct tpacket_block_desc * heldBlock;
+    struct ringStats stats;
+};
+
+struct ringReceiver * openRingReceiver(uint16_t port, const char * interfaceName, uint32_t blockSize, uint32_t blockCount);
+int32_t recvDataRing(struct ringReceiver * receiver, struct destination * source, const char ** payload, int64_t waitMicroseconds);
+int32_t getRingStats(struct ringReceiver * receiver, struct ringStats * stats);
+void closeRingReceiver(struct ringReceiver * receiver);
+
+#endif
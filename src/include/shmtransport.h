@@ -0,0 +1,32 @@
+#ifndef SHMTRANSPORT_H
+#define SHMTRANSPORT_H
+
+#include <stddef.h>
+
+#include "socket.h"
+
+#define LOCAL_DEFAULT_RING  (1 << 20)
+
+struct shmRing;
+
+struct localChannel{
+    struct socketStruct * socket;
+    int32_t controlDescriptor;
+    uint32_t ringSize;
+    void * region;
+    size_t regionSize;
+    struct shmRing * sendRing;
+    struct shmRing * recvRing;
+    char * frameBuffer;
+    size_t frameBufferSize;
+};
+
+struct localChannel * listenLocal(uint16_t port, uint32_t ringSize);
+struct localChannel * acceptLocal(struct localChannel * listener);
+struct localChannel * connectLocal(struct destination * dest);
+int32_t sendLocal(struct localChannel * channel, const char * data, uint32_t dataLength);
+int32_t recvLocal(struct localChannel * channel, char * dataBuffer, size_t dataBufferSize);
+int32_t isLocalShared(struct localChannel * channel);
+void closeLocal(struct localChannel * channel);
+
+#endif
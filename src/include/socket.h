@@ -1,8 +1,12 @@
+#ifndef SOCKET_H
+#define SOCKET_H
+
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <stdio.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <errno.h>
 #include <strings.h>
 #include <arpa/inet.h>
@@ -10,9 +14,20 @@
 #include <unistd.h>
 #include <string.h>
 #include <sys/time.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <time.h>
+#ifdef __linux__
+#include <linux/net_tstamp.h>
+#include <linux/errqueue.h>
+#endif
 
 #include "destination.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #define ERR_UNKNOWN         0
 #define ERR_NOMEMORY        1
 #define ERR_ILLEGALOP       2
@@ -25,26 +40,109 @@
 #define ERR_ADDRNOTAVAIL    9
 #define ERR_TIMEOUT         10
 
+#define TIMESTAMP_SOFTWARE  1
+#define TIMESTAMP_HARDWARE  2
+#define TIMESTAMP_TX        4
+
+#define RECV_BATCH_MAX      64
+#define SEND_BATCH_MAX      64
+
+#define TUNE_RCVBUF         0x001
+#define TUNE_SNDBUF         0x002
+#define TUNE_REUSEADDR      0x004
+#define TUNE_REUSEPORT      0x008
+#define TUNE_NODELAY        0x010
+#define TUNE_QUICKACK       0x020
+#define TUNE_BUSYPOLL       0x040
+#define TUNE_TOS            0x080
+#define TUNE_PRIORITY       0x100
+#define TUNE_DEFERACCEPT    0x200
+#define TUNE_FASTOPEN       0x400
+
 struct socketStruct{
     int32_t socketDescriptor;
-    int32_t lastError;
+};
+
+struct packetTimestamp{
+    int64_t software;
+    int64_t hardware;
+};
+
+struct receivedPacket{
+    struct destination source;
+    struct packetTimestamp timestamp;
+    char * dataBuffer;
+    size_t dataBufferSize;
+    int32_t dataLength;
+};
+
+struct sendPacket{
+    struct destination dest;
+    const char * data;
+    size_t dataLength;
+};
+
+struct socketTuning{
+    int32_t receiveBufferSize;
+    int32_t sendBufferSize;
+    int32_t reuseAddress;
+    int32_t reusePort;
+    int32_t noDelay;
+    int32_t quickAck;
+    int32_t busyPollMicroseconds;
+    int32_t typeOfService;
+    int32_t priority;
+    int32_t deferAcceptSeconds;
+    int32_t fastOpenQueueLength;
+    int32_t applied;
+    int32_t effectiveReceiveBufferSize;
+    int32_t effectiveSendBufferSize;
 };
 
 struct socketStruct * createSocket();
 int32_t attachTimeout(struct socketStruct* socketPointer, int32_t waitDuration);
+int32_t attachReceiveTimeout(struct socketStruct* socketPointer, int64_t waitMicroseconds);
+int32_t attachSendTimeout(struct socketStruct* socketPointer, int64_t waitMicroseconds);
 int32_t initSocket(struct socketStruct* socketPointer);
+int32_t initSocketTuned(struct socketStruct* socketPointer, struct socketTuning* tuning);
+int32_t tuneSocket(struct socketStruct* socketPointer, struct socketTuning* tuning);
 int32_t sendData(struct socketStruct* socket, struct destination * dest, const char* data, u_int64_t dataLength);
 int32_t recvData(struct socketStruct* socketPointer,struct destination * dest,  char * dataBuffer, size_t dataBufferSize);
+int32_t recvDataTimeout(struct socketStruct* socketPointer, struct destination * dest, char * dataBuffer, size_t dataBufferSize, int64_t waitMicroseconds);
+int32_t recvDataTimestamp(struct socketStruct* socketPointer, struct destination * dest, struct packetTimestamp * timestamp, char * dataBuffer, size_t dataBufferSize);
+int32_t recvDataBatch(struct socketStruct* socketPointer, struct receivedPacket * packets, int32_t packetCount);
+int32_t enableTimestamping(struct socketStruct* socketPointer, int32_t timestampFlags);
+int32_t recvTxTimestamp(struct socketStruct* socketPointer, uint32_t * sendIndex, struct packetTimestamp * timestamp);
+int32_t joinMulticastGroup(struct socketStruct* socketPointer, uint32_t groupAddress, uint32_t interfaceAddress);
+int32_t leaveMulticastGroup(struct socketStruct* socketPointer, uint32_t groupAddress, uint32_t interfaceAddress);
+int32_t setMulticastTTL(struct socketStruct* socketPointer, int32_t timeToLive);
+int32_t setMulticastLoopback(struct socketStruct* socketPointer, int32_t enable);
+int32_t setMulticastInterface(struct socketStruct* socketPointer, uint32_t interfaceAddress);
+int32_t sendDataGroup(struct socketStruct* socketPointer, struct destination * groups, int32_t groupCount, const char * data, size_t dataLength);
+int32_t sendDataBatch(struct socketStruct* socketPointer, struct sendPacket * packets, int32_t packetCount);
 int32_t closeSocket(struct socketStruct * socket);
 void freeSocket(struct socketStruct * socket);
 
 int32_t initSocketTCP(struct socketStruct* socketPointer);
+int32_t initSocketTCPTuned(struct socketStruct* socketPointer, struct socketTuning* tuning);
 int32_t bindPort(struct socketStruct* socketPointer, uint16_t port);
 int32_t connectPort(struct socketStruct* socketPointer, struct destination* dest);
+int32_t connectPortTimeout(struct socketStruct* socketPointer, struct destination* dest, int64_t waitMicroseconds);
+int32_t listenTCP(struct socketStruct* socketPointer, int32_t backlog);
 int32_t acceptClient(struct socketStruct* socketPointer);
+int32_t acceptClients(struct socketStruct* socketPointer, struct socketStruct** clients, struct destination* peers, int32_t maxClients);
 int32_t sendDataTCP(struct socketStruct* socketPointer, const char* data, uint64_t dataBufferSize);
+int64_t sendDataTCPTimeout(struct socketStruct* socketPointer, const char* data, uint64_t dataLength, int64_t waitMicroseconds);
 int32_t recvDataTCP(struct socketStruct* socketPointer, char* dataBuffer, int32_t packetSize);
+int32_t recvDataTCPTimeout(struct socketStruct* socketPointer, char* dataBuffer, int32_t packetSize, int64_t waitMicroseconds);
+
+extern __thread int32_t lastSocketError;
 
 int32_t getSocketError(struct socketStruct* socketPointer);
 void logger(char *msg, int32_t error_num);
 
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef TICK_H
+#define TICK_H
+
+#include <stdatomic.h>
+#include <sys/timerfd.h>
+
+#include "socket.h"
+
+#define TICK_DEFAULT_SENDS      1024
+#define TICK_DEFAULT_PACKET     1500
+
+struct tickLoop;
+
+struct tickConfig{
+    int64_t tickMicroseconds;
+    uint32_t sendQueueLength;
+    uint32_t maxPacketSize;
+    void (*onPacket)(struct tickLoop * loop, struct receivedPacket * packet, void * context);
+    void (*onTick)(struct tickLoop * loop, uint64_t tick, uint32_t elapsedTicks, void * context);
+    void * context;
+};
+
+struct tickStats{
+    uint64_t ticks;
+    uint64_t missedTicks;
+    uint64_t overruns;
+    int64_t totalLatenessMicroseconds;
+    int64_t maxLatenessMicroseconds;
+    int64_t totalWorkMicroseconds;
+    int64_t maxWorkMicroseconds;
+    uint64_t packetsReceived;
+    uint64_t receiveBatches;
+    uint64_t packetsSent;
+    uint64_t sendBatches;
+    uint64_t sendErrors;
+};
+
+struct tickLoop{
+    struct socketStruct * socket;
+    struct tickConfig config;
+    int32_t timerDescriptor;
+    int64_t startMicroseconds;
+    uint64_t tick;
+    struct receivedPacket receivePackets[RECV_BATCH_MAX];
+    char * receiveBuffer;
+    struct sendPacket * sendPackets;
+    char * sendBuffer;
+    uint32_t sendQueued;
+    _Atomic int32_t running;
+    struct tickStats stats;
+};
+
+struct tickLoop * createTickLoop(struct socketStruct * socketPointer, struct tickConfig * config);
+int32_t queueTickSend(struct tickLoop * loop, struct destination * dest, const char * data, uint32_t dataLength);
+int32_t runTickLoop(struct tickLoop * loop);
+void stopTickLoop(struct tickLoop * loop);
+void getTickStats(struct tickLoop * loop, struct tickStats * stats);
+void freeTickLoop(struct tickLoop * loop);
+
+#endif
@@ -0,0 +1,539 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: iothread.c - Dedicated receive and send threads connected to logic threads by lock-free queues.
+--
+--
+-- PROGRAM: libsocket
+--
+-- FUNCTIONS:
+-- struct ioThreads * startIoThreads(struct socketStruct* socketPointer, uint32_t queueCapacity,
+--                                   uint32_t maxPacketSize, struct ioThreadConfig * receiveConfig,
+--                                   struct ioThreadConfig * sendConfig)
+-- int ioRecv(struct ioThreads * threads, struct destination * dest, char * dataBuffer, size_t dataBufferSize)
+-- int ioSend(struct ioThreads * threads, struct destination * dest, const char * data, uint32_t dataLength)
+-- void getIoThreadStats(struct ioThreads * threads, struct ioThreadStats * stats)
+-- void stopIoThreads(struct ioThreads * threads)
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- NOTES:
+-- startIoThreads attaches a receive thread and a send thread to a bound UDP socket. The receive thread
+-- calls recvData in a loop and pushes every datagram, with the destination it came from, into a QUEUE_SPSC
+-- inbound queue that one logic thread drains with ioRecv. Any number of logic threads may call ioSend,
+-- which pushes into a QUEUE_MPSC outbound queue drained by the send thread. Neither side takes a lock.
+--
+-- Each thread can be pinned to a CPU and given a poll policy. IO_POLL_BUSY never sleeps, giving the lowest
+-- latency at the cost of a full core. IO_POLL_BACKOFF lets the receive thread block in the kernel and the
+-- send thread spin, yield and then sleep for increasing periods up to backoffLimitMicroseconds.
+-- Datagrams that arrive while the inbound queue is full are dropped and counted. CPU pinning is Linux only.
+-- A receive error other than a timeout is logged by recvDataTimeout, so the receive thread sleeps after one,
+-- from 1ms doubling up to IO_ERROR_BACKOFF, whatever its poll policy, and a persistent error is not logged
+-- on every spin.
+--
+-- This is a fixed pair, not a pool: each ioThreads has exactly one receive thread and one send thread. The
+-- inbound queue has a single producer and the send thread is the only consumer of the outbound queue. To
+-- use more cores, bind several sockets to the same port with the reusePort tuning option and start
+-- ioThreads on each, so the kernel spreads incoming datagrams across them.
+----------------------------------------------------------------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include "include/iothread.h"
+
+static void *receiveLoop(void *argument);
+static void *sendLoop(void *argument);
+static void idleWait(struct ioThreadConfig *config, uint32_t idleRounds);
+static int32_t startThread(pthread_t *thread, struct ioThreadConfig *config, void *(*loop)(void *), void *argument);
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: startIoThreads
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS: October 18, 2026
+--              -Size the receive and send buffers to maxPacketSize and reject a size of 0
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: struct ioThreads * startIoThreads(struct socketStruct* socketPointer, uint32_t queueCapacity,
+--                                              uint32_t maxPacketSize, struct ioThreadConfig * receiveConfig,
+--                                              struct ioThreadConfig * sendConfig)
+--                struct socketStruct * socketPointer: A bound UDP socket to run the threads on
+--                uint32_t queueCapacity: The number of packets each queue can hold
+--                uint32_t maxPacketSize: The largest datagram that will be received or sent
+--                struct ioThreadConfig * receiveConfig: CPU and poll policy for the receive thread, or null
+--                                                       for no pinning and IO_POLL_BACKOFF
+--                struct ioThreadConfig * sendConfig: CPU and poll policy for the send thread, or null
+--                                                    for no pinning and IO_POLL_BACKOFF
+--
+-- RETURNS: On success a pointer to the running ioThreads is returned. On error a null pointer is returned
+--          and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used to start the receive and send threads for a socket. It always starts one of each;
+-- see the file notes for spreading a port over several pairs. The socket must stay open until
+-- stopIoThreads has returned.
+----------------------------------------------------------------------------------------------------------------------*/
+struct ioThreads *startIoThreads(struct socketStruct *socketPointer, uint32_t queueCapacity, uint32_t maxPacketSize, struct ioThreadConfig *receiveConfig, struct ioThreadConfig *sendConfig)
+{
+  struct ioThreadConfig defaultConfig = {-1, IO_POLL_BACKOFF, IO_DEFAULT_BACKOFF};
+  struct ioThreads *threads;
+
+  if (socketPointer == 0)
+  {
+    logger("ERROR > invalid socket passed to startIoThreads", -1);
+    return 0;
+  }
+  if (maxPacketSize == 0)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid packet size passed to startIoThreads", lastSocketError);
+    return 0;
+  }
+  if ((threads = calloc(1, sizeof(struct ioThreads))) == 0)
+  {
+    lastSocketError = ERR_NOMEMORY;
+    logger("ERROR > unable to allocate io threads", lastSocketError);
+    return 0;
+  }
+
+  threads->socket = socketPointer;
+  threads->maxPacketSize = maxPacketSize;
+  threads->receiveConfig = receiveConfig != 0 ? *receiveConfig : defaultConfig;
+  threads->sendConfig = sendConfig != 0 ? *sendConfig : defaultConfig;
+  if (threads->receiveConfig.backoffLimitMicroseconds <= 0)
+  {
+    threads->receiveConfig.backoffLimitMicroseconds = IO_DEFAULT_BACKOFF;
+  }
+  if (threads->sendConfig.backoffLimitMicroseconds <= 0)
+  {
+    threads->sendConfig.backoffLimitMicroseconds = IO_DEFAULT_BACKOFF;
+  }
+  atomic_init(&threads->running, 1);
+
+  if ((threads->inbound = createPacketQueue(queueCapacity, maxPacketSize, QUEUE_SPSC)) == 0 ||
+      (threads->outbound = createPacketQueue(queueCapacity, maxPacketSize, QUEUE_MPSC)) == 0)
+  {
+    freePacketQueue(threads->inbound);
+    free(threads);
+    return 0;
+  }
+  if ((threads->receiveBuffer = malloc(maxPacketSize)) == 0 || (threads->sendBuffer = malloc(maxPacketSize)) == 0)
+  {
+    free(threads->receiveBuffer);
+    freePacketQueue(threads->inbound);
+    freePacketQueue(threads->outbound);
+    free(threads);
+    lastSocketError = ERR_NOMEMORY;
+    logger("ERROR > unable to allocate io thread buffers", lastSocketError);
+    return 0;
+  }
+
+  if (!startThread(&threads->receiveThread, &threads->receiveConfig, receiveLoop, threads))
+  {
+    free(threads->receiveBuffer);
+    free(threads->sendBuffer);
+    freePacketQueue(threads->inbound);
+    freePacketQueue(threads->outbound);
+    free(threads);
+    return 0;
+  }
+  if (!startThread(&threads->sendThread, &threads->sendConfig, sendLoop, threads))
+  {
+    atomic_store(&threads->running, 0);
+    pthread_join(threads->receiveThread, 0);
+    free(threads->receiveBuffer);
+    free(threads->sendBuffer);
+    freePacketQueue(threads->inbound);
+    freePacketQueue(threads->outbound);
+    free(threads);
+    return 0;
+  }
+
+  return threads;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: ioRecv
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int ioRecv(struct ioThreads * threads, struct destination * dest, char * dataBuffer,
+--                       size_t dataBufferSize)
+--                struct ioThreads * threads: The io threads to take a packet from
+--                struct destination * dest: A destination struct to fill with the address and port data was
+--                                           recieved from
+--                char * dataBuffer: An array for received data to be placed into
+--                size_t dataBufferSize: The size of dataBuffer
+--
+-- RETURNS: On success the number of bytes read into dataBuffer is returned. If no packet is waiting -1 is
+--          returned and lastSocketError is set to ERR_TIMEOUT.
+--
+-- NOTES:
+-- This function is used by a logic thread to take the oldest received datagram without blocking. Only one
+-- thread may call ioRecv on a given ioThreads.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t ioRecv(struct ioThreads *threads, struct destination *dest, char *dataBuffer, size_t dataBufferSize)
+{
+  if (threads == 0)
+  {
+    logger("ERROR > invalid io threads passed to ioRecv", -1);
+    return -1;
+  }
+  return popPacket(threads->inbound, dest, dataBuffer, dataBufferSize);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: ioSend
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int ioSend(struct ioThreads * threads, struct destination * dest, const char * data,
+--                       uint32_t dataLength)
+--                struct ioThreads * threads: The io threads to send through
+--                struct destination * dest: A destination struct containing and IP address and port
+--                const char * data: A char array containing the data to be sent
+--                uint32_t dataLength: The length of the data in the char array
+--
+-- RETURNS: On success 1 is returned. If the outbound queue is full 0 is returned and lastSocketError is set
+--          to ERR_TIMEOUT. On error 0 is returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used by logic threads to hand a datagram to the send thread. It may be called from any
+-- number of threads at once.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t ioSend(struct ioThreads *threads, struct destination *dest, const char *data, uint32_t dataLength)
+{
+  if (threads == 0)
+  {
+    logger("ERROR > invalid io threads passed to ioSend", -1);
+    return 0;
+  }
+  return pushPacket(threads->outbound, dest, data, dataLength);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: getIoThreadStats
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: void getIoThreadStats(struct ioThreads * threads, struct ioThreadStats * stats)
+--                struct ioThreads * threads: The io threads to read the counters of
+--                struct ioThreadStats * stats: The struct to fill in
+--
+-- RETURNS: void.
+--
+-- NOTES:
+-- This function is used to read the packet counters of the io threads. It may be called from any thread.
+----------------------------------------------------------------------------------------------------------------------*/
+void getIoThreadStats(struct ioThreads *threads, struct ioThreadStats *stats)
+{
+  if (threads == 0 || stats == 0)
+  {
+    return;
+  }
+  stats->packetsReceived = atomic_load_explicit(&threads->packetsReceived, memory_order_relaxed);
+  stats->receiveDrops = atomic_load_explicit(&threads->receiveDrops, memory_order_relaxed);
+  stats->packetsSent = atomic_load_explicit(&threads->packetsSent, memory_order_relaxed);
+  stats->sendErrors = atomic_load_explicit(&threads->sendErrors, memory_order_relaxed);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: stopIoThreads
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: void stopIoThreads(struct ioThreads * threads)
+--                struct ioThreads * threads: The io threads to stop
+--
+-- RETURNS: void.
+--
+-- NOTES:
+-- This function is used to stop and free the io threads. Packets already passed to ioSend are sent before
+-- the send thread exits, received packets not yet taken by ioRecv are discarded. The socket is not closed.
+----------------------------------------------------------------------------------------------------------------------*/
+void stopIoThreads(struct ioThreads *threads)
+{
+  if (threads == 0)
+  {
+    return;
+  }
+  atomic_store(&threads->running, 0);
+  pthread_join(threads->receiveThread, 0);
+  pthread_join(threads->sendThread, 0);
+  free(threads->receiveBuffer);
+  free(threads->sendBuffer);
+  freePacketQueue(threads->inbound);
+  freePacketQueue(threads->outbound);
+  free(threads);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: receiveLoop
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS: October 18, 2026
+--              -Back off after receive errors in every poll policy
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static void * receiveLoop(void * argument)
+--                void * argument: The ioThreads the thread belongs to
+--
+-- RETURNS: null.
+--
+-- NOTES:
+-- Body of the receive thread. With IO_POLL_BACKOFF the thread blocks in the kernel for at most
+-- backoffLimitMicroseconds at a time so it notices stopIoThreads promptly. Every failed receive other than a
+-- timeout writes to the log, so after one the thread sleeps for 1ms, doubling on each further error up to
+-- IO_ERROR_BACKOFF, even with IO_POLL_BUSY.
+----------------------------------------------------------------------------------------------------------------------*/
+static void *receiveLoop(void *argument)
+{
+  struct ioThreads *threads = argument;
+  struct ioThreadConfig *config = &threads->receiveConfig;
+  struct ioThreadConfig errorConfig = {config->cpu, IO_POLL_BACKOFF, IO_ERROR_BACKOFF};
+  struct destination source;
+  int64_t waitMicroseconds = config->pollPolicy == IO_POLL_BUSY ? 0 : config->backoffLimitMicroseconds;
+  uint32_t errorRounds = 0;
+  int32_t dataLength;
+
+  while (atomic_load_explicit(&threads->running, memory_order_relaxed))
+  {
+    if ((dataLength = recvDataTimeout(threads->socket, &source, threads->receiveBuffer, threads->maxPacketSize, waitMicroseconds)) < 0)
+    {
+      if (lastSocketError != ERR_TIMEOUT)
+      {
+        // idleWait sleeps 1 << (rounds - 128) microseconds, so round 138 is about 1ms
+        idleWait(&errorConfig, 138 + errorRounds);
+        errorRounds += errorRounds < 10;
+      }
+      continue;
+    }
+    errorRounds = 0;
+    if (pushPacket(threads->inbound, &source, threads->receiveBuffer, dataLength))
+    {
+      atomic_fetch_add_explicit(&threads->packetsReceived, 1, memory_order_relaxed);
+    }
+    else
+    {
+      atomic_fetch_add_explicit(&threads->receiveDrops, 1, memory_order_relaxed);
+    }
+  }
+  return 0;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: sendLoop
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static void * sendLoop(void * argument)
+--                void * argument: The ioThreads the thread belongs to
+--
+-- RETURNS: null.
+--
+-- NOTES:
+-- Body of the send thread. Drains the outbound queue, waiting according to the poll policy while it is
+-- empty, and drains it once more after stopIoThreads is called.
+----------------------------------------------------------------------------------------------------------------------*/
+static void *sendLoop(void *argument)
+{
+  struct ioThreads *threads = argument;
+  struct destination dest;
+  uint32_t idleRounds = 0;
+  int32_t running = 1;
+  int32_t dataLength;
+
+  for (;;)
+  {
+    if ((dataLength = popPacket(threads->outbound, &dest, threads->sendBuffer, threads->maxPacketSize)) < 0)
+    {
+      if (!running)
+      {
+        break;
+      }
+      running = atomic_load_explicit(&threads->running, memory_order_relaxed);
+      idleWait(&threads->sendConfig, idleRounds++);
+      continue;
+    }
+    idleRounds = 0;
+    if (sendData(threads->socket, &dest, threads->sendBuffer, dataLength))
+    {
+      atomic_fetch_add_explicit(&threads->packetsSent, 1, memory_order_relaxed);
+    }
+    else
+    {
+      atomic_fetch_add_explicit(&threads->sendErrors, 1, memory_order_relaxed);
+    }
+  }
+  return 0;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: idleWait
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static void idleWait(struct ioThreadConfig * config, uint32_t idleRounds)
+--                struct ioThreadConfig * config: The configuration of the waiting thread
+--                uint32_t idleRounds: The number of consecutive times the thread has found no work
+--
+-- RETURNS: void.
+--
+-- NOTES:
+-- With IO_POLL_BUSY only a CPU pause hint is issued. With IO_POLL_BACKOFF the thread spins for 64 rounds,
+-- yields for 64 more and then sleeps, doubling the sleep from one microsecond up to the backoff limit.
+----------------------------------------------------------------------------------------------------------------------*/
+static void idleWait(struct ioThreadConfig *config, uint32_t idleRounds)
+{
+  struct timespec sleepTime;
+  int64_t sleepMicroseconds;
+
+  if (config->pollPolicy == IO_POLL_BUSY || idleRounds < 64)
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+    return;
+  }
+  if (idleRounds < 128)
+  {
+    sched_yield();
+    return;
+  }
+
+  sleepMicroseconds = idleRounds - 128 < 20 ? (int64_t)1 << (idleRounds - 128) : config->backoffLimitMicroseconds;
+  if (sleepMicroseconds > config->backoffLimitMicroseconds)
+  {
+    sleepMicroseconds = config->backoffLimitMicroseconds;
+  }
+  sleepTime.tv_sec = sleepMicroseconds / 1000000;
+  sleepTime.tv_nsec = (sleepMicroseconds % 1000000) * 1000;
+  nanosleep(&sleepTime, 0);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: startThread
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS: October 18, 2026
+--              -Report a failure to pin the thread instead of ignoring it
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static int startThread(pthread_t * thread, struct ioThreadConfig * config,
+--                                   void *(*loop)(void *), void * argument)
+--                pthread_t * thread: Set to the new thread
+--                struct ioThreadConfig * config: The CPU to pin the thread to, if any
+--                void *(*loop)(void *): The thread body
+--                void * argument: The argument passed to loop
+--
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- Creates a thread, pinned to config->cpu when it is not negative. A CPU that cannot be put in the affinity
+-- mask fails with ERR_ILLEGALOP rather than starting an unpinned thread. A CPU that is in range but not
+-- online is refused by pthread_create, also as ERR_ILLEGALOP.
+----------------------------------------------------------------------------------------------------------------------*/
+static int32_t startThread(pthread_t *thread, struct ioThreadConfig *config, void *(*loop)(void *), void *argument)
+{
+  pthread_attr_t attributes;
+  int32_t result = 0;
+
+  pthread_attr_init(&attributes);
+#ifdef __linux__
+  cpu_set_t cpus;
+  if (config->cpu >= CPU_SETSIZE)
+  {
+    result = EINVAL;
+  }
+  else if (config->cpu >= 0)
+  {
+    CPU_ZERO(&cpus);
+    CPU_SET(config->cpu, &cpus);
+    result = pthread_attr_setaffinity_np(&attributes, sizeof(cpus), &cpus);
+  }
+  if (result != 0)
+  {
+    pthread_attr_destroy(&attributes);
+    lastSocketError = result == ENOMEM ? ERR_NOMEMORY : ERR_ILLEGALOP;
+    logger("ERROR > unable to pin io thread to cpu", lastSocketError);
+    return 0;
+  }
+#endif
+
+  result = pthread_create(thread, &attributes, loop, argument);
+  pthread_attr_destroy(&attributes);
+
+  if (result != 0)
+  {
+    switch (result)
+    {
+    case EAGAIN:
+      lastSocketError = ERR_NOMEMORY;
+      break;
+    case EINVAL:
+      lastSocketError = ERR_ILLEGALOP;
+      break;
+    case EPERM:
+      lastSocketError = ERR_PERMISSION;
+      break;
+    default:
+      lastSocketError = ERR_UNKNOWN;
+      break;
+    }
+    logger("ERROR > unable to start io thread", lastSocketError);
+    return 0;
+  }
+  return 1;
+}
@@ -0,0 +1,636 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: netem.c - Emulates loss, delay, duplication, reordering and rate limits on outgoing datagrams.
+--
+--
+-- PROGRAM: libsocket
+--
+-- FUNCTIONS:
+-- int attachNetem(struct socketStruct * socketPointer, struct netemConfig * config)
+-- int netemSend(struct netemShim * shim, struct destination * dest, const char * data, size_t dataLength)
+-- void getNetemStats(struct socketStruct * socketPointer, struct netemStats * stats)
+-- void detachNetem(struct socketStruct * socketPointer)
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- NOTES:
+-- Once a shim is attached to a UDP socket, sendData and sendDataGroup hand datagrams to netemSend instead
+-- of the kernel. For each datagram netemSend decides, in this order:
+--     lost        dropped with probability lossRate, taking no bandwidth
+--     departure   with rateBitsPerSecond set, datagrams leave one after another at that rate
+--     delay       delayMicroseconds plus a jitter sample drawn from delayDistribution
+--     reordered   with probability reorderRate the delay is skipped, so the datagram overtakes those
+--                 already waiting
+--     duplicated  with probability duplicateRate a second copy is scheduled with its own jitter
+-- Datagrams wait in a heap ordered by due time, and a delivery thread sends each one when it is due.
+-- When queueLimit datagrams are already waiting, new ones are dropped as a full router queue would.
+-- Jitter larger than the gap between datagrams reorders them naturally.
+--
+-- Every decision comes from a generator seeded with config->seed, so the same sequence of sends always
+-- meets the same losses, delays and duplicates. Only the send order has to be repeatable, which is the
+-- case when one thread sends on the socket. The shim only affects traffic leaving the socket; attach one
+-- at each end to disturb both directions. No privileges are needed.
+----------------------------------------------------------------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include "include/netem.h"
+#include "include/internal.h"
+
+static void *deliveryLoop(void *argument);
+static int32_t schedulePacket(struct netemShim *shim, struct destination *dest, const char *data, size_t dataLength, int64_t due);
+static void pushQueue(struct netemShim *shim, struct netemPacket *packet);
+static struct netemPacket *popQueue(struct netemShim *shim);
+static int32_t packetBefore(struct netemPacket *first, struct netemPacket *second);
+static int64_t sampleJitter(struct netemShim *shim);
+static double nextRandom(struct netemShim *shim);
+static void registerNetemHooks();
+
+static pthread_once_t netemHooksOnce = PTHREAD_ONCE_INIT;
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: attachNetem
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS: October 18, 2026
+--              -Registers the emulator functions with socket.c
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int attachNetem(struct socketStruct * socketPointer, struct netemConfig * config)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct of a UDP socket
+--                struct netemConfig * config: The conditions to emulate. Rates are probabilities from 0 to
+--                                             1, rateBitsPerSecond 0 means unlimited and queueLimit 0
+--                                             uses NETEM_DEFAULT_QUEUE.
+--
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used to start emulating a network on a socket and starts its delivery thread. Like
+-- initializing a socket, it must not overlap with other calls on the socket.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t attachNetem(struct socketStruct *socketPointer, struct netemConfig *config)
+{
+  struct netemShim *shim;
+  pthread_condattr_t conditionAttributes;
+
+  if (socketPointer == 0)
+  {
+    logger("ERROR > invalid socket passed to attachNetem", -1);
+    return 0;
+  }
+  if (config == 0 || getSocketHook(socketPointer->socketDescriptor, HOOK_NETEM) != 0 || config->delayMicroseconds < 0 || config->jitterMicroseconds < 0 ||
+      config->delayDistribution < NETEM_UNIFORM || config->delayDistribution > NETEM_PARETO)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid config passed to attachNetem", lastSocketError);
+    return 0;
+  }
+  if ((shim = calloc(1, sizeof(struct netemShim))) == 0)
+  {
+    lastSocketError = ERR_NOMEMORY;
+    logger("ERROR > unable to allocate network emulator", lastSocketError);
+    return 0;
+  }
+
+  shim->config = *config;
+  shim->config.queueLimit = config->queueLimit == 0 ? NETEM_DEFAULT_QUEUE : config->queueLimit;
+  shim->socketDescriptor = socketPointer->socketDescriptor;
+  shim->randomState = config->seed;
+  shim->running = 1;
+  if ((shim->queue = malloc(shim->config.queueLimit * sizeof(struct netemPacket *))) == 0)
+  {
+    lastSocketError = ERR_NOMEMORY;
+    logger("ERROR > unable to allocate network emulator queue", lastSocketError);
+    free(shim);
+    return 0;
+  }
+
+  pthread_mutex_init(&shim->lock, 0);
+  pthread_condattr_init(&conditionAttributes);
+  pthread_condattr_setclock(&conditionAttributes, CLOCK_MONOTONIC);
+  pthread_cond_init(&shim->wake, &conditionAttributes);
+  pthread_condattr_destroy(&conditionAttributes);
+
+  if (pthread_create(&shim->deliveryThread, 0, deliveryLoop, shim) != 0)
+  {
+    lastSocketError = ERR_NOMEMORY;
+    logger("ERROR > unable to start network emulator thread", lastSocketError);
+    pthread_cond_destroy(&shim->wake);
+    pthread_mutex_destroy(&shim->lock);
+    free(shim->queue);
+    free(shim);
+    return 0;
+  }
+
+  pthread_once(&netemHooksOnce, registerNetemHooks);
+  if (!exchangeSocketHook(socketPointer->socketDescriptor, HOOK_NETEM, shim, 0))
+  {
+    logger("ERROR > unable to attach network emulator", lastSocketError);
+    pthread_mutex_lock(&shim->lock);
+    shim->running = 0;
+    pthread_cond_signal(&shim->wake);
+    pthread_mutex_unlock(&shim->lock);
+    pthread_join(shim->deliveryThread, 0);
+    pthread_cond_destroy(&shim->wake);
+    pthread_mutex_destroy(&shim->lock);
+    free(shim->queue);
+    free(shim);
+    return 0;
+  }
+  return 1;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: netemSend
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int netemSend(struct netemShim * shim, struct destination * dest, const char * data,
+--                          size_t dataLength)
+--                struct netemShim * shim: The shim of the sending socket
+--                struct destination * dest: Where the datagram is going
+--                const char * data: The datagram
+--                size_t dataLength: The length of the datagram
+--
+-- RETURNS: 1 once the datagram has been lost, queued or dropped by the emulated network. 0 if it could not
+--          be copied, with lastSocketError set to ERR_NOMEMORY.
+--
+-- NOTES:
+-- This function is called by sendData and sendDataGroup for sockets with a shim. As on a real network, a
+-- lost datagram is still reported as sent.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t netemSend(struct netemShim *shim, struct destination *dest, const char *data, size_t dataLength)
+{
+  int64_t now = monotonicMicroseconds();
+  int64_t departure;
+  int64_t due;
+  int32_t result = 1;
+
+  pthread_mutex_lock(&shim->lock);
+  shim->stats.packets++;
+
+  if (nextRandom(shim) < shim->config.lossRate)
+  {
+    shim->stats.lost++;
+    pthread_mutex_unlock(&shim->lock);
+    return 1;
+  }
+
+  departure = now;
+  if (shim->config.rateBitsPerSecond > 0)
+  {
+    departure = shim->lastDeparture > now ? shim->lastDeparture : now;
+    departure += (int64_t)(dataLength * 8 * 1000000 / shim->config.rateBitsPerSecond);
+    shim->lastDeparture = departure;
+  }
+
+  if (nextRandom(shim) < shim->config.reorderRate)
+  {
+    shim->stats.reordered++;
+    due = departure;
+  }
+  else
+  {
+    due = departure + shim->config.delayMicroseconds + sampleJitter(shim);
+  }
+  result = schedulePacket(shim, dest, data, dataLength, due < now ? now : due);
+
+  if (result && nextRandom(shim) < shim->config.duplicateRate)
+  {
+    shim->stats.duplicated++;
+    due = departure + shim->config.delayMicroseconds + sampleJitter(shim);
+    result = schedulePacket(shim, dest, data, dataLength, due < now ? now : due);
+  }
+
+  pthread_mutex_unlock(&shim->lock);
+  return result;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: getNetemStats
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: void getNetemStats(struct socketStruct * socketPointer, struct netemStats * stats)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct with a shim
+--                struct netemStats * stats: Filled with what the emulated network did so far
+--
+-- RETURNS: void.
+--
+-- NOTES:
+-- This function is used to see how many datagrams were lost, duplicated, reordered, dropped for a full
+-- queue and finally delivered to the kernel. Sockets without a shim report all zeros.
+----------------------------------------------------------------------------------------------------------------------*/
+void getNetemStats(struct socketStruct *socketPointer, struct netemStats *stats)
+{
+  struct netemShim *shim;
+
+  memset(stats, 0, sizeof(struct netemStats));
+  if (socketPointer == 0 || (shim = getSocketHook(socketPointer->socketDescriptor, HOOK_NETEM)) == 0)
+  {
+    return;
+  }
+  pthread_mutex_lock(&shim->lock);
+  *stats = shim->stats;
+  pthread_mutex_unlock(&shim->lock);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: detachNetem
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS: October 18, 2026
+--              -Called by closeSocket
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: void detachNetem(struct socketStruct * socketPointer)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct with a shim
+--
+-- RETURNS: void.
+--
+-- NOTES:
+-- This function is used to stop emulating and send directly again. The delivery thread is stopped and
+-- datagrams still waiting are discarded, as if the emulated link went down. closeSocket calls it before
+-- closing the descriptor, so the delivery thread never sends on a closed or reused descriptor.
+----------------------------------------------------------------------------------------------------------------------*/
+void detachNetem(struct socketStruct *socketPointer)
+{
+  struct netemShim *shim;
+
+  if (socketPointer == 0 || (shim = getSocketHook(socketPointer->socketDescriptor, HOOK_NETEM)) == 0)
+  {
+    return;
+  }
+  exchangeSocketHook(socketPointer->socketDescriptor, HOOK_NETEM, 0, 0);
+
+  pthread_mutex_lock(&shim->lock);
+  shim->running = 0;
+  pthread_cond_signal(&shim->wake);
+  pthread_mutex_unlock(&shim->lock);
+  pthread_join(shim->deliveryThread, 0);
+
+  while (shim->queueLength > 0)
+  {
+    free(popQueue(shim));
+  }
+  pthread_cond_destroy(&shim->wake);
+  pthread_mutex_destroy(&shim->lock);
+  free(shim->queue);
+  free(shim);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: deliveryLoop
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static void * deliveryLoop(void * argument)
+--                void * argument: The netemShim to deliver for
+--
+-- RETURNS: Null when the shim is detached.
+--
+-- NOTES:
+-- Sleeps until the earliest datagram is due, then sends every datagram that is due. The lock is released
+-- while sending so netemSend never waits on the kernel.
+----------------------------------------------------------------------------------------------------------------------*/
+static void *deliveryLoop(void *argument)
+{
+  struct netemShim *shim = argument;
+  struct netemPacket *packet;
+  struct sockaddr_in destSockAddr;
+  struct timespec wakeTime;
+  ssize_t sendResult;
+  int64_t due;
+
+  memset(&destSockAddr, 0, sizeof(destSockAddr));
+  destSockAddr.sin_family = AF_INET;
+
+  pthread_mutex_lock(&shim->lock);
+  while (shim->running)
+  {
+    if (shim->queueLength == 0)
+    {
+      pthread_cond_wait(&shim->wake, &shim->lock);
+      continue;
+    }
+    due = shim->queue[0]->due;
+    if (due > monotonicMicroseconds())
+    {
+      wakeTime.tv_sec = due / 1000000;
+      wakeTime.tv_nsec = (due % 1000000) * 1000;
+      pthread_cond_timedwait(&shim->wake, &shim->lock, &wakeTime);
+      continue;
+    }
+
+    packet = popQueue(shim);
+    pthread_mutex_unlock(&shim->lock);
+
+    destSockAddr.sin_port = packet->dest.port;
+    destSockAddr.sin_addr.s_addr = packet->dest.address;
+    sendResult = sendto(shim->socketDescriptor, packet->data, packet->dataLength, 0, (struct sockaddr *)&destSockAddr, sizeof(destSockAddr));
+    free(packet);
+
+    pthread_mutex_lock(&shim->lock);
+    if (sendResult < 0)
+    {
+      shim->stats.sendErrors++;
+    }
+    else
+    {
+      shim->stats.delivered++;
+    }
+  }
+  pthread_mutex_unlock(&shim->lock);
+  return 0;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: schedulePacket
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static int schedulePacket(struct netemShim * shim, struct destination * dest, const char * data,
+--                                      size_t dataLength, int64_t due)
+--                struct netemShim * shim: The shim, locked by the caller
+--                struct destination * dest: Where the datagram is going
+--                const char * data: The datagram
+--                size_t dataLength: The length of the datagram
+--                int64_t due: When to deliver it, in monotonic microseconds
+--
+-- RETURNS: 1 if the datagram was queued or dropped for a full queue, 0 if it could not be copied.
+--
+-- NOTES:
+-- The sequence number keeps datagrams due at the same time in the order they were sent.
+----------------------------------------------------------------------------------------------------------------------*/
+static int32_t schedulePacket(struct netemShim *shim, struct destination *dest, const char *data, size_t dataLength, int64_t due)
+{
+  struct netemPacket *packet;
+
+  if (shim->queueLength == shim->config.queueLimit)
+  {
+    shim->stats.queueDrops++;
+    return 1;
+  }
+  if ((packet = malloc(sizeof(struct netemPacket) + dataLength)) == 0)
+  {
+    lastSocketError = ERR_NOMEMORY;
+    logger("ERROR > unable to queue datagram in network emulator", lastSocketError);
+    return 0;
+  }
+  packet->due = due;
+  packet->sequence = shim->sequence++;
+  packet->dest = *dest;
+  packet->dataLength = dataLength;
+  memcpy(packet->data, data, dataLength);
+
+  pushQueue(shim, packet);
+  if (shim->queue[0] == packet)
+  {
+    pthread_cond_signal(&shim->wake);
+  }
+  return 1;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: pushQueue
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static void pushQueue(struct netemShim * shim, struct netemPacket * packet)
+--                struct netemShim * shim: The shim, locked by the caller, with room in its queue
+--                struct netemPacket * packet: The datagram to add
+--
+-- RETURNS: void.
+--
+-- NOTES:
+-- Adds a datagram to the binary min heap and sifts it up.
+----------------------------------------------------------------------------------------------------------------------*/
+static void pushQueue(struct netemShim *shim, struct netemPacket *packet)
+{
+  uint32_t index = shim->queueLength++;
+  uint32_t parent;
+
+  while (index > 0)
+  {
+    parent = (index - 1) / 2;
+    if (!packetBefore(packet, shim->queue[parent]))
+    {
+      break;
+    }
+    shim->queue[index] = shim->queue[parent];
+    index = parent;
+  }
+  shim->queue[index] = packet;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: popQueue
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static struct netemPacket * popQueue(struct netemShim * shim)
+--                struct netemShim * shim: The shim, locked by the caller, with a non-empty queue
+--
+-- RETURNS: The datagram that is due first.
+--
+-- NOTES:
+-- Removes the top of the binary min heap and sifts the last entry down into its place.
+----------------------------------------------------------------------------------------------------------------------*/
+static struct netemPacket *popQueue(struct netemShim *shim)
+{
+  struct netemPacket *top = shim->queue[0];
+  struct netemPacket *last = shim->queue[--shim->queueLength];
+  uint32_t index = 0;
+  uint32_t child;
+
+  while ((child = index * 2 + 1) < shim->queueLength)
+  {
+    if (child + 1 < shim->queueLength && packetBefore(shim->queue[child + 1], shim->queue[child]))
+    {
+      child++;
+    }
+    if (!packetBefore(shim->queue[child], last))
+    {
+      break;
+    }
+    shim->queue[index] = shim->queue[child];
+    index = child;
+  }
+  if (shim->queueLength > 0)
+  {
+    shim->queue[index] = last;
+  }
+  return top;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: packetBefore
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static int packetBefore(struct netemPacket * first, struct netemPacket * second)
+--                struct netemPacket * first: A queued datagram
+--                struct netemPacket * second: Another queued datagram
+--
+-- RETURNS: 1 if first should be delivered before second, otherwise 0.
+----------------------------------------------------------------------------------------------------------------------*/
+static int32_t packetBefore(struct netemPacket *first, struct netemPacket *second)
+{
+  return first->due < second->due || (first->due == second->due && first->sequence < second->sequence);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: sampleJitter
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static int64_t sampleJitter(struct netemShim * shim)
+--                struct netemShim * shim: The shim, locked by the caller
+--
+-- RETURNS: A jitter sample in microseconds to add to the base delay.
+--
+-- NOTES:
+-- NETEM_UNIFORM is spread evenly over plus or minus jitterMicroseconds. NETEM_NORMAL has a standard
+-- deviation of jitterMicroseconds. NETEM_PARETO only adds delay, with a long tail of rare large spikes and
+-- a mean of jitterMicroseconds, which is closer to what congested links do.
+----------------------------------------------------------------------------------------------------------------------*/
+static int64_t sampleJitter(struct netemShim *shim)
+{
+  double jitter = shim->config.jitterMicroseconds;
+  double first;
+  double second;
+
+  if (jitter == 0)
+  {
+    return 0;
+  }
+  switch (shim->config.delayDistribution)
+  {
+  case NETEM_NORMAL:
+    // Box-Muller, the first sample must not be 0 for the logarithm
+    first = 1.0 - nextRandom(shim);
+    second = nextRandom(shim);
+    return (int64_t)(jitter * sqrt(-2.0 * log(first)) * cos(2.0 * M_PI * second));
+  case NETEM_PARETO:
+    // Shape 3 gives a mean of scale / 2, so a scale of twice the jitter
+    first = 1.0 - nextRandom(shim);
+    return (int64_t)(2.0 * jitter * (pow(first, -1.0 / 3.0) - 1.0));
+  default:
+    return (int64_t)(jitter * (2.0 * nextRandom(shim) - 1.0));
+  }
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: nextRandom
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static double nextRandom(struct netemShim * shim)
+--                struct netemShim * shim: The shim, locked by the caller
+--
+-- RETURNS: A uniform random number in [0, 1).
+--
+-- NOTES:
+-- SplitMix64, which gives a full quality sequence from any seed including 0.
+----------------------------------------------------------------------------------------------------------------------*/
+static double nextRandom(struct netemShim *shim)
+{
+  uint64_t value = (shim->randomState += 0x9E3779B97F4A7C15ULL);
+
+  value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+  value ^= value >> 31;
+  return (value >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: registerNetemHooks
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static void registerNetemHooks()
+--
+-- RETURNS: void.
+--
+-- NOTES:
+-- Run once by the first attachNetem, before any shim is published in the hook table, so that socket.c can
+-- reach netemSend and detachNetem without linking against netem.c.
+----------------------------------------------------------------------------------------------------------------------*/
+static void registerNetemHooks()
+{
+  hookFunctions.netemSend = netemSend;
+  hookFunctions.detachNetem = detachNetem;
+}
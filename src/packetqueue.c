@@ -0,0 +1,265 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: packetqueue.c - Bounded lock-free packet queues for passing datagrams between threads.
+--
+--
+-- PROGRAM: libsocket
+--
+-- FUNCTIONS:
+-- struct packetQueue * createPacketQueue(uint32_t capacity, uint32_t maxPacketSize, int32_t mode)
+-- int pushPacket(struct packetQueue * queue, struct destination * dest, const char * data, uint32_t dataLength)
+-- int popPacket(struct packetQueue * queue, struct destination * dest, char * dataBuffer, size_t dataBufferSize)
+-- void freePacketQueue(struct packetQueue * queue)
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- NOTES:
+-- A packetQueue is a fixed size ring of slots, each holding one packet and the destination it came from
+-- or is going to. Every slot carries a sequence number that tells producers and the consumer whether the
+-- slot is free or full, so no locks are needed. A QUEUE_SPSC queue must only be pushed to by one thread,
+-- a QUEUE_MPSC queue may be pushed to by any number of threads. In both modes only one thread may pop.
+-- Head, tail and the slots are kept on separate cache lines so producers and the consumer do not contend.
+----------------------------------------------------------------------------------------------------------------------*/
+
+#include "include/packetqueue.h"
+
+struct queueSlot{
+    _Atomic uint64_t sequence;
+    struct destination dest;
+    uint32_t dataLength;
+    char data[];
+};
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: createPacketQueue
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: struct packetQueue * createPacketQueue(uint32_t capacity, uint32_t maxPacketSize, int32_t mode)
+--                uint32_t capacity: The number of packets the queue can hold, rounded up to a power of two
+--                uint32_t maxPacketSize: The largest packet that can be pushed
+--                int32_t mode: QUEUE_SPSC for a single producer or QUEUE_MPSC for multiple producers
+--
+-- RETURNS: On success a pointer to the new queue is returned. On error a null pointer is returned and
+--          lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used to allocate a queue. All memory is allocated up front so pushing and popping
+-- never allocate.
+----------------------------------------------------------------------------------------------------------------------*/
+struct packetQueue *createPacketQueue(uint32_t capacity, uint32_t maxPacketSize, int32_t mode)
+{
+  struct packetQueue *queue;
+  uint64_t slotCount = 1;
+  uint64_t i;
+
+  if (capacity == 0 || (mode != QUEUE_SPSC && mode != QUEUE_MPSC))
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid capacity or mode passed to createPacketQueue", lastSocketError);
+    return 0;
+  }
+  while (slotCount < capacity)
+  {
+    slotCount <<= 1;
+  }
+
+  if ((queue = aligned_alloc(QUEUE_CACHE_LINE, sizeof(struct packetQueue))) == 0)
+  {
+    lastSocketError = ERR_NOMEMORY;
+    logger("ERROR > unable to allocate packet queue", lastSocketError);
+    return 0;
+  }
+  queue->mask = slotCount - 1;
+  queue->maxPacketSize = maxPacketSize;
+  queue->mode = mode;
+  queue->slotSize = (sizeof(struct queueSlot) + maxPacketSize + QUEUE_CACHE_LINE - 1) & ~(QUEUE_CACHE_LINE - 1);
+
+  if ((queue->slots = aligned_alloc(QUEUE_CACHE_LINE, slotCount * queue->slotSize)) == 0)
+  {
+    free(queue);
+    lastSocketError = ERR_NOMEMORY;
+    logger("ERROR > unable to allocate packet queue slots", lastSocketError);
+    return 0;
+  }
+  for (i = 0; i < slotCount; i++)
+  {
+    atomic_init(&((struct queueSlot *)(queue->slots + i * queue->slotSize))->sequence, i);
+  }
+  atomic_init(&queue->head, 0);
+  atomic_init(&queue->tail, 0);
+
+  return queue;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: pushPacket
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int pushPacket(struct packetQueue * queue, struct destination * dest, const char * data,
+--                           uint32_t dataLength)
+--                struct packetQueue * queue: The queue to push to
+--                struct destination * dest: The destination to store with the packet
+--                const char * data: The packet data
+--                uint32_t dataLength: The length of the packet data
+--
+-- RETURNS: On success 1 is returned. If the queue is full 0 is returned and lastSocketError is set to
+--          ERR_TIMEOUT. On error 0 is returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used to copy a packet into the queue without blocking. A full queue is an expected
+-- condition under load and is not logged.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t pushPacket(struct packetQueue *queue, struct destination *dest, const char *data, uint32_t dataLength)
+{
+  struct queueSlot *slot;
+  uint64_t position;
+  uint64_t sequence;
+  int64_t difference;
+
+  if (queue == 0 || dest == 0 || (data == 0 && dataLength != 0) || dataLength > queue->maxPacketSize)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid packet passed to pushPacket", lastSocketError);
+    return 0;
+  }
+
+  position = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+  for (;;)
+  {
+    slot = (struct queueSlot *)(queue->slots + (position & queue->mask) * queue->slotSize);
+    sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    difference = (int64_t)(sequence - position);
+
+    if (difference == 0)
+    {
+      if (queue->mode == QUEUE_SPSC)
+      {
+        atomic_store_explicit(&queue->tail, position + 1, memory_order_relaxed);
+        break;
+      }
+      if (atomic_compare_exchange_weak_explicit(&queue->tail, &position, position + 1, memory_order_relaxed, memory_order_relaxed))
+      {
+        break;
+      }
+    }
+    else if (difference < 0)
+    {
+      lastSocketError = ERR_TIMEOUT;
+      return 0;
+    }
+    else
+    {
+      position = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    }
+  }
+
+  slot->dest = *dest;
+  slot->dataLength = dataLength;
+  memcpy(slot->data, data, dataLength);
+  atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+  return 1;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: popPacket
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int popPacket(struct packetQueue * queue, struct destination * dest, char * dataBuffer,
+--                          size_t dataBufferSize)
+--                struct packetQueue * queue: The queue to pop from
+--                struct destination * dest: A destination struct to fill with the packet's destination
+--                char * dataBuffer: An array for the packet data to be placed into
+--                size_t dataBufferSize: The size of dataBuffer
+--
+-- RETURNS: On success the number of bytes placed into dataBuffer is returned. If the queue is empty -1 is
+--          returned and lastSocketError is set to ERR_TIMEOUT. On error -1 is returned and lastSocketError
+--          is set appropriately.
+--
+-- NOTES:
+-- This function is used to copy the oldest packet out of the queue without blocking. Packets larger than
+-- dataBuffer are truncated, as recvData does. Only one thread may pop from a queue.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t popPacket(struct packetQueue *queue, struct destination *dest, char *dataBuffer, size_t dataBufferSize)
+{
+  struct queueSlot *slot;
+  uint64_t position;
+  uint32_t dataLength;
+
+  if (queue == 0 || dest == 0 || dataBuffer == 0)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid queue or buffer passed to popPacket", lastSocketError);
+    return -1;
+  }
+
+  position = atomic_load_explicit(&queue->head, memory_order_relaxed);
+  slot = (struct queueSlot *)(queue->slots + (position & queue->mask) * queue->slotSize);
+  if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != position + 1)
+  {
+    lastSocketError = ERR_TIMEOUT;
+    return -1;
+  }
+
+  dataLength = slot->dataLength < dataBufferSize ? slot->dataLength : dataBufferSize;
+  *dest = slot->dest;
+  memcpy(dataBuffer, slot->data, dataLength);
+
+  atomic_store_explicit(&slot->sequence, position + queue->mask + 1, memory_order_release);
+  atomic_store_explicit(&queue->head, position + 1, memory_order_relaxed);
+  return dataLength;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: freePacketQueue
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: void freePacketQueue(struct packetQueue * queue)
+--                struct packetQueue * queue: The queue to free
+--
+-- RETURNS: void.
+--
+-- NOTES:
+-- This function is used to free a queue and any packets still in it.
+----------------------------------------------------------------------------------------------------------------------*/
+void freePacketQueue(struct packetQueue *queue)
+{
+  if (queue == 0)
+  {
+    return;
+  }
+  free(queue->slots);
+  free(queue);
+}
@@ -0,0 +1,465 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: ringrecv.c - Receives UDP datagrams for one port from a memory mapped AF_PACKET ring.
+--
+--
+-- PROGRAM: libsocket
+--
+-- FUNCTIONS:
+-- struct ringReceiver * openRingReceiver(uint16_t port, const char * interfaceName, uint32_t blockSize,
+--                                        uint32_t blockCount)
+-- int recvDataRing(struct ringReceiver * receiver, struct destination * source, const char ** payload,
+--                  int64_t waitMicroseconds)
+-- int getRingStats(struct ringReceiver * receiver, struct ringStats * stats)
+-- void closeRingReceiver(struct ringReceiver * receiver)
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- NOTES:
+-- This is an optional receive path for packet rates that recvData and recvDataBatch cannot keep up with.
+-- A TPACKET_V3 packet socket shares a ring of blocks with the kernel. The kernel fills a block with as
+-- many packets as fit, hands it to user space, and recvDataRing walks it without making a system call.
+-- A system call is only made to sleep when the ring is empty. A classic BPF filter attached to the packet
+-- socket drops everything except unfragmented IPv4 UDP datagrams for the port before they are copied in.
+--
+-- The packet socket only observes traffic. Datagrams are still delivered to any UDP socket bound to the
+-- port, and if none is bound the kernel also answers with ICMP port unreachable. Servers using this path
+-- should keep a UDP socket bound to the port, which is also what they send from. A packet socket needs
+-- CAP_NET_RAW. Works on any interface including loopback and veth pairs. Linux only.
+--
+-- AF_XDP would skip the network stack entirely but needs an XDP program loaded on the interface, so it is
+-- left out. TPACKET_V3 gives most of the gain with no extra dependencies.
+----------------------------------------------------------------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include "include/ringrecv.h"
+#include "include/capture.h"
+#include "include/internal.h"
+
+static int32_t attachPortFilter(int32_t socketDescriptor, uint16_t port);
+static int32_t waitForBlock(struct ringReceiver *receiver, int64_t deadline);
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: openRingReceiver
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: struct ringReceiver * openRingReceiver(uint16_t port, const char * interfaceName,
+--                                                   uint32_t blockSize, uint32_t blockCount)
+--                uint16_t port: The UDP port to receive for, in the same form bindPort takes
+--                const char * interfaceName: The interface to receive from, such as "eth0" or "lo", or null
+--                                            for every interface
+--                uint32_t blockSize: The size of each ring block, a power of two multiple of the page size,
+--                                    or 0 for RING_DEFAULT_BLOCK_SIZE
+--                uint32_t blockCount: The number of blocks, or 0 for RING_DEFAULT_BLOCK_COUNT
+--
+-- RETURNS: On success a receiver is returned. On error a null pointer is returned and lastSocketError is
+--          set appropriately. ERR_PERMISSION means the process lacks CAP_NET_RAW.
+--
+-- NOTES:
+-- This function is used to create the packet socket, attach the port filter and map the ring. The ring
+-- holds blockSize * blockCount bytes; a bigger ring absorbs longer bursts before the kernel drops packets.
+----------------------------------------------------------------------------------------------------------------------*/
+struct ringReceiver *openRingReceiver(uint16_t port, const char *interfaceName, uint32_t blockSize, uint32_t blockCount)
+{
+  struct ringReceiver *receiver;
+  struct tpacket_req3 request;
+  struct sockaddr_ll linkAddress;
+  int32_t version = TPACKET_V3;
+  int32_t ignoreOutgoing = 1;
+
+  blockSize = blockSize == 0 ? RING_DEFAULT_BLOCK_SIZE : blockSize;
+  blockCount = blockCount == 0 ? RING_DEFAULT_BLOCK_COUNT : blockCount;
+  if (blockSize % getpagesize() != 0 || (blockSize & (blockSize - 1)) != 0 || blockSize < RING_FRAME_SIZE)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid block size passed to openRingReceiver", lastSocketError);
+    return 0;
+  }
+
+  if ((receiver = calloc(1, sizeof(struct ringReceiver))) == 0)
+  {
+    lastSocketError = ERR_NOMEMORY;
+    logger("ERROR > unable to allocate ring receiver", lastSocketError);
+    return 0;
+  }
+  receiver->port = port;
+  receiver->blockSize = blockSize;
+  receiver->blockCount = blockCount;
+  receiver->ringSize = (size_t)blockSize * blockCount;
+
+  // No protocol yet, so nothing is queued before the filter is in place
+  if ((receiver->socketDescriptor = socket(AF_PACKET, SOCK_DGRAM | SOCK_CLOEXEC, 0)) == -1)
+  {
+    lastSocketError = errno == EPERM || errno == EACCES ? ERR_PERMISSION : ERR_UNKNOWN;
+    logger("ERROR > unable to create packet socket", lastSocketError);
+    free(receiver);
+    return 0;
+  }
+  if (!attachPortFilter(receiver->socketDescriptor, port))
+  {
+    closeRingReceiver(receiver);
+    return 0;
+  }
+#ifdef PACKET_IGNORE_OUTGOING
+  // Loopback shows every datagram twice, once outgoing, recvDataRing also skips them for older kernels
+  setsockopt(receiver->socketDescriptor, SOL_PACKET, PACKET_IGNORE_OUTGOING, &ignoreOutgoing, sizeof(ignoreOutgoing));
+#else
+  (void)ignoreOutgoing;
+#endif
+
+  memset(&request, 0, sizeof(request));
+  request.tp_block_size = blockSize;
+  request.tp_block_nr = blockCount;
+  request.tp_frame_size = RING_FRAME_SIZE;
+  request.tp_frame_nr = receiver->ringSize / RING_FRAME_SIZE;
+  request.tp_retire_blk_tov = RING_BLOCK_TIMEOUT;
+  if (setsockopt(receiver->socketDescriptor, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) == -1 ||
+      setsockopt(receiver->socketDescriptor, SOL_PACKET, PACKET_RX_RING, &request, sizeof(request)) == -1)
+  {
+    lastSocketError = errno == ENOMEM ? ERR_NOMEMORY : ERR_ILLEGALOP;
+    logger("ERROR > unable to create packet ring", lastSocketError);
+    closeRingReceiver(receiver);
+    return 0;
+  }
+  if ((receiver->ring = mmap(0, receiver->ringSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, receiver->socketDescriptor, 0)) == MAP_FAILED)
+  {
+    receiver->ring = 0;
+    lastSocketError = ERR_NOMEMORY;
+    logger("ERROR > unable to map packet ring", lastSocketError);
+    closeRingReceiver(receiver);
+    return 0;
+  }
+
+  memset(&linkAddress, 0, sizeof(linkAddress));
+  linkAddress.sll_family = AF_PACKET;
+  linkAddress.sll_protocol = htons(ETH_P_IP);
+  if (interfaceName != 0 && (linkAddress.sll_ifindex = if_nametoindex(interfaceName)) == 0)
+  {
+    lastSocketError = ERR_ADDRNOTAVAIL;
+    logger("ERROR > unknown interface passed to openRingReceiver", lastSocketError);
+    closeRingReceiver(receiver);
+    return 0;
+  }
+  if (bind(receiver->socketDescriptor, (struct sockaddr *)&linkAddress, sizeof(linkAddress)) == -1)
+  {
+    lastSocketError = errno == ENODEV ? ERR_ADDRNOTAVAIL : ERR_UNKNOWN;
+    logger("ERROR > unable to bind packet socket", lastSocketError);
+    closeRingReceiver(receiver);
+    return 0;
+  }
+
+  return receiver;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: recvDataRing
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int recvDataRing(struct ringReceiver * receiver, struct destination * source,
+--                             const char ** payload, int64_t waitMicroseconds)
+--                struct ringReceiver * receiver: A receiver created by openRingReceiver
+--                struct destination * source: Filled with the address and port the datagram came from
+--                const char ** payload: Set to point at the datagram payload inside the ring
+--                int64_t waitMicroseconds: How long to wait for a datagram, 0 to only check, or -1 to
+--                                          wait indefinitely
+--
+-- RETURNS: The payload length on success. -1 on error with lastSocketError set appropriately, or set to
+--          ERR_TIMEOUT if no datagram arrived in time.
+--
+-- NOTES:
+-- This function is used to take the next datagram from the ring without copying it. The payload stays
+-- valid until the next call to recvDataRing or closeRingReceiver, so copy anything that must be kept.
+-- A datagram larger than RING_FRAME_SIZE is truncated to what the ring captured. To record datagrams,
+-- attach a capture log to a socketStruct holding receiver->socketDescriptor.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t recvDataRing(struct ringReceiver *receiver, struct destination *source, const char **payload, int64_t waitMicroseconds)
+{
+  struct tpacket3_hdr *packet;
+  struct sockaddr_ll *linkAddress;
+  struct iphdr *ipHeader;
+  struct udphdr *udpHeader;
+  struct captureLog *capture;
+  uint32_t headerLength;
+  uint32_t payloadLength;
+  int64_t deadline;
+
+  if (receiver == 0)
+  {
+    logger("ERROR > invalid receiver passed to recvDataRing", -1);
+    return -1;
+  }
+  if (source == 0 || payload == 0)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid destination passed to recvDataRing", lastSocketError);
+    return -1;
+  }
+
+  deadline = waitMicroseconds < 0 ? -1 : monotonicMicroseconds() + waitMicroseconds;
+
+  for (;;)
+  {
+    if (receiver->packetsLeft == 0)
+    {
+      if (receiver->heldBlock != 0)
+      {
+        __atomic_store_n(&receiver->heldBlock->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+        receiver->heldBlock = 0;
+        receiver->currentBlock = (receiver->currentBlock + 1) % receiver->blockCount;
+      }
+      if (!waitForBlock(receiver, deadline))
+      {
+        return -1;
+      }
+      continue;
+    }
+
+    packet = (struct tpacket3_hdr *)receiver->nextPacket;
+    receiver->nextPacket += packet->tp_next_offset;
+    receiver->packetsLeft--;
+
+    linkAddress = (struct sockaddr_ll *)((char *)packet + TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
+    if (linkAddress->sll_pkttype == PACKET_OUTGOING)
+    {
+      continue;
+    }
+
+    // The filter only passes IPv4 UDP for our port, these checks guard against truncated captures
+    ipHeader = (struct iphdr *)((char *)packet + packet->tp_net);
+    headerLength = ipHeader->ihl * 4;
+    if (packet->tp_snaplen < sizeof(struct iphdr) || ipHeader->version != 4 || headerLength < sizeof(struct iphdr) ||
+        packet->tp_snaplen < headerLength + sizeof(struct udphdr) || ipHeader->protocol != IPPROTO_UDP)
+    {
+      continue;
+    }
+    udpHeader = (struct udphdr *)((char *)ipHeader + headerLength);
+    if (udpHeader->uh_dport != receiver->port || ntohs(udpHeader->uh_ulen) < sizeof(struct udphdr))
+    {
+      continue;
+    }
+
+    payloadLength = ntohs(udpHeader->uh_ulen) - sizeof(struct udphdr);
+    if (payloadLength > packet->tp_snaplen - headerLength - sizeof(struct udphdr))
+    {
+      payloadLength = packet->tp_snaplen - headerLength - sizeof(struct udphdr);
+    }
+    source->address = ipHeader->saddr;
+    source->port = udpHeader->uh_sport;
+    *payload = (const char *)udpHeader + sizeof(struct udphdr);
+    if ((capture = getSocketHook(receiver->socketDescriptor, HOOK_CAPTURE)) != 0)
+    {
+      capturePacket(capture, receiver->socketDescriptor, CAPTURE_RECV, source, *payload, payloadLength);
+    }
+    return payloadLength;
+  }
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: getRingStats
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int getRingStats(struct ringReceiver * receiver, struct ringStats * stats)
+--                struct ringReceiver * receiver: A receiver created by openRingReceiver
+--                struct ringStats * stats: Filled with the totals since the receiver was opened
+--
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used to see how many datagrams reached the ring, how many the kernel dropped because
+-- the ring was full, and how often the ring filled up completely.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t getRingStats(struct ringReceiver *receiver, struct ringStats *stats)
+{
+  struct tpacket_stats_v3 kernelStats;
+  socklen_t kernelStatsLength = sizeof(kernelStats);
+
+  if (receiver == 0)
+  {
+    logger("ERROR > invalid receiver passed to getRingStats", -1);
+    return 0;
+  }
+  if (stats == 0)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid stats passed to getRingStats", lastSocketError);
+    return 0;
+  }
+
+  // The kernel clears its counters on every read, so they are accumulated here
+  if (getsockopt(receiver->socketDescriptor, SOL_PACKET, PACKET_STATISTICS, &kernelStats, &kernelStatsLength) == -1)
+  {
+    lastSocketError = ERR_BADSOCK;
+    logger("ERROR > unable to read packet ring statistics", lastSocketError);
+    return 0;
+  }
+  receiver->stats.packets += kernelStats.tp_packets - kernelStats.tp_drops;
+  receiver->stats.drops += kernelStats.tp_drops;
+  receiver->stats.freezes += kernelStats.tp_freeze_q_cnt;
+  *stats = receiver->stats;
+  return 1;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: closeRingReceiver
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: void closeRingReceiver(struct ringReceiver * receiver)
+--                struct ringReceiver * receiver: The receiver to close
+--
+-- RETURNS: void.
+--
+-- NOTES:
+-- This function is used to unmap the ring, close the packet socket and free the receiver. A capture log
+-- attached to the packet socket is detached.
+----------------------------------------------------------------------------------------------------------------------*/
+void closeRingReceiver(struct ringReceiver *receiver)
+{
+  struct socketStruct ringSocket;
+
+  if (receiver == 0)
+  {
+    return;
+  }
+  ringSocket.socketDescriptor = receiver->socketDescriptor;
+  detachCapture(&ringSocket);
+  if (receiver->ring != 0)
+  {
+    munmap(receiver->ring, receiver->ringSize);
+  }
+  close(receiver->socketDescriptor);
+  free(receiver);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: attachPortFilter
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static int attachPortFilter(int32_t socketDescriptor, uint16_t port)
+--                int32_t socketDescriptor: The packet socket
+--                uint16_t port: The UDP destination port to accept, in network byte order
+--
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- The packet socket is SOCK_DGRAM so the filter sees the packet from the IP header on.
+----------------------------------------------------------------------------------------------------------------------*/
+static int32_t attachPortFilter(int32_t socketDescriptor, uint16_t port)
+{
+  struct sock_filter instructions[] = {
+      BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 9),                    // IP protocol
+      BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 0, 6),
+      BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 6),                    // Fragment offset
+      BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x1FFF, 4, 0),
+      BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 0),                   // IP header length
+      BPF_STMT(BPF_LD | BPF_H | BPF_IND, 2),                    // UDP destination port
+      BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ntohs(port), 0, 1),
+      BPF_STMT(BPF_RET | BPF_K, 0xFFFFFFFF),
+      BPF_STMT(BPF_RET | BPF_K, 0),
+  };
+  struct sock_fprog program;
+
+  program.len = sizeof(instructions) / sizeof(instructions[0]);
+  program.filter = instructions;
+  if (setsockopt(socketDescriptor, SOL_SOCKET, SO_ATTACH_FILTER, &program, sizeof(program)) == -1)
+  {
+    lastSocketError = errno == ENOMEM ? ERR_NOMEMORY : ERR_ILLEGALOP;
+    logger("ERROR > unable to attach port filter to packet socket", lastSocketError);
+    return 0;
+  }
+  return 1;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: waitForBlock
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static int waitForBlock(struct ringReceiver * receiver, int64_t deadline)
+--                struct ringReceiver * receiver: The receiver to wait on
+--                int64_t deadline: The monotonic time in microseconds to give up at, or -1 for never
+--
+-- RETURNS: 1 once the current block belongs to user space. 0 on timeout or error with lastSocketError set.
+--
+-- NOTES:
+-- Sleeps in poll only when the current block is still owned by the kernel. A partly filled block is
+-- handed over after RING_BLOCK_TIMEOUT milliseconds, which bounds the latency at low packet rates.
+----------------------------------------------------------------------------------------------------------------------*/
+static int32_t waitForBlock(struct ringReceiver *receiver, int64_t deadline)
+{
+  struct tpacket_block_desc *block;
+  struct pollfd pollDescriptor;
+  int64_t remaining;
+
+  block = (struct tpacket_block_desc *)(receiver->ring + (size_t)receiver->currentBlock * receiver->blockSize);
+  pollDescriptor.fd = receiver->socketDescriptor;
+  pollDescriptor.events = POLLIN | POLLERR;
+
+  while (!(__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER))
+  {
+    remaining = deadline < 0 ? -1 : deadline - monotonicMicroseconds();
+    if (deadline >= 0 && remaining <= 0)
+    {
+      lastSocketError = ERR_TIMEOUT;
+      return 0;
+    }
+    pollDescriptor.revents = 0;
+    if (poll(&pollDescriptor, 1, remaining < 0 ? -1 : (int)((remaining + 999) / 1000)) == -1 && errno != EINTR)
+    {
+      lastSocketError = ERR_BADSOCK;
+      logger("ERROR > failed to wait for packet ring", lastSocketError);
+      return 0;
+    }
+  }
+
+  receiver->heldBlock = block;
+  receiver->packetsLeft = block->hdr.bh1.num_pkts;
+  receiver->nextPacket = (char *)block + block->hdr.bh1.offset_to_first_pkt;
+  return 1;
+}
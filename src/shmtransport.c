@@ -0,0 +1,1110 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: shmtransport.c - Message channels that use shared memory between processes on the same host
+--                               and fall back to TCP otherwise.
+--
+--
+-- PROGRAM: libsocket
+--
+-- FUNCTIONS:
+-- struct localChannel * listenLocal(uint16_t port, uint32_t ringSize)
+-- struct localChannel * acceptLocal(struct localChannel * listener)
+-- struct localChannel * connectLocal(struct destination * dest)
+-- int sendLocal(struct localChannel * channel, const char * data, uint32_t dataLength)
+-- int recvLocal(struct localChannel * channel, char * dataBuffer, size_t dataBufferSize)
+-- int isLocalShared(struct localChannel * channel)
+-- void closeLocal(struct localChannel * channel)
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- NOTES:
+-- A localChannel carries whole messages in both directions, like a pair of sendData and recvData calls.
+-- listenLocal listens on a TCP port and on an abstract unix socket named after the same port. When
+-- connectLocal is given an address of this host it first tries the unix socket. The server then creates a
+-- memfd holding two single producer, single consumer byte rings, one per direction, and passes it over the
+-- unix socket. From then on messages are copied straight into the ring, and the other process is woken
+-- with a futex only when it is asleep waiting for data or space. The unix socket stays open so either side
+-- notices when the other process exits.
+--
+-- Abstract unix names are visible to every process on the host, so both sides check the credentials of
+-- the other end with SO_PEERCRED and only share memory with processes of the same user. Everything read
+-- back from the rings is bounds checked against the local copy of the ring size, and a channel whose
+-- ring holds a length that cannot be right is failed rather than read past its end.
+--
+-- If the destination is remote, or the server has no unix socket, the channel falls back to a TCP
+-- connection and frames each message with a 4 byte length. Callers use the same functions either way.
+-- Capture logs only see the TCP fallback, as the shared memory rings never touch a socket.
+-- Only one thread may send and one thread may receive on a channel at a time. Linux only.
+----------------------------------------------------------------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/syscall.h>
+#include <ifaddrs.h>
+#include <linux/futex.h>
+
+#include "include/shmtransport.h"
+
+#define SHM_WRAP            0xFFFFFFFFu
+#define SHM_MIN_RING        4096
+#define SHM_WAIT_NANOSECONDS 100000000
+#define SHM_NAME_FORMAT     "libsocket-%u"
+
+struct shmRing{
+    _Alignas(64) _Atomic uint64_t tail;
+    _Atomic uint32_t producerWaiting;
+    _Atomic uint32_t spaceSignal;
+    _Alignas(64) _Atomic uint64_t head;
+    _Atomic uint32_t consumerWaiting;
+    _Atomic uint32_t dataSignal;
+    _Alignas(64) _Atomic uint32_t closed;
+    uint32_t size;
+    _Alignas(64) char data[];
+};
+
+static struct localChannel *createChannel();
+static struct localChannel *acceptShared(struct localChannel *listener);
+static struct localChannel *connectShared(struct destination *dest);
+static int32_t mapRegion(struct localChannel *channel, int32_t memoryDescriptor, size_t regionSize, int32_t server);
+static int32_t isLocalAddress(uint32_t address);
+static int32_t peerGone(struct localChannel *channel);
+static int32_t peerTrusted(int32_t controlDescriptor);
+static int32_t failChannel(struct localChannel *channel);
+static void setControlName(struct sockaddr_un *controlAddress, socklen_t *controlAddressLength, uint16_t port);
+static void futexWait(_Atomic uint32_t *word, uint32_t expected);
+static void futexWake(_Atomic uint32_t *word);
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: listenLocal
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: struct localChannel * listenLocal(uint16_t port, uint32_t ringSize)
+--                uint16_t port: The port to listen on, in the same form bindPort takes
+--                uint32_t ringSize: The size in bytes of each shared memory ring, rounded up to a power of
+--                                   two. 0 uses LOCAL_DEFAULT_RING. A message may use at most half a ring.
+--
+-- RETURNS: On success a listening channel is returned. On error a null pointer is returned and
+--          lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used to create a channel that accepts both local and remote peers. If the unix socket
+-- for the port cannot be created, only TCP peers are accepted.
+----------------------------------------------------------------------------------------------------------------------*/
+struct localChannel *listenLocal(uint16_t port, uint32_t ringSize)
+{
+  struct localChannel *listener;
+  struct socketTuning tuning;
+  struct sockaddr_un controlAddress;
+  socklen_t controlAddressLength;
+
+  if ((listener = createChannel()) == 0)
+  {
+    return 0;
+  }
+
+  listener->ringSize = SHM_MIN_RING;
+  while (listener->ringSize < (ringSize == 0 ? LOCAL_DEFAULT_RING : ringSize))
+  {
+    listener->ringSize <<= 1;
+  }
+
+  memset(&tuning, 0, sizeof(tuning));
+  tuning.reuseAddress = 1;
+  tuning.noDelay = 1;
+  if ((listener->socket = createSocket()) == 0)
+  {
+    lastSocketError = ERR_NOMEMORY;
+    logger("ERROR > unable to allocate local channel socket", lastSocketError);
+    closeLocal(listener);
+    return 0;
+  }
+  if (!initSocketTCP(listener->socket))
+  {
+    freeSocket(listener->socket);
+    listener->socket = 0;
+    closeLocal(listener);
+    return 0;
+  }
+  tuneSocket(listener->socket, &tuning);
+  if (!bindPort(listener->socket, port) || !listenTCP(listener->socket, 0))
+  {
+    closeLocal(listener);
+    return 0;
+  }
+
+  setControlName(&controlAddress, &controlAddressLength, port);
+  if ((listener->controlDescriptor = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0)) != -1 &&
+      (bind(listener->controlDescriptor, (struct sockaddr *)&controlAddress, controlAddressLength) == -1 ||
+       listen(listener->controlDescriptor, SOMAXCONN) == -1))
+  {
+    logger("ERROR > unable to listen for local peers, using TCP only", ERR_ADDRINUSE);
+    close(listener->controlDescriptor);
+    listener->controlDescriptor = -1;
+  }
+
+  return listener;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: acceptLocal
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: struct localChannel * acceptLocal(struct localChannel * listener)
+--                struct localChannel * listener: A channel created by listenLocal
+--
+-- RETURNS: On success a connected channel is returned. On error a null pointer is returned and
+--          lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used to wait for and accept the next local or remote peer. Local peers are given a
+-- shared memory channel, remote peers a TCP one.
+----------------------------------------------------------------------------------------------------------------------*/
+struct localChannel *acceptLocal(struct localChannel *listener)
+{
+  struct localChannel *channel;
+  struct pollfd pollDescriptors[2];
+  struct destination peer;
+  int32_t descriptorCount;
+
+  if (listener == 0 || listener->socket == 0)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid listener passed to acceptLocal", lastSocketError);
+    return 0;
+  }
+
+  pollDescriptors[0].fd = listener->socket->socketDescriptor;
+  pollDescriptors[0].events = POLLIN;
+  pollDescriptors[1].fd = listener->controlDescriptor;
+  pollDescriptors[1].events = POLLIN;
+  descriptorCount = listener->controlDescriptor == -1 ? 1 : 2;
+
+  for (;;)
+  {
+    pollDescriptors[0].revents = 0;
+    pollDescriptors[1].revents = 0;
+    if (poll(pollDescriptors, descriptorCount, -1) == -1)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      lastSocketError = ERR_BADSOCK;
+      logger("ERROR > failed to wait for local peers", lastSocketError);
+      return 0;
+    }
+
+    if (descriptorCount == 2 && pollDescriptors[1].revents != 0)
+    {
+      if ((channel = acceptShared(listener)) != 0)
+      {
+        return channel;
+      }
+      continue;
+    }
+    if (pollDescriptors[0].revents != 0)
+    {
+      if ((channel = createChannel()) == 0)
+      {
+        return 0;
+      }
+      if (acceptClients(listener->socket, &channel->socket, &peer, 1) != 1)
+      {
+        closeLocal(channel);
+        if (lastSocketError == ERR_TIMEOUT)
+        {
+          continue;
+        }
+        return 0;
+      }
+      // acceptClients hands out non-blocking sockets, recvLocal expects to block
+      fcntl(channel->socket->socketDescriptor, F_SETFL, fcntl(channel->socket->socketDescriptor, F_GETFL) & ~O_NONBLOCK);
+      return channel;
+    }
+  }
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: connectLocal
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: struct localChannel * connectLocal(struct destination * dest)
+--                struct destination * dest: The address and port of a listenLocal channel
+--
+-- RETURNS: On success a connected channel is returned. On error a null pointer is returned and
+--          lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used to connect to a listenLocal channel. Shared memory is used when dest is an address
+-- of this host and the server accepts local peers, otherwise a TCP connection is made.
+----------------------------------------------------------------------------------------------------------------------*/
+struct localChannel *connectLocal(struct destination *dest)
+{
+  struct localChannel *channel;
+  struct socketTuning tuning;
+
+  if (dest == 0)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid destination passed to connectLocal", lastSocketError);
+    return 0;
+  }
+
+  if (isLocalAddress(dest->address) && (channel = connectShared(dest)) != 0)
+  {
+    return channel;
+  }
+
+  if ((channel = createChannel()) == 0)
+  {
+    return 0;
+  }
+  memset(&tuning, 0, sizeof(tuning));
+  tuning.noDelay = 1;
+  if ((channel->socket = createSocket()) == 0)
+  {
+    lastSocketError = ERR_NOMEMORY;
+    logger("ERROR > unable to allocate local channel socket", lastSocketError);
+    closeLocal(channel);
+    return 0;
+  }
+  if (!initSocketTCP(channel->socket))
+  {
+    freeSocket(channel->socket);
+    channel->socket = 0;
+    closeLocal(channel);
+    return 0;
+  }
+  tuneSocket(channel->socket, &tuning);
+  if (!connectPort(channel->socket, dest))
+  {
+    closeLocal(channel);
+    return 0;
+  }
+  return channel;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: sendLocal
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS: October 18, 2026
+--              -Use the local copy of the ring size instead of the one in shared memory
+--              -Fail once either side has closed or failed the channel
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int sendLocal(struct localChannel * channel, const char * data, uint32_t dataLength)
+--                struct localChannel * channel: A connected channel
+--                const char * data: A char array containing the message to be sent
+--                uint32_t dataLength: The length of the message, at least 1
+--
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used to send one message. It blocks while the ring or socket buffer is full. If the
+-- peer has gone away lastSocketError is set to ERR_CONRESET.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t sendLocal(struct localChannel *channel, const char *data, uint32_t dataLength)
+{
+  struct shmRing *ring;
+  uint64_t head;
+  uint64_t tail;
+  uint64_t offset;
+  uint64_t contiguous;
+  uint64_t needed;
+  uint64_t total;
+  uint32_t signal;
+  uint32_t frameLength;
+
+  if (channel == 0 || (channel->socket == 0 && channel->sendRing == 0))
+  {
+    logger("ERROR > invalid channel passed to sendLocal", -1);
+    return 0;
+  }
+  if (data == 0 || dataLength == 0)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid data passed to sendLocal", lastSocketError);
+    return 0;
+  }
+
+  if (channel->sendRing == 0)
+  {
+    if (channel->frameBufferSize < dataLength + sizeof(frameLength))
+    {
+      free(channel->frameBuffer);
+      channel->frameBufferSize = dataLength + sizeof(frameLength);
+      if ((channel->frameBuffer = malloc(channel->frameBufferSize)) == 0)
+      {
+        channel->frameBufferSize = 0;
+        lastSocketError = ERR_NOMEMORY;
+        logger("ERROR > unable to allocate local channel frame", lastSocketError);
+        return 0;
+      }
+    }
+    frameLength = htonl(dataLength);
+    memcpy(channel->frameBuffer, &frameLength, sizeof(frameLength));
+    memcpy(channel->frameBuffer + sizeof(frameLength), data, dataLength);
+    return sendDataTCP(channel->socket, channel->frameBuffer, dataLength + sizeof(frameLength));
+  }
+
+  ring = channel->sendRing;
+  if (atomic_load_explicit(&ring->closed, memory_order_relaxed))
+  {
+    lastSocketError = ERR_CONRESET;
+    logger("ERROR > local channel is closed", lastSocketError);
+    return 0;
+  }
+  needed = (sizeof(uint32_t) + dataLength + 7) & ~(uint64_t)7;
+  if (needed > channel->ringSize / 2)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > message too large for local channel", lastSocketError);
+    return 0;
+  }
+
+  tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  offset = tail & (channel->ringSize - 1);
+  contiguous = channel->ringSize - offset;
+  total = contiguous < needed ? contiguous + needed : needed;
+
+  for (;;)
+  {
+    head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (tail + total - head <= channel->ringSize)
+    {
+      break;
+    }
+    if (peerGone(channel))
+    {
+      lastSocketError = ERR_CONRESET;
+      logger("ERROR > local channel peer disconnected", lastSocketError);
+      return 0;
+    }
+    signal = atomic_load(&ring->spaceSignal);
+    atomic_store(&ring->producerWaiting, 1);
+    if (tail + total - atomic_load(&ring->head) > channel->ringSize)
+    {
+      futexWait(&ring->spaceSignal, signal);
+    }
+    atomic_store(&ring->producerWaiting, 0);
+  }
+
+  if (contiguous < needed)
+  {
+    *(uint32_t *)(ring->data + offset) = SHM_WRAP;
+    tail += contiguous;
+    offset = 0;
+  }
+  *(uint32_t *)(ring->data + offset) = dataLength;
+  memcpy(ring->data + offset + sizeof(uint32_t), data, dataLength);
+  atomic_store_explicit(&ring->tail, tail + needed, memory_order_release);
+
+  atomic_thread_fence(memory_order_seq_cst);
+  if (atomic_load_explicit(&ring->consumerWaiting, memory_order_relaxed))
+  {
+    futexWake(&ring->dataSignal);
+  }
+  return 1;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: recvLocal
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS: October 18, 2026
+--              -Reject message lengths that run past the end of the ring
+--              -Use the local copy of the ring size instead of the one in shared memory
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int recvLocal(struct localChannel * channel, char * dataBuffer, size_t dataBufferSize)
+--                struct localChannel * channel: A connected channel
+--                char * dataBuffer: An array for the message to be placed into
+--                size_t dataBufferSize: The size of dataBuffer
+--
+-- RETURNS: The number of bytes placed into dataBuffer, 0 if the other side disconnected, or -1 on error
+--          with lastSocketError set appropriately.
+--
+-- NOTES:
+-- This function is used to receive one message, blocking until one arrives. Messages larger than
+-- dataBuffer are truncated and the rest is discarded, as recvData does. If a shared memory ring holds a
+-- message length that runs past the end of the ring, the channel is closed and ERR_CONRESET is reported.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t recvLocal(struct localChannel *channel, char *dataBuffer, size_t dataBufferSize)
+{
+  struct shmRing *ring;
+  uint64_t head;
+  uint64_t offset;
+  uint32_t signal;
+  uint32_t messageLength;
+  uint32_t copyLength;
+  uint32_t remaining;
+  int32_t result;
+
+  if (channel == 0 || (channel->socket == 0 && channel->recvRing == 0))
+  {
+    logger("ERROR > invalid channel passed to recvLocal", -1);
+    return -1;
+  }
+  if (dataBuffer == 0)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid data passed to recvLocal", lastSocketError);
+    return -1;
+  }
+
+  if (channel->recvRing == 0)
+  {
+    if ((result = recvDataTCP(channel->socket, (char *)&messageLength, sizeof(messageLength))) <= 0)
+    {
+      return result;
+    }
+    messageLength = ntohl(messageLength);
+    copyLength = messageLength < dataBufferSize ? messageLength : dataBufferSize;
+    if ((result = recvDataTCP(channel->socket, dataBuffer, copyLength)) <= 0 && copyLength > 0)
+    {
+      return result;
+    }
+    for (remaining = messageLength - copyLength; remaining > 0; remaining -= result)
+    {
+      if ((result = recvDataTCP(channel->socket, dataBuffer, remaining < dataBufferSize ? remaining : dataBufferSize)) <= 0)
+      {
+        return result;
+      }
+    }
+    return copyLength;
+  }
+
+  ring = channel->recvRing;
+  head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+  for (;;)
+  {
+    if (atomic_load_explicit(&ring->tail, memory_order_acquire) != head)
+    {
+      offset = head & (channel->ringSize - 1);
+      messageLength = *(uint32_t *)(ring->data + offset);
+      if (messageLength != SHM_WRAP)
+      {
+        break;
+      }
+      head += channel->ringSize - offset;
+      continue;
+    }
+    if (peerGone(channel))
+    {
+      return 0;
+    }
+    signal = atomic_load(&ring->dataSignal);
+    atomic_store(&ring->consumerWaiting, 1);
+    if (atomic_load(&ring->tail) == head)
+    {
+      futexWait(&ring->dataSignal, signal);
+    }
+    atomic_store(&ring->consumerWaiting, 0);
+  }
+
+  // Messages never wrap, so one running past the end of the ring was not written by sendLocal
+  if (messageLength > channel->ringSize - offset - sizeof(uint32_t))
+  {
+    return failChannel(channel);
+  }
+  copyLength = messageLength < dataBufferSize ? messageLength : dataBufferSize;
+  memcpy(dataBuffer, ring->data + offset + sizeof(uint32_t), copyLength);
+  atomic_store_explicit(&ring->head, head + ((sizeof(uint32_t) + messageLength + 7) & ~(uint64_t)7), memory_order_release);
+
+  atomic_thread_fence(memory_order_seq_cst);
+  if (atomic_load_explicit(&ring->producerWaiting, memory_order_relaxed))
+  {
+    futexWake(&ring->spaceSignal);
+  }
+  return copyLength;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: isLocalShared
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int isLocalShared(struct localChannel * channel)
+--                struct localChannel * channel: A connected channel
+--
+-- RETURNS: 1 if the channel uses shared memory, 0 if it uses TCP.
+--
+-- NOTES:
+-- This function is used to find out which transport a channel ended up with.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t isLocalShared(struct localChannel *channel)
+{
+  return channel != 0 && channel->region != 0;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: closeLocal
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: void closeLocal(struct localChannel * channel)
+--                struct localChannel * channel: The channel to close
+--
+-- RETURNS: void.
+--
+-- NOTES:
+-- This function is used to close a channel and free it. A peer blocked in sendLocal or recvLocal on a
+-- shared memory channel is woken and told the channel is closed.
+----------------------------------------------------------------------------------------------------------------------*/
+void closeLocal(struct localChannel *channel)
+{
+  if (channel == 0)
+  {
+    return;
+  }
+  if (channel->region != 0)
+  {
+    atomic_store(&channel->sendRing->closed, 1);
+    atomic_store(&channel->recvRing->closed, 1);
+    futexWake(&channel->sendRing->dataSignal);
+    futexWake(&channel->recvRing->spaceSignal);
+    munmap(channel->region, channel->regionSize);
+  }
+  if (channel->controlDescriptor != -1)
+  {
+    close(channel->controlDescriptor);
+  }
+  if (channel->socket != 0)
+  {
+    closeSocket(channel->socket);
+    freeSocket(channel->socket);
+  }
+  free(channel->frameBuffer);
+  free(channel);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: createChannel
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static struct localChannel * createChannel()
+--
+-- RETURNS: An empty channel, or a null pointer with lastSocketError set to ERR_NOMEMORY.
+--
+-- NOTES:
+-- Allocates a channel with no transport attached.
+----------------------------------------------------------------------------------------------------------------------*/
+static struct localChannel *createChannel()
+{
+  struct localChannel *channel;
+
+  if ((channel = calloc(1, sizeof(struct localChannel))) == 0)
+  {
+    lastSocketError = ERR_NOMEMORY;
+    logger("ERROR > unable to allocate local channel", lastSocketError);
+    return 0;
+  }
+  channel->controlDescriptor = -1;
+  return channel;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: acceptShared
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS: October 18, 2026
+--              -Only accept peers of the same user
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static struct localChannel * acceptShared(struct localChannel * listener)
+--                struct localChannel * listener: A listening channel with a unix socket
+--
+-- RETURNS: A shared memory channel, or a null pointer with lastSocketError set appropriately.
+--
+-- NOTES:
+-- Accepts a local peer, creates the shared memory for it and sends the memfd across the unix socket
+-- together with the ring size. Peers running as another user are turned away with ERR_PERMISSION, as
+-- anyone on the host can connect to the abstract name.
+----------------------------------------------------------------------------------------------------------------------*/
+static struct localChannel *acceptShared(struct localChannel *listener)
+{
+  struct localChannel *channel;
+  struct msghdr message;
+  struct iovec dataVector;
+  struct cmsghdr *controlMessage;
+  char control[CMSG_SPACE(sizeof(int32_t))] __attribute__((aligned(8)));
+  size_t regionSize = 2 * (sizeof(struct shmRing) + listener->ringSize);
+  int32_t memoryDescriptor;
+
+  if ((channel = createChannel()) == 0)
+  {
+    return 0;
+  }
+  if ((channel->controlDescriptor = accept4(listener->controlDescriptor, 0, 0, SOCK_CLOEXEC)) == -1)
+  {
+    lastSocketError = errno == EAGAIN || errno == ECONNABORTED ? ERR_TIMEOUT : ERR_UNKNOWN;
+    closeLocal(channel);
+    return 0;
+  }
+  if (!peerTrusted(channel->controlDescriptor))
+  {
+    lastSocketError = ERR_PERMISSION;
+    logger("ERROR > local peer belongs to another user", lastSocketError);
+    closeLocal(channel);
+    return 0;
+  }
+  if ((memoryDescriptor = memfd_create("libsocket-channel", MFD_CLOEXEC)) == -1 ||
+      ftruncate(memoryDescriptor, regionSize) == -1)
+  {
+    lastSocketError = ERR_NOMEMORY;
+    logger("ERROR > unable to create shared memory for local channel", lastSocketError);
+    if (memoryDescriptor != -1)
+    {
+      close(memoryDescriptor);
+    }
+    closeLocal(channel);
+    return 0;
+  }
+  channel->ringSize = listener->ringSize;
+  if (!mapRegion(channel, memoryDescriptor, regionSize, 1))
+  {
+    close(memoryDescriptor);
+    closeLocal(channel);
+    return 0;
+  }
+  channel->sendRing->size = channel->ringSize;
+  channel->recvRing->size = channel->ringSize;
+
+  memset(&message, 0, sizeof(message));
+  memset(control, 0, sizeof(control));
+  dataVector.iov_base = &channel->ringSize;
+  dataVector.iov_len = sizeof(channel->ringSize);
+  message.msg_iov = &dataVector;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+  controlMessage = CMSG_FIRSTHDR(&message);
+  controlMessage->cmsg_level = SOL_SOCKET;
+  controlMessage->cmsg_type = SCM_RIGHTS;
+  controlMessage->cmsg_len = CMSG_LEN(sizeof(int32_t));
+  memcpy(CMSG_DATA(controlMessage), &memoryDescriptor, sizeof(int32_t));
+
+  if (sendmsg(channel->controlDescriptor, &message, MSG_NOSIGNAL) == -1)
+  {
+    lastSocketError = ERR_CONRESET;
+    logger("ERROR > unable to pass shared memory to local peer", lastSocketError);
+    close(memoryDescriptor);
+    closeLocal(channel);
+    return 0;
+  }
+  close(memoryDescriptor);
+  return channel;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: connectShared
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS: October 18, 2026
+--              -Only use servers of the same user and check the ring size
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static struct localChannel * connectShared(struct destination * dest)
+--                struct destination * dest: The address and port of a listenLocal channel on this host
+--
+-- RETURNS: A shared memory channel, or a null pointer if the server does not accept local peers.
+--
+-- NOTES:
+-- Connects to the unix socket for dest->port and maps the memfd the server sends back. A server running
+-- as another user, or one sending a ring size that is not a power of two, is not used. Failures are not
+-- logged because connectLocal falls back to TCP.
+----------------------------------------------------------------------------------------------------------------------*/
+static struct localChannel *connectShared(struct destination *dest)
+{
+  struct localChannel *channel;
+  struct sockaddr_un controlAddress;
+  socklen_t controlAddressLength;
+  struct msghdr message;
+  struct iovec dataVector;
+  struct cmsghdr *controlMessage;
+  struct stat memoryStatus;
+  char control[CMSG_SPACE(sizeof(int32_t))] __attribute__((aligned(8)));
+  int32_t memoryDescriptor = -1;
+  ssize_t result;
+
+  if ((channel = createChannel()) == 0)
+  {
+    return 0;
+  }
+
+  setControlName(&controlAddress, &controlAddressLength, dest->port);
+  if ((channel->controlDescriptor = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0)) == -1 ||
+      connect(channel->controlDescriptor, (struct sockaddr *)&controlAddress, controlAddressLength) == -1 ||
+      !peerTrusted(channel->controlDescriptor))
+  {
+    closeLocal(channel);
+    return 0;
+  }
+
+  memset(&message, 0, sizeof(message));
+  dataVector.iov_base = &channel->ringSize;
+  dataVector.iov_len = sizeof(channel->ringSize);
+  message.msg_iov = &dataVector;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+  while ((result = recvmsg(channel->controlDescriptor, &message, MSG_CMSG_CLOEXEC)) == -1 && errno == EINTR)
+  {
+  }
+
+  if (result == sizeof(channel->ringSize) && (controlMessage = CMSG_FIRSTHDR(&message)) != 0 &&
+      controlMessage->cmsg_level == SOL_SOCKET && controlMessage->cmsg_type == SCM_RIGHTS)
+  {
+    memcpy(&memoryDescriptor, CMSG_DATA(controlMessage), sizeof(int32_t));
+  }
+  if (memoryDescriptor == -1 || channel->ringSize < SHM_MIN_RING || (channel->ringSize & (channel->ringSize - 1)) != 0 ||
+      fstat(memoryDescriptor, &memoryStatus) == -1 ||
+      (size_t)memoryStatus.st_size != 2 * (sizeof(struct shmRing) + channel->ringSize) ||
+      !mapRegion(channel, memoryDescriptor, memoryStatus.st_size, 0))
+  {
+    if (memoryDescriptor != -1)
+    {
+      close(memoryDescriptor);
+    }
+    closeLocal(channel);
+    return 0;
+  }
+  close(memoryDescriptor);
+  return channel;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: mapRegion
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static int mapRegion(struct localChannel * channel, int32_t memoryDescriptor, size_t regionSize,
+--                                 int32_t server)
+--                struct localChannel * channel: The channel to attach the rings to
+--                int32_t memoryDescriptor: The memfd holding the rings
+--                size_t regionSize: The size of the memfd
+--                int32_t server: 1 on the accepting side, 0 on the connecting side
+--
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- The first ring carries messages from the server to the client and the second the other way.
+----------------------------------------------------------------------------------------------------------------------*/
+static int32_t mapRegion(struct localChannel *channel, int32_t memoryDescriptor, size_t regionSize, int32_t server)
+{
+  struct shmRing *first;
+  struct shmRing *second;
+
+  if ((channel->region = mmap(0, regionSize, PROT_READ | PROT_WRITE, MAP_SHARED, memoryDescriptor, 0)) == MAP_FAILED)
+  {
+    channel->region = 0;
+    lastSocketError = ERR_NOMEMORY;
+    logger("ERROR > unable to map local channel memory", lastSocketError);
+    return 0;
+  }
+  channel->regionSize = regionSize;
+
+  first = channel->region;
+  second = (struct shmRing *)((char *)channel->region + sizeof(struct shmRing) + channel->ringSize);
+  channel->sendRing = server ? first : second;
+  channel->recvRing = server ? second : first;
+  return 1;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: isLocalAddress
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static int isLocalAddress(uint32_t address)
+--                uint32_t address: An IPv4 address in network byte order
+--
+-- RETURNS: 1 if the address is a loopback address or belongs to an interface of this host, otherwise 0.
+----------------------------------------------------------------------------------------------------------------------*/
+static int32_t isLocalAddress(uint32_t address)
+{
+  struct ifaddrs *interfaces;
+  struct ifaddrs *current;
+  int32_t local = 0;
+
+  if ((ntohl(address) >> 24) == 127)
+  {
+    return 1;
+  }
+  if (getifaddrs(&interfaces) == -1)
+  {
+    return 0;
+  }
+  for (current = interfaces; current != 0 && !local; current = current->ifa_next)
+  {
+    if (current->ifa_addr != 0 && current->ifa_addr->sa_family == AF_INET &&
+        ((struct sockaddr_in *)current->ifa_addr)->sin_addr.s_addr == address)
+    {
+      local = 1;
+    }
+  }
+  freeifaddrs(interfaces);
+  return local;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: peerGone
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static int peerGone(struct localChannel * channel)
+--                struct localChannel * channel: A shared memory channel
+--
+-- RETURNS: 1 if the peer closed the channel or its process exited, otherwise 0.
+--
+-- NOTES:
+-- Only called when a ring is empty or full, right before sleeping, so the extra poll is off the fast path.
+----------------------------------------------------------------------------------------------------------------------*/
+static int32_t peerGone(struct localChannel *channel)
+{
+  struct pollfd pollDescriptor;
+
+  if (atomic_load(&channel->recvRing->closed) || atomic_load(&channel->sendRing->closed))
+  {
+    return 1;
+  }
+  pollDescriptor.fd = channel->controlDescriptor;
+  pollDescriptor.events = POLLRDHUP;
+  pollDescriptor.revents = 0;
+  return poll(&pollDescriptor, 1, 0) == 1 && (pollDescriptor.revents & (POLLRDHUP | POLLHUP | POLLERR));
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: peerTrusted
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static int peerTrusted(int32_t controlDescriptor)
+--                int32_t controlDescriptor: A connected unix socket
+--
+-- RETURNS: 1 if the process at the other end runs as the same user as this one, otherwise 0.
+--
+-- NOTES:
+-- The credentials are the ones the kernel recorded at connect or listen time, so the peer cannot fake them.
+----------------------------------------------------------------------------------------------------------------------*/
+static int32_t peerTrusted(int32_t controlDescriptor)
+{
+  struct ucred credentials;
+  socklen_t credentialsLength = sizeof(credentials);
+
+  if (getsockopt(controlDescriptor, SOL_SOCKET, SO_PEERCRED, &credentials, &credentialsLength) == -1 ||
+      credentialsLength != sizeof(credentials))
+  {
+    return 0;
+  }
+  return credentials.uid == geteuid();
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: failChannel
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static int failChannel(struct localChannel * channel)
+--                struct localChannel * channel: A shared memory channel whose ring is corrupt
+--
+-- RETURNS: -1, with lastSocketError set to ERR_CONRESET.
+--
+-- NOTES:
+-- Marks both rings closed and wakes the peer, so later calls on either side report the channel as gone
+-- instead of reading the corrupt ring again.
+----------------------------------------------------------------------------------------------------------------------*/
+static int32_t failChannel(struct localChannel *channel)
+{
+  atomic_store(&channel->sendRing->closed, 1);
+  atomic_store(&channel->recvRing->closed, 1);
+  futexWake(&channel->sendRing->dataSignal);
+  futexWake(&channel->recvRing->spaceSignal);
+  lastSocketError = ERR_CONRESET;
+  logger("ERROR > corrupt message in local channel ring", lastSocketError);
+  return -1;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: setControlName
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static void setControlName(struct sockaddr_un * controlAddress, socklen_t * controlAddressLength,
+--                                       uint16_t port)
+--                struct sockaddr_un * controlAddress: The address to fill in
+--                socklen_t * controlAddressLength: Set to the length of the address
+--                uint16_t port: The port of the channel, in the same form bindPort takes
+--
+-- RETURNS: void.
+--
+-- NOTES:
+-- Builds the abstract unix socket name for a port. Abstract names need no file and vanish with the socket.
+----------------------------------------------------------------------------------------------------------------------*/
+static void setControlName(struct sockaddr_un *controlAddress, socklen_t *controlAddressLength, uint16_t port)
+{
+  int32_t nameLength;
+
+  memset(controlAddress, 0, sizeof(struct sockaddr_un));
+  controlAddress->sun_family = AF_UNIX;
+  nameLength = snprintf(controlAddress->sun_path + 1, sizeof(controlAddress->sun_path) - 1, SHM_NAME_FORMAT, ntohs(port));
+  *controlAddressLength = offsetof(struct sockaddr_un, sun_path) + 1 + nameLength;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: futexWait
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static void futexWait(_Atomic uint32_t * word, uint32_t expected)
+--                _Atomic uint32_t * word: The futex word in shared memory
+--                uint32_t expected: The value the word held before deciding to sleep
+--
+-- RETURNS: void.
+--
+-- NOTES:
+-- Sleeps until the word changes, a wake up arrives or 100ms pass. The timeout lets the caller notice a
+-- peer that exited without closing the channel.
+----------------------------------------------------------------------------------------------------------------------*/
+static void futexWait(_Atomic uint32_t *word, uint32_t expected)
+{
+  struct timespec timeout;
+
+  timeout.tv_sec = 0;
+  timeout.tv_nsec = SHM_WAIT_NANOSECONDS;
+  syscall(SYS_futex, (uint32_t *)word, FUTEX_WAIT, expected, &timeout, 0, 0);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: futexWake
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static void futexWake(_Atomic uint32_t * word)
+--                _Atomic uint32_t * word: The futex word in shared memory
+--
+-- RETURNS: void.
+--
+-- NOTES:
+-- Changes the word so a waiter about to sleep does not miss the wake up, then wakes any sleeping waiter.
+----------------------------------------------------------------------------------------------------------------------*/
+static void futexWake(_Atomic uint32_t *word)
+{
+  atomic_fetch_add(word, 1);
+  syscall(SYS_futex, (uint32_t *)word, FUTEX_WAKE, INT32_MAX, 0, 0, 0);
+}
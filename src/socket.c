@@ -10,26 +10,70 @@
 -- int closeSocket(struct socketStruct * socket)
 -- void freeSocket(struct socketStruct * socket)
 -- int32_t attachTimeout(struct socketStruct* socketPointer, int32_t waitDuration)
+-- int32_t attachReceiveTimeout(struct socketStruct* socketPointer, int64_t waitMicroseconds)
+-- int32_t attachSendTimeout(struct socketStruct* socketPointer, int64_t waitMicroseconds)
+-- int32_t tuneSocket(struct socketStruct* socketPointer, struct socketTuning* tuning)
 --
 -- UDP FUNCTIONS:
 -- int initSocket(struct socketStruct* socketPointer)
+-- int initSocketTuned(struct socketStruct* socketPointer, struct socketTuning* tuning)
 -- int sendData(struct socketStruct* socket, struct destination * dest, const char* data, size_t dataLength)
 -- int recvData(struct socketStruct* socket, struct destination * dest, char * dataBuffer, size_t dataBufferLength)
+-- int recvDataTimeout(struct socketStruct* socket, struct destination * dest, char * dataBuffer,
+--                     size_t dataBufferLength, int64_t waitMicroseconds)
+-- int recvDataTimestamp(struct socketStruct* socket, struct destination * dest, struct packetTimestamp * timestamp,
+--                       char * dataBuffer, size_t dataBufferLength)
+-- int recvDataBatch(struct socketStruct* socket, struct receivedPacket * packets, int32_t packetCount)
+-- int enableTimestamping(struct socketStruct* socket, int32_t timestampFlags)
+-- int recvTxTimestamp(struct socketStruct* socket, uint32_t * sendIndex, struct packetTimestamp * timestamp)
+-- int joinMulticastGroup(struct socketStruct* socket, uint32_t groupAddress, uint32_t interfaceAddress)
+-- int leaveMulticastGroup(struct socketStruct* socket, uint32_t groupAddress, uint32_t interfaceAddress)
+-- int setMulticastTTL(struct socketStruct* socket, int32_t timeToLive)
+-- int setMulticastLoopback(struct socketStruct* socket, int32_t enable)
+-- int setMulticastInterface(struct socketStruct* socket, uint32_t interfaceAddress)
+-- int sendDataGroup(struct socketStruct* socket, struct destination * groups, int32_t groupCount,
+--                   const char* data, size_t dataLength)
+-- int sendDataBatch(struct socketStruct* socket, struct sendPacket * packets, int32_t packetCount)
 --
 -- TCP FUNCTIONS:
 -- int initSocketTCP(struct socketStruct* socketPointer)
+-- int initSocketTCPTuned(struct socketStruct* socketPointer, struct socketTuning* tuning)
 -- int connectPort(struct socketStruct* socketPointer, struct destination* dest)
+-- int connectPortTimeout(struct socketStruct* socketPointer, struct destination* dest, int64_t waitMicroseconds)
+-- int listenTCP(struct socketStruct* socketPointer, int32_t backlog)
 -- struct socketStruct * acceptClient(struct socketStruct* socketPointer)
+-- int acceptClients(struct socketStruct* socketPointer, struct socketStruct** clients, struct destination* peers,
+--                   int32_t maxClients)
 -- int sendDataTCP(struct socketStruct* socketPointer, const char* data, size_t dataLength)
+-- int64_t sendDataTCPTimeout(struct socketStruct* socketPointer, const char* data, uint64_t dataLength,
+--                            int64_t waitMicroseconds)
 -- int recvDataTCP(struct socketStruct* socketPointer, char* dataBuffer, int32_t packetSize)
+-- int recvDataTCPTimeout(struct socketStruct* socketPointer, char* dataBuffer, int32_t packetSize,
+--                        int64_t waitMicroseconds)
 --
 -- OTHER FUNCTIONS 
 -- int getSocketError(struct socketStruct* socketPointer)
 -- void logger(char *msg, int32_t error_num) 
+-- int exchangeSocketHook(int32_t socketDescriptor, int32_t hook, void * value, void ** previous)
+-- int receiveBatch(struct socketStruct* socket, struct receivedPacket * packets, int32_t packetCount,
+--                  int32_t waitForFirst)
+-- int connectErrorCode(int32_t errorNumber)
 --
 -- DATE: April 4th, 2019
 --
--- REVISIONS: April 4, 2019
+-- REVISIONS: October 18, 2026
+--              -Capture and network emulator calls go through hookFunctions
+--              -Sockets with an attached network emulator send through it
+--              -Sockets with an attached capture log record their traffic
+--              -Added multicast group membership, multicast options and sendDataGroup
+--              -Added sendDataBatch
+--              -Added listenTCP, acceptClients and accept latency tuning options
+--              -Added socket tuning profiles
+--              -Error state is now kept per thread in lastSocketError
+--              -Added kernel timestamping and batch receive
+--              -Added microsecond send/receive timeouts, connectPortTimeout and per-call
+--               deadline receive functions
+--            April 4, 2019
 --              -Added logging functionality
 --            April 3, 2019
 --              -Added null checks for pointers parameters
@@ -42,25 +86,63 @@
 --
 -- DESIGNER: Cameron Roberts, Simon Wu
 --
--- PROGRAMMER: Cameron Roberts, Simon Wu
+-- PROGRAMMER: Cameron Roberts, Simon Wu, agent
 --
 -- NOTES:
 -- The functions in this file can by either a client or server to create a TCP or UDP
 -- socket as well as send and recieve data.
+--
+-- Concurrency: a socketStruct is never written after it has been initialized, so one thread may send
+-- while another receives on the same socket without any locking. Capture logs and network emulators are
+-- not kept in the socketStruct but in a table by descriptor, whose entries are read and swapped
+-- atomically. Errors are recorded in lastSocketError, which is thread local, so getSocketError always
+-- reports the last failure of the calling thread. Initializing, closing or freeing a socket, and
+-- attaching or detaching a capture log or network emulator, must not overlap with any other call on it,
+-- because a sender may still be using the old log or emulator. "make tsan" runs tests/tsan_stress.c
+-- under ThreadSanitizer to check these rules.
+--
+-- This file only reaches capture.c and netem.c through the function pointers in hookFunctions, which they
+-- fill in when the first log or emulator is attached. It therefore builds and links on its own, as the
+-- macOS bundle does, where no hook is ever attached.
 ----------------------------------------------------------------------------------------------------------------------*/
 
+#define _GNU_SOURCE
+
 #include "include/socket.h"
+#include "include/capture.h"
+#include "include/netem.h"
+#include "include/internal.h"
+
+__thread int32_t lastSocketError = ERR_UNKNOWN;
+
+void **hookPages[HOOK_PAGES];
+uint32_t hooksAttached;
+struct hookFunctions hookFunctions;
+static pthread_mutex_t hookLock = PTHREAD_MUTEX_INITIALIZER;
+
+static int32_t waitForSocket(int32_t socketDescriptor, int16_t events, int64_t deadline);
+static int32_t waitIfNonBlocking(int32_t socketDescriptor, int16_t events);
+static int32_t setTimeoutOption(struct socketStruct *socketPointer, int32_t optionName, int64_t waitMicroseconds);
+static int32_t receiveErrorCode(int32_t errorNumber);
+static int32_t optionErrorCode(int32_t errorNumber);
+static int32_t sendErrorCode(int32_t errorNumber);
+static int32_t streamSendErrorCode(int32_t errorNumber);
+static int32_t setMembership(struct socketStruct *socketPointer, int32_t optionName, uint32_t groupAddress, uint32_t interfaceAddress);
+static int32_t applyTuningOption(struct socketStruct *socketPointer, int32_t level, int32_t optionName, int32_t value, const char *description);
+static int32_t applyBufferSize(struct socketStruct *socketPointer, int32_t optionName, int32_t forceOptionName, int32_t requested, int32_t *effective);
+static void readPacketTimestamp(struct msghdr *message, struct packetTimestamp *timestamp);
 
 /*------------------------------------------------------------------------------------------------------------------
 -- FUNCTION: createSocket
 --
 -- DATE: January 23rd, 2019
 --
--- REVISIONS: 
+-- REVISIONS: October 18, 2026
+--              -Allocate zeroed so no capture log or network emulator is attached
 --
 -- DESIGNER: Cameron Roberts
 --
--- PROGRAMMER: Cameron Roberts
+-- PROGRAMMER: Cameron Roberts, agent
 --
 -- INTERFACE: struct socketStruct * createSocket()
 --
@@ -72,7 +154,7 @@
 ----------------------------------------------------------------------------------------------------------------------*/
 struct socketStruct *createSocket()
 {
-  return malloc(sizeof(struct socketStruct));
+  return calloc(1, sizeof(struct socketStruct));
 }
 
 /*------------------------------------------------------------------------------------------------------------------
@@ -87,10 +169,10 @@ struct socketStruct *createSocket()
 -- PROGRAMMER: Simon Wu, Cameron Roberts
 --
 -- INTERFACE: int initSocketTCP(struct socketStruct* socketPointer)
---                struct socketStrict * socketPointer: A pointer to the socketStruct whose 
+--                struct socketStruct * socketPointer: A pointer to the socketStruct whose 
 --                                                     socket is to be initialized.
 --
--- RETURNS: On success 1 is returned. On error 0 is returned and lastError of the socket struct is set appropriately.
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
 --    
 -- NOTES:
 -- This function is used to initialize the socket contained within a socketStruct as a
@@ -103,16 +185,16 @@ int initSocketTCP(struct socketStruct *socketPointer)
     switch (errno)
     {
     case EACCES:
-      socketPointer->lastError = ERR_PERMISSION;
+      lastSocketError = ERR_PERMISSION;
       break;
     case ENOMEM:
-      socketPointer->lastError = ERR_NOMEMORY;
+      lastSocketError = ERR_NOMEMORY;
       break;
     default:
-      socketPointer->lastError = ERR_UNKNOWN;
+      lastSocketError = ERR_UNKNOWN;
       break;
     }
-    logger("ERROR > unable to initiate TCP socket", socketPointer->lastError);
+    logger("ERROR > unable to initiate TCP socket", lastSocketError);
     return 0;
   }
   //logger("SUCCESS > TCP socket initialized", socketPointer->socketDescriptor);
@@ -124,49 +206,151 @@ int initSocketTCP(struct socketStruct *socketPointer)
 --
 -- DATE: March 6th, 2019
 --
--- REVISIONS: 
+-- REVISIONS: October 18, 2026
+--              -Now a wrapper around attachReceiveTimeout
+--            March 6, 2019
+--              -Initial start
 --
 -- DESIGNER: Simon Wu
 --
--- PROGRAMMER: Simon Wu
+-- PROGRAMMER: Simon Wu, agent
 --
 -- INTERFACE: int attachTimeout(struct socketStruck* socketPointer, int waitDuration)
---                struct socketStrict * socketPointer: A pointer to the socketStruct whose socket we are attaching
+--                struct socketStruct * socketPointer: A pointer to the socketStruct whose socket we are attaching
 --                                                     the timeout to (for receiving)
---                int waitDuration: The length of the wait until socket timeout
+--                int waitDuration: The length of the wait until socket timeout in seconds
 --
--- RETURNS: On success 1 is returned. On error 0 is returned and lastError of the socket struct is set appropriately.
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
 --    
 -- NOTES:
--- This function is used to attach a receive timeout to the specified socket.
+-- This function is used to attach a receive timeout to the specified socket. Use attachReceiveTimeout
+-- for timeouts shorter than a second.
 ----------------------------------------------------------------------------------------------------------------------*/
 int32_t attachTimeout(struct socketStruct *socketPointer, int32_t waitDuration)
+{
+  return attachReceiveTimeout(socketPointer, (int64_t)waitDuration * 1000000);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: attachReceiveTimeout
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS: 
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int attachReceiveTimeout(struct socketStruct* socketPointer, int64_t waitMicroseconds)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct whose socket we are attaching
+--                                                     the timeout to
+--                int64_t waitMicroseconds: The length of the wait until socket timeout in microseconds.
+--                                          A value of 0 removes the timeout.
+--
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
+--    
+-- NOTES:
+-- This function is used to attach a receive timeout with microsecond resolution to the specified socket.
+-- A receive that times out fails with lastSocketError set to ERR_TIMEOUT.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t attachReceiveTimeout(struct socketStruct *socketPointer, int64_t waitMicroseconds)
+{
+  return setTimeoutOption(socketPointer, SO_RCVTIMEO, waitMicroseconds);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: attachSendTimeout
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS: 
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int attachSendTimeout(struct socketStruct* socketPointer, int64_t waitMicroseconds)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct whose socket we are attaching
+--                                                     the timeout to
+--                int64_t waitMicroseconds: The length of the wait until socket timeout in microseconds.
+--                                          A value of 0 removes the timeout.
+--
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
+--    
+-- NOTES:
+-- This function is used to attach a send timeout with microsecond resolution to the specified socket.
+-- A send that times out fails with lastSocketError set to ERR_TIMEOUT.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t attachSendTimeout(struct socketStruct *socketPointer, int64_t waitMicroseconds)
+{
+  return setTimeoutOption(socketPointer, SO_SNDTIMEO, waitMicroseconds);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: setTimeoutOption
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS: 
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static int setTimeoutOption(struct socketStruct* socketPointer, int optionName, int64_t waitMicroseconds)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct to set the timeout on
+--                int optionName: SO_RCVTIMEO or SO_SNDTIMEO
+--                int64_t waitMicroseconds: The length of the timeout in microseconds
+--
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
+--    
+-- NOTES:
+-- Shared implementation of attachReceiveTimeout and attachSendTimeout.
+----------------------------------------------------------------------------------------------------------------------*/
+static int32_t setTimeoutOption(struct socketStruct *socketPointer, int32_t optionName, int64_t waitMicroseconds)
 {
   struct timeval waitTime;
-  waitTime.tv_sec = waitDuration;
-  waitTime.tv_usec = 0;
 
-  if (setsockopt(socketPointer->socketDescriptor, SOL_SOCKET, SO_RCVTIMEO, (const char *)&waitTime, sizeof waitTime) == -1)
+  if (socketPointer == 0)
+  {
+    logger("ERROR > invalid socket passed to setTimeoutOption", -1);
+    return 0;
+  }
+  if (waitMicroseconds < 0)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > negative timeout passed to setTimeoutOption", lastSocketError);
+    return 0;
+  }
+
+  waitTime.tv_sec = waitMicroseconds / 1000000;
+  waitTime.tv_usec = waitMicroseconds % 1000000;
+
+  if (setsockopt(socketPointer->socketDescriptor, SOL_SOCKET, optionName, (const char *)&waitTime, sizeof waitTime) == -1)
   {
     switch (errno)
     {
     case EBADF:
-      socketPointer->lastError = ERR_BADSOCK;
+      lastSocketError = ERR_BADSOCK;
       break;
     case ENOTSOCK:
-      socketPointer->lastError = ERR_BADSOCK;
+      lastSocketError = ERR_BADSOCK;
       break;
     case EINVAL:
-      socketPointer->lastError = ERR_ILLEGALOP;
+      lastSocketError = ERR_ILLEGALOP;
+      break;
+    case EDOM:
+      lastSocketError = ERR_ILLEGALOP;
       break;
     default:
-      socketPointer->lastError = ERR_UNKNOWN;
+      lastSocketError = ERR_UNKNOWN;
       break;
     }
-    logger("ERROR > unable to attach receive timeout to socket", socketPointer->lastError);
+    logger("ERROR > unable to attach timeout to socket", lastSocketError);
     return 0;
   }
-  //logger("SUCCESS > attached receive timeout to socket", socketPointer->socketDescriptor);
+  //logger("SUCCESS > attached timeout to socket", socketPointer->socketDescriptor);
   return 1;
 }
 
@@ -182,10 +366,10 @@ int32_t attachTimeout(struct socketStruct *socketPointer, int32_t waitDuration)
 -- PROGRAMMER: Cameron Roberts, Simon Wu
 --
 -- INTERFACE: int initSocket(struct socketStruct* socketPointer)
---                struct socketStrict * socketPointer: A pointer to the socketStruct whose 
+--                struct socketStruct * socketPointer: A pointer to the socketStruct whose 
 --                                                     socket is to be initialized.
 --
--- RETURNS: On success 1 is returned. On error 0 is returned and lastError of the socket struct is set appropriately.
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
 --
 -- NOTES:
 -- This function is used to initialize the socket contained within a socketStruct as a
@@ -198,16 +382,16 @@ int32_t initSocket(struct socketStruct *socketPointer)
     switch (errno)
     {
     case EACCES:
-      socketPointer->lastError = ERR_PERMISSION;
+      lastSocketError = ERR_PERMISSION;
       break;
     case ENOMEM:
-      socketPointer->lastError = ERR_NOMEMORY;
+      lastSocketError = ERR_NOMEMORY;
       break;
     default:
-      socketPointer->lastError = ERR_UNKNOWN;
+      lastSocketError = ERR_UNKNOWN;
       break;
     }
-    logger("ERROR > unable create a socket", socketPointer->lastError);
+    logger("ERROR > unable create a socket", lastSocketError);
     return 0;
   }
   //logger("SUCCESS > UDP socket initialized", socketPointer->socketDescriptor);
@@ -215,528 +399,2794 @@ int32_t initSocket(struct socketStruct *socketPointer)
 }
 
 /*------------------------------------------------------------------------------------------------------------------
--- FUNCTION: bindPort
+-- FUNCTION: initSocketTuned
 --
--- DATE: January 23rd, 2019
+-- DATE: October 18th, 2026
 --
--- REVISIONS: 
+-- REVISIONS: October 18, 2026
+--              -Closes the socket if the profile could not be fully applied
 --
--- DESIGNER: Simon Wu, Cameron Roberts
+-- DESIGNER: agent
 --
--- PROGRAMMER: Simon Wu, Cameron Roberts
+-- PROGRAMMER: agent
 --
--- INTERFACE: int bindPort(struct socketStruct* socketPointer, uint16_t port)
---                struct socketStrict * socketPointer: A pointer to the socketStruct whose
---                                                     socket should be bound
---                uint16_t: The port for the socket to be bound to. A port of 0 specifies 
---                          an ephemeral port
+-- INTERFACE: int initSocketTuned(struct socketStruct* socketPointer, struct socketTuning* tuning)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct whose 
+--                                                     socket is to be initialized.
+--                struct socketTuning * tuning: The options to apply to the new socket
 --
--- RETURNS: On success 1 is returned. On error 0 is returned and lastError of the socket struct is set appropriately.
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
 --
 -- NOTES:
--- This function is used to initialize the socket contained within a socketStruct as a
--- UDP socket. After the socket is initialized it should be bound to a port by calling
--- bindPort. Use a port of 0 to specify an ephemeral port.
+-- This function is used to initialize a UDP socket and apply a tuning profile to it before it is bound,
+-- so options such as TUNE_REUSEADDR take effect on bindPort. If any option could not be applied the socket
+-- is closed again and tuning->applied shows which ones failed. To keep a socket that is only partly
+-- tuned, call initSocket and tuneSocket instead.
 ----------------------------------------------------------------------------------------------------------------------*/
-int32_t bindPort(struct socketStruct *socketPointer, uint16_t port)
+int32_t initSocketTuned(struct socketStruct *socketPointer, struct socketTuning *tuning)
 {
-  struct sockaddr_in socketAddress;
-  memset((char *)&socketAddress, 0, sizeof(socketAddress));
-  socketAddress.sin_family = AF_INET;
-  socketAddress.sin_port = port;
-  socketAddress.sin_addr.s_addr = htonl(INADDR_ANY);
+  int32_t tuneError;
 
-  if (bind(socketPointer->socketDescriptor, (struct sockaddr *)&(socketAddress), sizeof(socketAddress)) == -1)
+  if (!initSocket(socketPointer))
   {
-    switch (errno)
-    {
-    case EACCES:
-      socketPointer->lastError = ERR_PERMISSION;
-      break;
-    case EADDRINUSE:
-      socketPointer->lastError = ERR_ADDRINUSE;
-      break;
-    case EINVAL:
-      socketPointer->lastError = ERR_ILLEGALOP;
-      break;
-    case ENOTSOCK:
-      socketPointer->lastError = ERR_BADSOCK;
-      break;
-    default:
-      socketPointer->lastError = ERR_UNKNOWN;
-      break;
-    }
-    logger("ERROR > failed to bind name to socket", socketPointer->lastError);
     return 0;
   }
-  //logger("SUCCESS > socket binded", socketPointer->socketDescriptor);
+  if (!tuneSocket(socketPointer, tuning))
+  {
+    tuneError = lastSocketError;
+    closeSocket(socketPointer);
+    socketPointer->socketDescriptor = -1;
+    lastSocketError = tuneError;
+    return 0;
+  }
   return 1;
 }
 
 /*------------------------------------------------------------------------------------------------------------------
--- FUNCTION: connectPort
+-- FUNCTION: initSocketTCPTuned
 --
--- DATE: January 23rd, 2019
+-- DATE: October 18th, 2026
 --
--- REVISIONS:
+-- REVISIONS: October 18, 2026
+--              -Closes the socket if the profile could not be fully applied
 --
--- DESIGNER: Simon Wu
+-- DESIGNER: agent
 --
--- PROGRAMMER: Simon Wu, Cameron Roberts
+-- PROGRAMMER: agent
 --
--- INTERFACE: int connectPort(struct socketStruct* socketPointer, struct destination* dest)
---                struct socketStrict * socketPointer: A pointer to the socketStruct whose
---                                                     socket should be used to connect
---                struct destination* dest: A pointer to a destination constructor containing
---                                          the address and port to connect to.
+-- INTERFACE: int initSocketTCPTuned(struct socketStruct* socketPointer, struct socketTuning* tuning)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct whose 
+--                                                     socket is to be initialized.
+--                struct socketTuning * tuning: The options to apply to the new socket
+--
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
 --
--- RETURNS: On success 1 is returned. On error 0 is returned and lastError of the socket struct is set appropriately.
---    
 -- NOTES:
--- This function is used to connect an initialized TCP socket to a destination.
+-- This function is used to initialize a TCP socket and apply a tuning profile to it before it is bound.
+-- If any option could not be applied the socket is closed again and tuning->applied shows which ones
+-- failed. To keep a socket that is only partly tuned, call initSocketTCP and tuneSocket instead.
 ----------------------------------------------------------------------------------------------------------------------*/
-int connectPort(struct socketStruct *socketPointer, struct destination *dest)
+int32_t initSocketTCPTuned(struct socketStruct *socketPointer, struct socketTuning *tuning)
 {
-  struct sockaddr_in destSockAddr;
-  memset((char *)&destSockAddr, 0, sizeof(destSockAddr));
-  destSockAddr.sin_family = AF_INET;
-  destSockAddr.sin_port = dest->port;
-  destSockAddr.sin_addr.s_addr = dest->address;
+  int32_t tuneError;
 
-  if (connect(socketPointer->socketDescriptor, (struct sockaddr *)&(destSockAddr), sizeof(destSockAddr)) == -1)
+  if (!initSocketTCP(socketPointer))
   {
-    switch (errno)
-    {
-    case EADDRNOTAVAIL:
-      socketPointer->lastError = ERR_ADDRNOTAVAIL;
-      break;
-    case EBADF:
-      socketPointer->lastError = ERR_BADSOCK;
-      break;
-    case ECONNREFUSED:
-      socketPointer->lastError = ERR_CONREFUSED;
-      break;
-    case EISCONN:
-      socketPointer->lastError = ERR_ILLEGALOP;
-      break;
-    case ENETUNREACH:
-      socketPointer->lastError = ERR_DESTUNREACH;
-      break;
-    case ENOTSOCK:
-      socketPointer->lastError = ERR_BADSOCK;
-      break;
-    case ECONNRESET:
-      socketPointer->lastError = ERR_CONRESET;
-      break;
-    case EHOSTUNREACH:
-      socketPointer->lastError = ERR_DESTUNREACH;
-      break;
-    case ENETDOWN:
-      socketPointer->lastError = ERR_DESTUNREACH;
-      break;
-    case EOPNOTSUPP:
-      socketPointer->lastError = ERR_ILLEGALOP;
-      break;
-    case EINVAL:
-      socketPointer->lastError = ERR_ILLEGALOP;
-      break;
-    case EINPROGRESS:
-      socketPointer->lastError = ERR_TIMEOUT;
-      break;
-    default:
-      socketPointer->lastError = ERR_UNKNOWN;
-      break;
-    }
-    logger("ERROR > unable to connect to server", socketPointer->lastError);
     return 0;
   }
-  //logger("SUCCESS > connected to server", socketPointer->socketDescriptor);
+  if (!tuneSocket(socketPointer, tuning))
+  {
+    tuneError = lastSocketError;
+    closeSocket(socketPointer);
+    socketPointer->socketDescriptor = -1;
+    lastSocketError = tuneError;
+    return 0;
+  }
   return 1;
 }
 
 /*------------------------------------------------------------------------------------------------------------------
--- FUNCTION: acceptClient
+-- FUNCTION: tuneSocket
 --
--- DATE: January 31st, 2019
+-- DATE: October 18th, 2026
 --
--- REVISIONS: January 31, 2019
---              -Altered function to return a socket descriptor rather than a socketStruct
---            January 23, 2019
---              -Initial start
+-- REVISIONS: October 18, 2026
+--              -Reports the kernel buffer sizes in separate fields instead of overwriting the request
 --
--- DESIGNER: Simon Wu
+-- DESIGNER: agent
 --
--- PROGRAMMER: Simon Wu, Cameron Roberts
+-- PROGRAMMER: agent
 --
--- INTERFACE: uint64_t acceptClient(struct socketStruct* socketPointer)
---                struct socketStrict * socketPointer: A pointer to the socketStruct whose
---                                                     socket should be to accept an incoming
---                                                     connection
+-- INTERFACE: int tuneSocket(struct socketStruct* socketPointer, struct socketTuning* tuning)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct to tune
+--                struct socketTuning * tuning: The options to apply. Fields left at 0 are not changed.
 --
--- RETURNS: On sucess a new socket descriptor is returned. On error NULL is
---          returned and lastError of the socket struct is set appropriately.
+-- RETURNS: 1 if every requested option was applied. Otherwise 0 is returned and lastSocketError is set
+--          for the last option that failed.
 --
 -- NOTES:
--- This function is used to accept a incoming TCP connection.
+-- This function is used to apply a tuning profile to an initialized socket. Every requested option is
+-- attempted even if an earlier one fails, and on return tuning->applied holds the TUNE_ flags of the options
+-- that took effect. The buffer sizes the kernel actually uses are read back into effectiveReceiveBufferSize
+-- and effectiveSendBufferSize, or left 0 when not requested. Linux doubles the requested value and caps it
+-- at net.core.rmem_max/wmem_max unless the process has CAP_NET_ADMIN. The requested sizes are left alone,
+-- so the same profile can be applied to any number of sockets.
+-- TCP options fail on UDP sockets and Linux only options fail elsewhere; both are simply not applied.
+-- TCP_QUICKACK is not permanent in Linux, the kernel may fall back to delayed acknowledgements later.
+-- TUNE_DEFERACCEPT and TUNE_FASTOPEN apply to listening sockets and must be set before listenTCP; with
+-- deferAcceptSeconds a connection is only accepted once the client has sent data, and fastOpenQueueLength
+-- lets clients send their first request in the SYN.
 ----------------------------------------------------------------------------------------------------------------------*/
-int32_t acceptClient(struct socketStruct *socketPointer)
+int32_t tuneSocket(struct socketStruct *socketPointer, struct socketTuning *tuning)
 {
-  struct sockaddr_in clientAddr;
-  memset((char *)&clientAddr, 0, sizeof(clientAddr));
-  socklen_t clientAddressLength = sizeof(clientAddr);
-  int32_t socketDescriptor;
-  if ((socketDescriptor = accept(socketPointer->socketDescriptor, (struct sockaddr *)&clientAddr, &clientAddressLength)) == -1)
+  int32_t requested = 0;
+
+  if (socketPointer == 0)
   {
-    switch (errno)
-    {
-    case EBADF:
-      socketPointer->lastError = ERR_BADSOCK;
-      break;
-    case EINVAL:
-      socketPointer->lastError = ERR_ILLEGALOP;
-      break;
-    case EPERM:
-      socketPointer->lastError = ERR_PERMISSION;
-      break;
-    case ENOTSOCK:
-      socketPointer->lastError = ERR_BADSOCK;
-      break;
-    default:
-      socketPointer->lastError = ERR_UNKNOWN;
-      break;
-    }
-    logger("ERROR > failed to connect to client", socketPointer->lastError);
+    logger("ERROR > invalid socket passed to tuneSocket", -1);
     return 0;
   }
-  //logger("SUCCESS > client accepted", socketPointer->lastError);
-  return socketDescriptor;
+  if (tuning == 0)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid tuning passed to tuneSocket", lastSocketError);
+    return 0;
+  }
+
+  tuning->applied = 0;
+  tuning->effectiveReceiveBufferSize = 0;
+  tuning->effectiveSendBufferSize = 0;
+
+  if (tuning->receiveBufferSize > 0)
+  {
+    requested |= TUNE_RCVBUF;
+#ifdef SO_RCVBUFFORCE
+    tuning->applied |= applyBufferSize(socketPointer, SO_RCVBUF, SO_RCVBUFFORCE, tuning->receiveBufferSize, &tuning->effectiveReceiveBufferSize) ? TUNE_RCVBUF : 0;
+#else
+    tuning->applied |= applyBufferSize(socketPointer, SO_RCVBUF, -1, tuning->receiveBufferSize, &tuning->effectiveReceiveBufferSize) ? TUNE_RCVBUF : 0;
+#endif
+  }
+  if (tuning->sendBufferSize > 0)
+  {
+    requested |= TUNE_SNDBUF;
+#ifdef SO_SNDBUFFORCE
+    tuning->applied |= applyBufferSize(socketPointer, SO_SNDBUF, SO_SNDBUFFORCE, tuning->sendBufferSize, &tuning->effectiveSendBufferSize) ? TUNE_SNDBUF : 0;
+#else
+    tuning->applied |= applyBufferSize(socketPointer, SO_SNDBUF, -1, tuning->sendBufferSize, &tuning->effectiveSendBufferSize) ? TUNE_SNDBUF : 0;
+#endif
+  }
+  if (tuning->reuseAddress)
+  {
+    requested |= TUNE_REUSEADDR;
+    tuning->applied |= applyTuningOption(socketPointer, SOL_SOCKET, SO_REUSEADDR, 1, "SO_REUSEADDR") ? TUNE_REUSEADDR : 0;
+  }
+  if (tuning->reusePort)
+  {
+    requested |= TUNE_REUSEPORT;
+#ifdef SO_REUSEPORT
+    tuning->applied |= applyTuningOption(socketPointer, SOL_SOCKET, SO_REUSEPORT, 1, "SO_REUSEPORT") ? TUNE_REUSEPORT : 0;
+#else
+    lastSocketError = ERR_ILLEGALOP;
+#endif
+  }
+  if (tuning->noDelay)
+  {
+    requested |= TUNE_NODELAY;
+    tuning->applied |= applyTuningOption(socketPointer, IPPROTO_TCP, TCP_NODELAY, 1, "TCP_NODELAY") ? TUNE_NODELAY : 0;
+  }
+  if (tuning->quickAck)
+  {
+    requested |= TUNE_QUICKACK;
+#ifdef TCP_QUICKACK
+    tuning->applied |= applyTuningOption(socketPointer, IPPROTO_TCP, TCP_QUICKACK, 1, "TCP_QUICKACK") ? TUNE_QUICKACK : 0;
+#else
+    lastSocketError = ERR_ILLEGALOP;
+#endif
+  }
+  if (tuning->busyPollMicroseconds > 0)
+  {
+    requested |= TUNE_BUSYPOLL;
+#ifdef SO_BUSY_POLL
+    tuning->applied |= applyTuningOption(socketPointer, SOL_SOCKET, SO_BUSY_POLL, tuning->busyPollMicroseconds, "SO_BUSY_POLL") ? TUNE_BUSYPOLL : 0;
+#else
+    lastSocketError = ERR_ILLEGALOP;
+#endif
+  }
+  if (tuning->typeOfService > 0)
+  {
+    requested |= TUNE_TOS;
+    tuning->applied |= applyTuningOption(socketPointer, IPPROTO_IP, IP_TOS, tuning->typeOfService, "IP_TOS") ? TUNE_TOS : 0;
+  }
+  if (tuning->priority > 0)
+  {
+    requested |= TUNE_PRIORITY;
+#ifdef SO_PRIORITY
+    tuning->applied |= applyTuningOption(socketPointer, SOL_SOCKET, SO_PRIORITY, tuning->priority, "SO_PRIORITY") ? TUNE_PRIORITY : 0;
+#else
+    lastSocketError = ERR_ILLEGALOP;
+#endif
+  }
+
+  if (tuning->deferAcceptSeconds > 0)
+  {
+    requested |= TUNE_DEFERACCEPT;
+#ifdef TCP_DEFER_ACCEPT
+    tuning->applied |= applyTuningOption(socketPointer, IPPROTO_TCP, TCP_DEFER_ACCEPT, tuning->deferAcceptSeconds, "TCP_DEFER_ACCEPT") ? TUNE_DEFERACCEPT : 0;
+#else
+    lastSocketError = ERR_ILLEGALOP;
+#endif
+  }
+  if (tuning->fastOpenQueueLength > 0)
+  {
+    requested |= TUNE_FASTOPEN;
+#ifdef TCP_FASTOPEN
+    tuning->applied |= applyTuningOption(socketPointer, IPPROTO_TCP, TCP_FASTOPEN, tuning->fastOpenQueueLength, "TCP_FASTOPEN") ? TUNE_FASTOPEN : 0;
+#else
+    lastSocketError = ERR_ILLEGALOP;
+#endif
+  }
+
+  if (tuning->applied != requested)
+  {
+    return 0;
+  }
+  //logger("SUCCESS > socket tuned", socketPointer->socketDescriptor);
+  return 1;
 }
 
 /*------------------------------------------------------------------------------------------------------------------
--- FUNCTION: sendDataTCP
+-- FUNCTION: applyTuningOption
 --
--- DATE: April 3rd, 2019
+-- DATE: October 18th, 2026
 --
--- REVISIONS: April 3, 2019
---              -Added null checks for pointers
---            January 23, 2019
---              -Initial start
+-- REVISIONS: 
 --
--- DESIGNER: Simon Wu
+-- DESIGNER: agent
 --
--- PROGRAMMER: Simon Wu, Cameron Roberts
+-- PROGRAMMER: agent
 --
--- INTERFACE: int sendDataTCP(struct socketStruct* socketPointer, const char* data, size_t dataLength)
---                struct socketStrict * socketPointer: A pointer to the socketStruct whose
---                                                     socket should be to send the data
---                const char * data: A char array containing the data to be sent
---                size_t dataLength: The length of the data in the char array
+-- INTERFACE: static int applyTuningOption(struct socketStruct* socketPointer, int32_t level, int32_t optionName,
+--                                         int32_t value, const char * description)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct to set the option on
+--                int32_t level: The protocol level of the option
+--                int32_t optionName: The option to set
+--                int32_t value: The integer value to set it to
+--                const char * description: The option name, used when logging a failure
 --
--- RETURNS: On success 1 is returned. On error 0 is returned and lastError of the socket struct is set appropriately.
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
 --
 -- NOTES:
--- This function is used to send data on a connected TCP socket.
+-- Sets one integer socket option for tuneSocket.
 ----------------------------------------------------------------------------------------------------------------------*/
-int32_t sendDataTCP(struct socketStruct *socketPointer, const char *data, uint64_t dataLength)
+static int32_t applyTuningOption(struct socketStruct *socketPointer, int32_t level, int32_t optionName, int32_t value, const char *description)
 {
-  if (socketPointer == 0)
-  {
-    logger("ERROR > invalid socket passed to sendDataTCP", -1);
-    return 0;
-  }
-  if (data == 0)
-  {
-    socketPointer->lastError = ERR_ILLEGALOP;
-    logger("ERROR > invalid data passed to sendDataTCP", socketPointer->lastError);
-    return 0;
-  }
-  if (send(socketPointer->socketDescriptor, data, dataLength, 0) < 0)
+  char message[96];
+
+  if (setsockopt(socketPointer->socketDescriptor, level, optionName, &value, sizeof(value)) == -1)
   {
-    switch (errno)
-    {
-    case EBADF:
-      socketPointer->lastError = ERR_BADSOCK;
-      break;
-    case ENOTSOCK:
-      socketPointer->lastError = ERR_BADSOCK;
-      break;
-    case ENOTCONN:
-      socketPointer->lastError = ERR_ILLEGALOP;
-      break;
-    case ENOMEM:
-      socketPointer->lastError = ERR_NOMEMORY;
-      break;
-    default:
-      socketPointer->lastError = ERR_UNKNOWN;
-      break;
-    }
-    if (errno == EWOULDBLOCK || errno == EAGAIN)
-    {
-      socketPointer->lastError = ERR_TIMEOUT;
-    }
-    logger("ERROR > failed to send TCP data", socketPointer->lastError);
+    lastSocketError = optionErrorCode(errno);
+    snprintf(message, sizeof(message), "ERROR > unable to apply %s to socket", description);
+    logger(message, lastSocketError);
     return 0;
   }
-  //logger("SUCCESS > sent TCP data", socketPointer->socketDescriptor);
   return 1;
 }
 
 /*------------------------------------------------------------------------------------------------------------------
--- FUNCTION: sendData
+-- FUNCTION: applyBufferSize
 --
--- DATE: April 3rd, 2019
+-- DATE: October 18th, 2026
 --
--- REVISIONS: April 3, 2019
---              -Added null check for pointers
---            March 6, 2019
---              -Change failure return to return errno instead
+-- REVISIONS: October 18, 2026
+--              -Takes the requested size by value and reports the effective size separately
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static int applyBufferSize(struct socketStruct* socketPointer, int32_t optionName,
+--                                       int32_t forceOptionName, int32_t requested, int32_t * effective)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct to size
+--                int32_t optionName: SO_RCVBUF or SO_SNDBUF
+--                int32_t forceOptionName: SO_RCVBUFFORCE or SO_SNDBUFFORCE, or -1 if not supported
+--                int32_t requested: The requested size
+--                int32_t * effective: Set to the size the kernel actually uses
+--
+-- RETURNS: 1 if the kernel buffer is at least the requested size. Otherwise 0 is returned and
+--          lastSocketError is set appropriately.
+--
+-- NOTES:
+-- The forcing option is tried first so privileged processes are not limited by the system maximum.
+----------------------------------------------------------------------------------------------------------------------*/
+static int32_t applyBufferSize(struct socketStruct *socketPointer, int32_t optionName, int32_t forceOptionName, int32_t requested, int32_t *effective)
+{
+  int32_t actual = 0;
+  socklen_t actualLength = sizeof(actual);
+
+  if (forceOptionName == -1 ||
+      setsockopt(socketPointer->socketDescriptor, SOL_SOCKET, forceOptionName, &requested, sizeof(requested)) == -1)
+  {
+    if (setsockopt(socketPointer->socketDescriptor, SOL_SOCKET, optionName, &requested, sizeof(requested)) == -1)
+    {
+      lastSocketError = optionErrorCode(errno);
+      logger("ERROR > unable to set socket buffer size", lastSocketError);
+      return 0;
+    }
+  }
+  if (getsockopt(socketPointer->socketDescriptor, SOL_SOCKET, optionName, &actual, &actualLength) == -1)
+  {
+    lastSocketError = optionErrorCode(errno);
+    logger("ERROR > unable to read socket buffer size", lastSocketError);
+    return 0;
+  }
+
+  *effective = actual;
+  if (actual < requested)
+  {
+    lastSocketError = ERR_PERMISSION;
+    logger("ERROR > socket buffer size capped by system limit", actual);
+    return 0;
+  }
+  return 1;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: optionErrorCode
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS: October 18, 2026
+--              -Added multicast membership errors
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static int optionErrorCode(int errorNumber)
+--                int errorNumber: The errno value reported by a failed setsockopt or getsockopt
+--
+-- RETURNS: The ERR_ code corresponding to errorNumber.
+--    
+-- NOTES:
+-- Maps socket option failures to library error codes.
+----------------------------------------------------------------------------------------------------------------------*/
+static int32_t optionErrorCode(int32_t errorNumber)
+{
+  switch (errorNumber)
+  {
+  case EBADF:
+    return ERR_BADSOCK;
+  case ENOTSOCK:
+    return ERR_BADSOCK;
+  case EINVAL:
+    return ERR_ILLEGALOP;
+  case ENOPROTOOPT:
+    return ERR_ILLEGALOP;
+  case EOPNOTSUPP:
+    return ERR_ILLEGALOP;
+  case EPERM:
+    return ERR_PERMISSION;
+  case EACCES:
+    return ERR_PERMISSION;
+  case ENOMEM:
+    return ERR_NOMEMORY;
+  case EADDRINUSE:
+    return ERR_ADDRINUSE;
+  case EADDRNOTAVAIL:
+    return ERR_ADDRNOTAVAIL;
+  case ENODEV:
+    return ERR_ADDRNOTAVAIL;
+  default:
+    return ERR_UNKNOWN;
+  }
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: joinMulticastGroup
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int joinMulticastGroup(struct socketStruct* socketPointer, uint32_t groupAddress,
+--                                   uint32_t interfaceAddress)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct of a UDP socket
+--                uint32_t groupAddress: The multicast group to join, in network byte order
+--                uint32_t interfaceAddress: The address of the interface to join on, in network byte order,
+--                                           or INADDR_ANY to let the kernel choose
+--
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used to start receiving datagrams sent to a multicast group. The socket must be bound
+-- to the port the group is sent to. A socket may join many groups, and several sockets may join the same
+-- group if they set reuseAddress in their tuning. On Linux a socket bound to INADDR_ANY would otherwise
+-- receive every group any socket on the host joined on that port, so it is limited to its own groups.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t joinMulticastGroup(struct socketStruct *socketPointer, uint32_t groupAddress, uint32_t interfaceAddress)
+{
+#ifdef IP_MULTICAST_ALL
+  int32_t allGroups = 0;
+
+  if (socketPointer != 0)
+  {
+    setsockopt(socketPointer->socketDescriptor, IPPROTO_IP, IP_MULTICAST_ALL, &allGroups, sizeof(allGroups));
+  }
+#endif
+  return setMembership(socketPointer, IP_ADD_MEMBERSHIP, groupAddress, interfaceAddress);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: leaveMulticastGroup
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int leaveMulticastGroup(struct socketStruct* socketPointer, uint32_t groupAddress,
+--                                    uint32_t interfaceAddress)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct of a UDP socket
+--                uint32_t groupAddress: The multicast group to leave, in network byte order
+--                uint32_t interfaceAddress: The interface address the group was joined on
+--
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used to stop receiving a multicast group. Groups are also left when the socket closes.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t leaveMulticastGroup(struct socketStruct *socketPointer, uint32_t groupAddress, uint32_t interfaceAddress)
+{
+  return setMembership(socketPointer, IP_DROP_MEMBERSHIP, groupAddress, interfaceAddress);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: setMulticastTTL
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int setMulticastTTL(struct socketStruct* socketPointer, int32_t timeToLive)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct of a UDP socket
+--                int32_t timeToLive: The number of routers a multicast datagram may cross, 0 to 255
+--
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used to control how far multicast datagrams sent on the socket travel. The default of
+-- 1 keeps them on the local network, 0 keeps them on this host.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t setMulticastTTL(struct socketStruct *socketPointer, int32_t timeToLive)
+{
+  unsigned char value = timeToLive;
+
+  if (socketPointer == 0)
+  {
+    logger("ERROR > invalid socket passed to setMulticastTTL", -1);
+    return 0;
+  }
+  if (timeToLive < 0 || timeToLive > 255)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid time to live passed to setMulticastTTL", lastSocketError);
+    return 0;
+  }
+
+  if (setsockopt(socketPointer->socketDescriptor, IPPROTO_IP, IP_MULTICAST_TTL, &value, sizeof(value)) == -1)
+  {
+    lastSocketError = optionErrorCode(errno);
+    logger("ERROR > unable to set multicast time to live", lastSocketError);
+    return 0;
+  }
+  return 1;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: setMulticastLoopback
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int setMulticastLoopback(struct socketStruct* socketPointer, int32_t enable)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct of a UDP socket
+--                int32_t enable: 1 to deliver sent multicast datagrams to members on this host, 0 not to
+--
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used to decide whether group members on the sending host see what it sends. Loopback
+-- is on by default.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t setMulticastLoopback(struct socketStruct *socketPointer, int32_t enable)
+{
+  unsigned char value = enable ? 1 : 0;
+
+  if (socketPointer == 0)
+  {
+    logger("ERROR > invalid socket passed to setMulticastLoopback", -1);
+    return 0;
+  }
+
+  if (setsockopt(socketPointer->socketDescriptor, IPPROTO_IP, IP_MULTICAST_LOOP, &value, sizeof(value)) == -1)
+  {
+    lastSocketError = optionErrorCode(errno);
+    logger("ERROR > unable to set multicast loopback", lastSocketError);
+    return 0;
+  }
+  return 1;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: setMulticastInterface
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int setMulticastInterface(struct socketStruct* socketPointer, uint32_t interfaceAddress)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct of a UDP socket
+--                uint32_t interfaceAddress: The address of the interface to send multicast datagrams from,
+--                                           in network byte order, or INADDR_ANY for the routing default
+--
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used to choose the interface multicast datagrams leave from on hosts with more than one.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t setMulticastInterface(struct socketStruct *socketPointer, uint32_t interfaceAddress)
+{
+  struct in_addr address;
+
+  if (socketPointer == 0)
+  {
+    logger("ERROR > invalid socket passed to setMulticastInterface", -1);
+    return 0;
+  }
+
+  address.s_addr = interfaceAddress;
+  if (setsockopt(socketPointer->socketDescriptor, IPPROTO_IP, IP_MULTICAST_IF, &address, sizeof(address)) == -1)
+  {
+    lastSocketError = optionErrorCode(errno);
+    logger("ERROR > unable to set multicast interface", lastSocketError);
+    return 0;
+  }
+  return 1;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: setMembership
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static int setMembership(struct socketStruct* socketPointer, int32_t optionName,
+--                                     uint32_t groupAddress, uint32_t interfaceAddress)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct of a UDP socket
+--                int32_t optionName: IP_ADD_MEMBERSHIP or IP_DROP_MEMBERSHIP
+--                uint32_t groupAddress: The multicast group, in network byte order
+--                uint32_t interfaceAddress: The interface address, in network byte order
+--
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- Joins or leaves a group for joinMulticastGroup and leaveMulticastGroup.
+----------------------------------------------------------------------------------------------------------------------*/
+static int32_t setMembership(struct socketStruct *socketPointer, int32_t optionName, uint32_t groupAddress, uint32_t interfaceAddress)
+{
+  struct ip_mreq membership;
+
+  if (socketPointer == 0)
+  {
+    logger("ERROR > invalid socket passed to multicast membership", -1);
+    return 0;
+  }
+  if (!IN_MULTICAST(ntohl(groupAddress)))
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > address is not a multicast group", lastSocketError);
+    return 0;
+  }
+
+  membership.imr_multiaddr.s_addr = groupAddress;
+  membership.imr_interface.s_addr = interfaceAddress;
+  if (setsockopt(socketPointer->socketDescriptor, IPPROTO_IP, optionName, &membership, sizeof(membership)) == -1)
+  {
+    lastSocketError = optionErrorCode(errno);
+    logger(optionName == IP_ADD_MEMBERSHIP ? "ERROR > unable to join multicast group" : "ERROR > unable to leave multicast group", lastSocketError);
+    return 0;
+  }
+  return 1;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: bindPort
+--
+-- DATE: January 23rd, 2019
+--
+-- REVISIONS: 
+--
+-- DESIGNER: Simon Wu, Cameron Roberts
+--
+-- PROGRAMMER: Simon Wu, Cameron Roberts
+--
+-- INTERFACE: int bindPort(struct socketStruct* socketPointer, uint16_t port)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct whose
+--                                                     socket should be bound
+--                uint16_t: The port for the socket to be bound to. A port of 0 specifies 
+--                          an ephemeral port
+--
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used to initialize the socket contained within a socketStruct as a
+-- UDP socket. After the socket is initialized it should be bound to a port by calling
+-- bindPort. Use a port of 0 to specify an ephemeral port.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t bindPort(struct socketStruct *socketPointer, uint16_t port)
+{
+  struct sockaddr_in socketAddress;
+  memset((char *)&socketAddress, 0, sizeof(socketAddress));
+  socketAddress.sin_family = AF_INET;
+  socketAddress.sin_port = port;
+  socketAddress.sin_addr.s_addr = htonl(INADDR_ANY);
+
+  if (bind(socketPointer->socketDescriptor, (struct sockaddr *)&(socketAddress), sizeof(socketAddress)) == -1)
+  {
+    switch (errno)
+    {
+    case EACCES:
+      lastSocketError = ERR_PERMISSION;
+      break;
+    case EADDRINUSE:
+      lastSocketError = ERR_ADDRINUSE;
+      break;
+    case EINVAL:
+      lastSocketError = ERR_ILLEGALOP;
+      break;
+    case ENOTSOCK:
+      lastSocketError = ERR_BADSOCK;
+      break;
+    default:
+      lastSocketError = ERR_UNKNOWN;
+      break;
+    }
+    logger("ERROR > failed to bind name to socket", lastSocketError);
+    return 0;
+  }
+  //logger("SUCCESS > socket binded", socketPointer->socketDescriptor);
+  return 1;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: connectPort
+--
+-- DATE: January 23rd, 2019
+--
+-- REVISIONS: October 18, 2026
+--              -Moved error mapping into connectErrorCode
 --            January 23, 2019
 --              -Initial start
 --
--- DESIGNER: Cameron Roberts, Simon Wu
+-- DESIGNER: Simon Wu
 --
--- PROGRAMMER: Cameron Roberts, Simon Wu
+-- PROGRAMMER: Simon Wu, Cameron Roberts, agent
 --
--- INTERFACE: int sendData(struct socketStruct* socketPointer, struct destination * dest, const char* data, size_t dataLength)
---                struct socketStrict * socketPointer: A pointer to the socketStruct whose
---                                                     socket should be to send the data
---                struct destination * dest: A destination struct containing and IP address and port
---                const char * data: A char array containing the data to be sent
---                size_t dataLength: The length of the data in the char array
+-- INTERFACE: int connectPort(struct socketStruct* socketPointer, struct destination* dest)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct whose
+--                                                     socket should be used to connect
+--                struct destination* dest: A pointer to a destination constructor containing
+--                                          the address and port to connect to.
+--
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
+--    
+-- NOTES:
+-- This function is used to connect an initialized TCP socket to a destination.
+----------------------------------------------------------------------------------------------------------------------*/
+int connectPort(struct socketStruct *socketPointer, struct destination *dest)
+{
+  struct sockaddr_in destSockAddr;
+  memset((char *)&destSockAddr, 0, sizeof(destSockAddr));
+  destSockAddr.sin_family = AF_INET;
+  destSockAddr.sin_port = dest->port;
+  destSockAddr.sin_addr.s_addr = dest->address;
+
+  if (connect(socketPointer->socketDescriptor, (struct sockaddr *)&(destSockAddr), sizeof(destSockAddr)) == -1)
+  {
+    lastSocketError = connectErrorCode(errno);
+    logger("ERROR > unable to connect to server", lastSocketError);
+    return 0;
+  }
+  //logger("SUCCESS > connected to server", socketPointer->socketDescriptor);
+  return 1;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: connectPortTimeout
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int connectPortTimeout(struct socketStruct* socketPointer, struct destination* dest,
+--                                   int64_t waitMicroseconds)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct whose
+--                                                     socket should be used to connect
+--                struct destination* dest: A pointer to a destination constructor containing
+--                                          the address and port to connect to.
+--                int64_t waitMicroseconds: The maximum time to wait for the connection to complete.
+--                                          A negative value waits indefinitely.
+--
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
+--    
+-- NOTES:
+-- This function is used to connect an initialized TCP socket to a destination without blocking for longer
+-- than waitMicroseconds. The connect is started in non-blocking mode and the original file status flags of
+-- the socket are restored before returning. If the deadline expires lastSocketError is set to ERR_TIMEOUT and the
+-- socket should be closed, as the connection attempt may still be in progress.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t connectPortTimeout(struct socketStruct *socketPointer, struct destination *dest, int64_t waitMicroseconds)
+{
+  struct sockaddr_in destSockAddr;
+  int64_t deadline;
+  int32_t fileFlags;
+  int32_t result;
+  int32_t ready;
+  int32_t socketErrorValue;
+  socklen_t socketErrorLength = sizeof(socketErrorValue);
+
+  if (socketPointer == 0)
+  {
+    logger("ERROR > invalid socket passed to connectPortTimeout", -1);
+    return 0;
+  }
+  if (dest == 0)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid destination passed to connectPortTimeout", lastSocketError);
+    return 0;
+  }
+
+  deadline = waitMicroseconds < 0 ? -1 : monotonicMicroseconds() + waitMicroseconds;
+
+  memset((char *)&destSockAddr, 0, sizeof(destSockAddr));
+  destSockAddr.sin_family = AF_INET;
+  destSockAddr.sin_port = dest->port;
+  destSockAddr.sin_addr.s_addr = dest->address;
+
+  if ((fileFlags = fcntl(socketPointer->socketDescriptor, F_GETFL)) == -1 ||
+      fcntl(socketPointer->socketDescriptor, F_SETFL, fileFlags | O_NONBLOCK) == -1)
+  {
+    lastSocketError = ERR_BADSOCK;
+    logger("ERROR > unable to make socket non-blocking", lastSocketError);
+    return 0;
+  }
+
+  result = connect(socketPointer->socketDescriptor, (struct sockaddr *)&(destSockAddr), sizeof(destSockAddr));
+  if (result == -1 && errno == EINPROGRESS)
+  {
+    ready = waitForSocket(socketPointer->socketDescriptor, POLLOUT, deadline);
+    if (ready == 0)
+    {
+      fcntl(socketPointer->socketDescriptor, F_SETFL, fileFlags);
+      lastSocketError = ERR_TIMEOUT;
+      return 0;
+    }
+    if (ready == 1)
+    {
+      if (getsockopt(socketPointer->socketDescriptor, SOL_SOCKET, SO_ERROR, &socketErrorValue, &socketErrorLength) == -1)
+      {
+        socketErrorValue = errno;
+      }
+      result = socketErrorValue == 0 ? 0 : -1;
+      errno = socketErrorValue;
+    }
+  }
+  socketErrorValue = errno;
+  fcntl(socketPointer->socketDescriptor, F_SETFL, fileFlags);
+
+  if (result == -1)
+  {
+    lastSocketError = connectErrorCode(socketErrorValue);
+    logger("ERROR > unable to connect to server", lastSocketError);
+    return 0;
+  }
+  //logger("SUCCESS > connected to server", socketPointer->socketDescriptor);
+  return 1;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: connectErrorCode
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS: October 18, 2026
+--              -Declared in internal.h and exported for asyncConnect
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int connectErrorCode(int errorNumber)
+--                int errorNumber: The errno value reported by a failed connect
+--
+-- RETURNS: The ERR_ code corresponding to errorNumber.
+--    
+-- NOTES:
+-- Maps connect failures to library error codes for connectPort, connectPortTimeout and asyncConnect in
+-- asyncsocket.hpp. asyncConnect is compiled into the application, so unlike the rest of internal.h this
+-- function is not hidden.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t connectErrorCode(int32_t errorNumber)
+{
+  switch (errorNumber)
+  {
+  case EADDRNOTAVAIL:
+    return ERR_ADDRNOTAVAIL;
+  case EBADF:
+    return ERR_BADSOCK;
+  case ECONNREFUSED:
+    return ERR_CONREFUSED;
+  case EISCONN:
+    return ERR_ILLEGALOP;
+  case ENETUNREACH:
+    return ERR_DESTUNREACH;
+  case ENOTSOCK:
+    return ERR_BADSOCK;
+  case ECONNRESET:
+    return ERR_CONRESET;
+  case EHOSTUNREACH:
+    return ERR_DESTUNREACH;
+  case ENETDOWN:
+    return ERR_DESTUNREACH;
+  case EOPNOTSUPP:
+    return ERR_ILLEGALOP;
+  case EINVAL:
+    return ERR_ILLEGALOP;
+  case EINPROGRESS:
+    return ERR_TIMEOUT;
+  case ETIMEDOUT:
+    return ERR_TIMEOUT;
+  default:
+    return ERR_UNKNOWN;
+  }
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: listenTCP
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int listenTCP(struct socketStruct* socketPointer, int32_t backlog)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct of a bound TCP socket
+--                int32_t backlog: The maximum number of pending connections. A value of 0 or less uses
+--                                 SOMAXCONN.
+--
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
+--    
+-- NOTES:
+-- This function is used to make a bound TCP socket accept incoming connections. The kernel caps backlog
+-- at net.core.somaxconn.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t listenTCP(struct socketStruct *socketPointer, int32_t backlog)
+{
+  if (socketPointer == 0)
+  {
+    logger("ERROR > invalid socket passed to listenTCP", -1);
+    return 0;
+  }
+  if (backlog <= 0)
+  {
+    backlog = SOMAXCONN;
+  }
+
+  if (listen(socketPointer->socketDescriptor, backlog) == -1)
+  {
+    switch (errno)
+    {
+    case EADDRINUSE:
+      lastSocketError = ERR_ADDRINUSE;
+      break;
+    case EBADF:
+      lastSocketError = ERR_BADSOCK;
+      break;
+    case ENOTSOCK:
+      lastSocketError = ERR_BADSOCK;
+      break;
+    case EOPNOTSUPP:
+      lastSocketError = ERR_ILLEGALOP;
+      break;
+    default:
+      lastSocketError = ERR_UNKNOWN;
+      break;
+    }
+    logger("ERROR > unable to listen on socket", lastSocketError);
+    return 0;
+  }
+  //logger("SUCCESS > listening on socket", socketPointer->socketDescriptor);
+  return 1;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: acceptClient
+--
+-- DATE: January 31st, 2019
+--
+-- REVISIONS: January 31, 2019
+--              -Altered function to return a socket descriptor rather than a socketStruct
+--            January 23, 2019
+--              -Initial start
+--
+-- DESIGNER: Simon Wu
+--
+-- PROGRAMMER: Simon Wu, Cameron Roberts
+--
+-- INTERFACE: uint64_t acceptClient(struct socketStruct* socketPointer)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct whose
+--                                                     socket should be to accept an incoming
+--                                                     connection
+--
+-- RETURNS: On sucess a new socket descriptor is returned. On error NULL is
+--          returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used to accept a incoming TCP connection.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t acceptClient(struct socketStruct *socketPointer)
+{
+  struct sockaddr_in clientAddr;
+  memset((char *)&clientAddr, 0, sizeof(clientAddr));
+  socklen_t clientAddressLength = sizeof(clientAddr);
+  int32_t socketDescriptor;
+  if ((socketDescriptor = accept(socketPointer->socketDescriptor, (struct sockaddr *)&clientAddr, &clientAddressLength)) == -1)
+  {
+    switch (errno)
+    {
+    case EBADF:
+      lastSocketError = ERR_BADSOCK;
+      break;
+    case EINVAL:
+      lastSocketError = ERR_ILLEGALOP;
+      break;
+    case EPERM:
+      lastSocketError = ERR_PERMISSION;
+      break;
+    case ENOTSOCK:
+      lastSocketError = ERR_BADSOCK;
+      break;
+    default:
+      lastSocketError = ERR_UNKNOWN;
+      break;
+    }
+    logger("ERROR > failed to connect to client", lastSocketError);
+    return 0;
+  }
+  //logger("SUCCESS > client accepted", lastSocketError);
+  return socketDescriptor;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: acceptClients
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int acceptClients(struct socketStruct* socketPointer, struct socketStruct** clients,
+--                              struct destination* peers, int32_t maxClients)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct of a listening socket
+--                struct socketStruct ** clients: An array to place the new client sockets into
+--                struct destination * peers: An array to fill with the address and port of each client,
+--                                            or null
+--                int32_t maxClients: The number of entries in clients and peers
+--
+-- RETURNS: On success the number of clients accepted is returned. If no connection is pending on a
+--          non-blocking socket 0 is returned and lastSocketError is set to ERR_TIMEOUT.
+--          On error -1 is returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used to accept every pending connection in one call, which keeps a server responsive
+-- when many clients connect at once. The first accept blocks if the listening socket is blocking, after
+-- which only connections that are already pending are taken. Each client is returned in a socketStruct
+-- allocated with createSocket, to be released with closeSocket and freeSocket. Client sockets are
+-- non-blocking and close-on-exec, and inherit options such as TCP_NODELAY from the listening socket.
+-- sendDataTCP and recvDataTCP wait for the socket on their own, so they can still be used on clients.
+-- Connections aborted by the client before they are accepted are skipped.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t acceptClients(struct socketStruct *socketPointer, struct socketStruct **clients, struct destination *peers, int32_t maxClients)
+{
+  struct sockaddr_in clientAddr;
+  socklen_t clientAddressLength;
+  struct pollfd pollDescriptor;
+  int32_t listenerBlocking;
+  int32_t socketDescriptor;
+  int32_t accepted = 0;
+
+  if (socketPointer == 0)
+  {
+    logger("ERROR > invalid socket passed to acceptClients", -1);
+    return -1;
+  }
+  if (clients == 0 || maxClients <= 0)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid client array passed to acceptClients", lastSocketError);
+    return -1;
+  }
+
+  listenerBlocking = !(fcntl(socketPointer->socketDescriptor, F_GETFL) & O_NONBLOCK);
+  pollDescriptor.fd = socketPointer->socketDescriptor;
+  pollDescriptor.events = POLLIN;
+
+  while (accepted < maxClients)
+  {
+    if (accepted > 0 && listenerBlocking && poll(&pollDescriptor, 1, 0) != 1)
+    {
+      break;
+    }
+
+    clientAddressLength = sizeof(clientAddr);
+#ifdef __linux__
+    socketDescriptor = accept4(socketPointer->socketDescriptor, (struct sockaddr *)&clientAddr, &clientAddressLength, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+    if ((socketDescriptor = accept(socketPointer->socketDescriptor, (struct sockaddr *)&clientAddr, &clientAddressLength)) != -1)
+    {
+      fcntl(socketDescriptor, F_SETFL, fcntl(socketDescriptor, F_GETFL) | O_NONBLOCK);
+      fcntl(socketDescriptor, F_SETFD, FD_CLOEXEC);
+    }
+#endif
+    if (socketDescriptor == -1)
+    {
+      if (errno == EINTR || errno == ECONNABORTED)
+      {
+        continue;
+      }
+      if (errno == EWOULDBLOCK || errno == EAGAIN)
+      {
+        if (accepted == 0)
+        {
+          lastSocketError = ERR_TIMEOUT;
+        }
+        break;
+      }
+      switch (errno)
+      {
+      case EBADF:
+        lastSocketError = ERR_BADSOCK;
+        break;
+      case EINVAL:
+        lastSocketError = ERR_ILLEGALOP;
+        break;
+      case EPERM:
+        lastSocketError = ERR_PERMISSION;
+        break;
+      case ENOTSOCK:
+        lastSocketError = ERR_BADSOCK;
+        break;
+      case EMFILE:
+        lastSocketError = ERR_NOMEMORY;
+        break;
+      case ENFILE:
+        lastSocketError = ERR_NOMEMORY;
+        break;
+      case ENOBUFS:
+        lastSocketError = ERR_NOMEMORY;
+        break;
+      case ENOMEM:
+        lastSocketError = ERR_NOMEMORY;
+        break;
+      default:
+        lastSocketError = ERR_UNKNOWN;
+        break;
+      }
+      logger("ERROR > failed to connect to client", lastSocketError);
+      return accepted > 0 ? accepted : -1;
+    }
+
+    if ((clients[accepted] = createSocket()) == 0)
+    {
+      close(socketDescriptor);
+      lastSocketError = ERR_NOMEMORY;
+      logger("ERROR > unable to allocate client socket", lastSocketError);
+      return accepted > 0 ? accepted : -1;
+    }
+    clients[accepted]->socketDescriptor = socketDescriptor;
+    if (peers != 0)
+    {
+      peers[accepted].address = clientAddr.sin_addr.s_addr;
+      peers[accepted].port = clientAddr.sin_port;
+    }
+    accepted++;
+  }
+
+  //logger("SUCCESS > clients accepted", accepted);
+  return accepted;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: sendDataTCP
+--
+-- DATE: April 3rd, 2019
+--
+-- REVISIONS: October 18, 2026
+--              -Keep sending after a short write until all data is sent
+--              -Report a closed connection as ERR_CONRESET instead of raising SIGPIPE
+--              -Wait for room on non-blocking sockets instead of failing part way
+--              -Moved error mapping into streamSendErrorCode
+--            April 3, 2019
+--              -Added null checks for pointers
+--            January 23, 2019
+--              -Initial start
+--
+-- DESIGNER: Simon Wu
+--
+-- PROGRAMMER: Simon Wu, Cameron Roberts, agent
+--
+-- INTERFACE: int sendDataTCP(struct socketStruct* socketPointer, const char* data, size_t dataLength)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct whose
+--                                                     socket should be to send the data
+--                const char * data: A char array containing the data to be sent
+--                size_t dataLength: The length of the data in the char array
+--
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used to send data on a connected TCP socket. The kernel may accept only part of a large
+-- buffer, or be interrupted by a signal, so the rest is sent until all of it has been written. On a
+-- non-blocking socket, such as those returned by acceptClients, the function waits for the send buffer to
+-- drain rather than failing. If a send timeout expires part way, ERR_TIMEOUT is reported and the stream
+-- should be treated as broken.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t sendDataTCP(struct socketStruct *socketPointer, const char *data, uint64_t dataLength)
+{
+  struct captureLog *capture;
+  uint64_t sent = 0;
+  int64_t sendCount;
+  int32_t sendFlags = 0;
+
+#ifdef MSG_NOSIGNAL
+  sendFlags = MSG_NOSIGNAL;
+#endif
+  if (socketPointer == 0)
+  {
+    logger("ERROR > invalid socket passed to sendDataTCP", -1);
+    return 0;
+  }
+  if (data == 0)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid data passed to sendDataTCP", lastSocketError);
+    return 0;
+  }
+  while (sent < dataLength)
+  {
+    sendCount = send(socketPointer->socketDescriptor, data + sent, dataLength - sent, sendFlags);
+    if (sendCount < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (sendCount < 0 && (errno == EWOULDBLOCK || errno == EAGAIN) &&
+        waitIfNonBlocking(socketPointer->socketDescriptor, POLLOUT) == 1)
+    {
+      // The send buffer of a non-blocking socket is full, keep what was sent and wait for room
+      continue;
+    }
+    if (sendCount < 0)
+    {
+      lastSocketError = streamSendErrorCode(errno);
+      logger("ERROR > failed to send TCP data", lastSocketError);
+      return 0;
+    }
+    sent += sendCount;
+  }
+  if ((capture = getSocketHook(socketPointer->socketDescriptor, HOOK_CAPTURE)) != 0)
+  {
+    hookFunctions.capturePacket(capture, socketPointer->socketDescriptor, CAPTURE_SEND | CAPTURE_TCP, 0, data, dataLength);
+  }
+  //logger("SUCCESS > sent TCP data", socketPointer->socketDescriptor);
+  return 1;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: sendDataTCPTimeout
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int64_t sendDataTCPTimeout(struct socketStruct* socketPointer, const char* data, uint64_t dataLength,
+--                                      int64_t waitMicroseconds)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct whose
+--                                                     socket should be to send the data
+--                const char * data: A char array containing the data to be sent
+--                uint64_t dataLength: The length of the data in the char array
+--                int64_t waitMicroseconds: The maximum time to wait for room in the send buffer.
+--                                          A negative value waits indefinitely.
+--
+-- RETURNS: The number of characters sent, or -1 on error with lastSocketError set appropriately.
+--
+-- NOTES:
+-- This function behaves like sendDataTCP but gives up once waitMicroseconds have elapsed, and reports how
+-- much was sent so the caller can carry on from there. The deadline covers the whole send. When it expires
+-- lastSocketError is set to ERR_TIMEOUT and the number of characters sent so far is returned, or -1 if
+-- nothing was sent. With waitMicroseconds of 0 it sends what fits without waiting, which is what the
+-- coroutine interface uses. The socket options are not modified, and timeouts are not logged.
+----------------------------------------------------------------------------------------------------------------------*/
+int64_t sendDataTCPTimeout(struct socketStruct *socketPointer, const char *data, uint64_t dataLength, int64_t waitMicroseconds)
+{
+  struct captureLog *capture;
+  uint64_t sent = 0;
+  int64_t sendCount;
+  int64_t deadline;
+  int32_t ready;
+  int32_t sendFlags = MSG_DONTWAIT;
+
+#ifdef MSG_NOSIGNAL
+  sendFlags |= MSG_NOSIGNAL;
+#endif
+  if (socketPointer == 0)
+  {
+    logger("ERROR > invalid socket passed to sendDataTCPTimeout", -1);
+    return -1;
+  }
+  if (data == 0)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid data passed to sendDataTCPTimeout", lastSocketError);
+    return -1;
+  }
+
+  deadline = waitMicroseconds < 0 ? -1 : monotonicMicroseconds() + waitMicroseconds;
+
+  while (sent < dataLength)
+  {
+    sendCount = send(socketPointer->socketDescriptor, data + sent, dataLength - sent, sendFlags);
+    if (sendCount >= 0)
+    {
+      sent += sendCount;
+      continue;
+    }
+    if (errno == EINTR)
+    {
+      continue;
+    }
+    if (errno == EWOULDBLOCK || errno == EAGAIN)
+    {
+      // Try first and wait only when the send buffer is full, the common case costs one system call
+      ready = waitForSocket(socketPointer->socketDescriptor, POLLOUT, deadline);
+      if (ready == 1)
+      {
+        continue;
+      }
+      if (ready == 0)
+      {
+        lastSocketError = ERR_TIMEOUT;
+        break;
+      }
+    }
+    lastSocketError = streamSendErrorCode(errno);
+    logger("ERROR > failed to send TCP data", lastSocketError);
+    return -1;
+  }
+  if (sent > 0 && (capture = getSocketHook(socketPointer->socketDescriptor, HOOK_CAPTURE)) != 0)
+  {
+    hookFunctions.capturePacket(capture, socketPointer->socketDescriptor, CAPTURE_SEND | CAPTURE_TCP, 0, data, sent);
+  }
+  //logger("SUCCESS > sent TCP data", socketPointer->socketDescriptor);
+  return sent == 0 && dataLength > 0 ? -1 : (int64_t)sent;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: sendData
+--
+-- DATE: April 3rd, 2019
+--
+-- REVISIONS: October 18, 2026
+--              -Send through the network emulator when one is attached
+--              -Moved error mapping into sendErrorCode
+--            April 3, 2019
+--              -Added null check for pointers
+--            March 6, 2019
+--              -Change failure return to return errno instead
+--            January 23, 2019
+--              -Initial start
+--
+-- DESIGNER: Cameron Roberts, Simon Wu
+--
+-- PROGRAMMER: Cameron Roberts, Simon Wu, agent
+--
+-- INTERFACE: int sendData(struct socketStruct* socketPointer, struct destination * dest, const char* data, size_t dataLength)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct whose
+--                                                     socket should be to send the data
+--                struct destination * dest: A destination struct containing and IP address and port
+--                const char * data: A char array containing the data to be sent
+--                size_t dataLength: The length of the data in the char array
+--
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used to send data on a bound UDP port. The data will be sent to the IP address and port
+-- specified in the destination struct.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t sendData(struct socketStruct *socketPointer, struct destination *dest, const char *data, uint64_t dataLength)
+{
+  struct captureLog *capture;
+  struct netemShim *shim;
+  if (socketPointer == 0)
+  {
+    logger("ERROR > invalid socket passed to sendData", -1);
+    return 0;
+  }
+  if (dest == 0 || data == 0)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid data or destination address passed to sendData", lastSocketError);
+    return 0;
+  }
+  struct sockaddr_in destSockAddr;
+  memset((char *)&destSockAddr, 0, sizeof(destSockAddr));
+  destSockAddr.sin_family = AF_INET;
+  destSockAddr.sin_port = dest->port;
+  destSockAddr.sin_addr.s_addr = dest->address;
+  if ((shim = getSocketHook(socketPointer->socketDescriptor, HOOK_NETEM)) != 0)
+  {
+    if (!hookFunctions.netemSend(shim, dest, data, dataLength))
+    {
+      return 0;
+    }
+  }
+  else if (sendto(socketPointer->socketDescriptor, data, dataLength, 0, (struct sockaddr *)&destSockAddr, sizeof(destSockAddr)) < 0)
+  {
+    lastSocketError = sendErrorCode(errno);
+    logger("ERROR > failed to send UDP data", lastSocketError);
+    return 0;
+  }
+  if ((capture = getSocketHook(socketPointer->socketDescriptor, HOOK_CAPTURE)) != 0)
+  {
+    hookFunctions.capturePacket(capture, socketPointer->socketDescriptor, CAPTURE_SEND, dest, data, dataLength);
+  }
+  //logger("SUCCESS > sent UDP data", socketPointer->socketDescriptor);
+  return 1;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: sendDataGroup
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS: October 18, 2026
+--              -Send through the network emulator when one is attached
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int sendDataGroup(struct socketStruct* socketPointer, struct destination * groups,
+--                              int32_t groupCount, const char* data, size_t dataLength)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct of a UDP socket
+--                struct destination * groups: The multicast groups or unicast addresses to send to
+--                int32_t groupCount: The number of entries in groups
+--                const char * data: A char array containing the data to be sent
+--                size_t dataLength: The length of the data in the char array
+--
+-- RETURNS: The number of destinations the datagram was sent to. If this is less than groupCount,
+--          lastSocketError is set for the destination that failed.
+--
+-- NOTES:
+-- This function is used to send one datagram to several destinations. Each multicast group costs one send
+-- however many members it has, and up to SEND_BATCH_MAX destinations are handed to the kernel in a single
+-- system call where sendmmsg is available. Groups and plain addresses may be mixed, so viewers that cannot
+-- receive multicast can be listed alongside the groups. Sending stops at the first destination that fails.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t sendDataGroup(struct socketStruct *socketPointer, struct destination *groups, int32_t groupCount, const char *data, size_t dataLength)
+{
+  struct captureLog *capture;
+  struct netemShim *shim;
+  struct sockaddr_in groupAddresses[SEND_BATCH_MAX];
+  int32_t chunk;
+  int32_t sent = 0;
+  int32_t result;
+  int32_t i;
+#ifdef __linux__
+  struct mmsghdr messages[SEND_BATCH_MAX];
+  struct iovec dataVector;
+#endif
+
+  if (socketPointer == 0)
+  {
+    logger("ERROR > invalid socket passed to sendDataGroup", -1);
+    return 0;
+  }
+  if (groups == 0 || data == 0 || groupCount < 0)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid data or destination addresses passed to sendDataGroup", lastSocketError);
+    return 0;
+  }
+  if ((shim = getSocketHook(socketPointer->socketDescriptor, HOOK_NETEM)) != 0)
+  {
+    for (sent = 0; sent < groupCount && hookFunctions.netemSend(shim, &groups[sent], data, dataLength); sent++)
+    {
+      if ((capture = getSocketHook(socketPointer->socketDescriptor, HOOK_CAPTURE)) != 0)
+      {
+        hookFunctions.capturePacket(capture, socketPointer->socketDescriptor, CAPTURE_SEND, &groups[sent], data, dataLength);
+      }
+    }
+    return sent;
+  }
+
+#ifdef __linux__
+  dataVector.iov_base = (void *)data;
+  dataVector.iov_len = dataLength;
+#endif
+
+  while (sent < groupCount)
+  {
+    chunk = groupCount - sent < SEND_BATCH_MAX ? groupCount - sent : SEND_BATCH_MAX;
+    for (i = 0; i < chunk; i++)
+    {
+      memset(&groupAddresses[i], 0, sizeof(groupAddresses[i]));
+      groupAddresses[i].sin_family = AF_INET;
+      groupAddresses[i].sin_port = groups[sent + i].port;
+      groupAddresses[i].sin_addr.s_addr = groups[sent + i].address;
+#ifdef __linux__
+      memset(&messages[i], 0, sizeof(messages[i]));
+      messages[i].msg_hdr.msg_name = &groupAddresses[i];
+      messages[i].msg_hdr.msg_namelen = sizeof(groupAddresses[i]);
+      messages[i].msg_hdr.msg_iov = &dataVector;
+      messages[i].msg_hdr.msg_iovlen = 1;
+#endif
+    }
+
+#ifdef __linux__
+    result = sendmmsg(socketPointer->socketDescriptor, messages, chunk, 0);
+#else
+    // sendmmsg is Linux only, so send one datagram at a time and report how many went out
+    for (result = 0; result < chunk; result++)
+    {
+      if (sendto(socketPointer->socketDescriptor, data, dataLength, 0, (struct sockaddr *)&groupAddresses[result], sizeof(groupAddresses[result])) < 0)
+      {
+        result = result == 0 ? -1 : result;
+        break;
+      }
+    }
+#endif
+    if (result == -1 && errno == EINTR)
+    {
+      continue;
+    }
+    if (result <= 0)
+    {
+      lastSocketError = sendErrorCode(errno);
+      logger("ERROR > failed to send UDP data to group", lastSocketError);
+      return sent;
+    }
+    for (i = 0, capture = getSocketHook(socketPointer->socketDescriptor, HOOK_CAPTURE); capture != 0 && i < result; i++)
+    {
+      hookFunctions.capturePacket(capture, socketPointer->socketDescriptor, CAPTURE_SEND, &groups[sent + i], data, dataLength);
+    }
+    sent += result;
+  }
+  //logger("SUCCESS > sent UDP data to group", socketPointer->socketDescriptor);
+  return sent;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: sendDataBatch
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int sendDataBatch(struct socketStruct* socketPointer, struct sendPacket * packets,
+--                              int32_t packetCount)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct of a UDP socket
+--                struct sendPacket * packets: The datagrams to send, each with its own destination
+--                int32_t packetCount: The number of entries in packets
+--
+-- RETURNS: The number of datagrams sent. If this is less than packetCount, lastSocketError is set for the
+--          datagram that failed.
+--
+-- NOTES:
+-- This function is the sending counterpart of recvDataBatch. Up to SEND_BATCH_MAX datagrams are handed to
+-- the kernel in a single system call where sendmmsg is available, which suits servers that collect a
+-- frame's worth of updates and send them together. Sending stops at the first datagram that fails, so the
+-- caller can skip it and send the rest.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t sendDataBatch(struct socketStruct *socketPointer, struct sendPacket *packets, int32_t packetCount)
+{
+  struct captureLog *capture;
+  struct netemShim *shim;
+  struct sockaddr_in destAddresses[SEND_BATCH_MAX];
+  int32_t chunk;
+  int32_t sent = 0;
+  int32_t result;
+  int32_t i;
+#ifdef __linux__
+  struct mmsghdr messages[SEND_BATCH_MAX];
+  struct iovec dataVectors[SEND_BATCH_MAX];
+#endif
+
+  if (socketPointer == 0)
+  {
+    logger("ERROR > invalid socket passed to sendDataBatch", -1);
+    return 0;
+  }
+  if (packets == 0 || packetCount < 0)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid packet array passed to sendDataBatch", lastSocketError);
+    return 0;
+  }
+  if ((shim = getSocketHook(socketPointer->socketDescriptor, HOOK_NETEM)) != 0)
+  {
+    for (sent = 0; sent < packetCount && hookFunctions.netemSend(shim, &packets[sent].dest, packets[sent].data, packets[sent].dataLength); sent++)
+    {
+      if ((capture = getSocketHook(socketPointer->socketDescriptor, HOOK_CAPTURE)) != 0)
+      {
+        hookFunctions.capturePacket(capture, socketPointer->socketDescriptor, CAPTURE_SEND, &packets[sent].dest, packets[sent].data, packets[sent].dataLength);
+      }
+    }
+    return sent;
+  }
+
+  while (sent < packetCount)
+  {
+    chunk = packetCount - sent < SEND_BATCH_MAX ? packetCount - sent : SEND_BATCH_MAX;
+    for (i = 0; i < chunk; i++)
+    {
+      memset(&destAddresses[i], 0, sizeof(destAddresses[i]));
+      destAddresses[i].sin_family = AF_INET;
+      destAddresses[i].sin_port = packets[sent + i].dest.port;
+      destAddresses[i].sin_addr.s_addr = packets[sent + i].dest.address;
+#ifdef __linux__
+      dataVectors[i].iov_base = (void *)packets[sent + i].data;
+      dataVectors[i].iov_len = packets[sent + i].dataLength;
+      memset(&messages[i], 0, sizeof(messages[i]));
+      messages[i].msg_hdr.msg_name = &destAddresses[i];
+      messages[i].msg_hdr.msg_namelen = sizeof(destAddresses[i]);
+      messages[i].msg_hdr.msg_iov = &dataVectors[i];
+      messages[i].msg_hdr.msg_iovlen = 1;
+#endif
+    }
+
+#ifdef __linux__
+    result = sendmmsg(socketPointer->socketDescriptor, messages, chunk, 0);
+#else
+    // sendmmsg is Linux only, so send one datagram at a time and report how many went out
+    for (result = 0; result < chunk; result++)
+    {
+      if (sendto(socketPointer->socketDescriptor, packets[sent + result].data, packets[sent + result].dataLength, 0, (struct sockaddr *)&destAddresses[result], sizeof(destAddresses[result])) < 0)
+      {
+        result = result == 0 ? -1 : result;
+        break;
+      }
+    }
+#endif
+    if (result == -1 && errno == EINTR)
+    {
+      continue;
+    }
+    if (result <= 0)
+    {
+      lastSocketError = sendErrorCode(errno);
+      logger("ERROR > failed to send UDP data batch", lastSocketError);
+      return sent;
+    }
+    for (i = 0, capture = getSocketHook(socketPointer->socketDescriptor, HOOK_CAPTURE); capture != 0 && i < result; i++)
+    {
+      hookFunctions.capturePacket(capture, socketPointer->socketDescriptor, CAPTURE_SEND, &packets[sent + i].dest, packets[sent + i].data, packets[sent + i].dataLength);
+    }
+    sent += result;
+  }
+  //logger("SUCCESS > sent UDP data batch", socketPointer->socketDescriptor);
+  return sent;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: recvDataTCP
+--
+-- DATE: April 3rd, 2019
+--
+-- REVISIONS: October 18, 2026
+--              -Count the final read, a complete read returned 0
+--              -Moved error mapping into receiveErrorCode
+--              -Resume after signals and wait for the rest on non-blocking sockets
+--            April 3, 2019
+--              -Added null check for pointers
+--            March 6, 2019
+--              -Change failure return to return errno instead
+--            January 23, 2019
+--              -Initial start
+--
+-- DESIGNER: Simon Wu
+--
+-- PROGRAMMER: Simon Wu, Cameron Roberts, agent
+--
+-- INTERFACE: int recvDataTCP(struct socketStruct* socketPointer, char* dataBuffer, int32_t packetSize)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct whose
+--                                                     socket should be read from
+--                const char * data: A char array containing the data to be sent
+--                int32_t packetSize: The number of characters to read
+--
+-- RETURNS: The number of characters read into dataBuffer or -1 on error.
+--
+-- NOTES:
+-- This function is used to recieve data from a connected TCP socket. The function will continue
+-- until packetSize characters have been read or an error occurs. If an error occurs errno will
+-- be set accordingly. On a non-blocking socket, such as those returned by acceptClients, the function
+-- waits for the rest of the data rather than failing part way; use recvDataTCPTimeout to bound the wait.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t recvDataTCP(struct socketStruct *socketPointer, char *dataBuffer, int32_t packetSize)
+{
+  struct captureLog *capture;
+  int readCount;
+  int32_t length = packetSize;
+
+  if (socketPointer == 0)
+  {
+    logger("ERROR > invalid socket passed to recvDataTCP", -1);
+    return 0;
+  }
+  if (dataBuffer == 0)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid data passed to recvDataTCP", lastSocketError);
+    return 0;
+  }
+
+  while (length > 0)
+  {
+    readCount = recv(socketPointer->socketDescriptor, dataBuffer, length, 0);
+    if (readCount == 0)
+    {
+      // Other side disconnected
+      return readCount;
+    }
+    if (readCount == -1 && errno == EINTR)
+    {
+      continue;
+    }
+    if (readCount == -1 && (errno == EWOULDBLOCK || errno == EAGAIN) &&
+        waitIfNonBlocking(socketPointer->socketDescriptor, POLLIN) == 1)
+    {
+      // Nothing more is queued on a non-blocking socket yet, keep what was read and wait for the rest
+      continue;
+    }
+    if (readCount == -1)
+    {
+      lastSocketError = receiveErrorCode(errno);
+      logger("ERROR > failed to receive TCP data", lastSocketError);
+      return -1;
+    }
+    dataBuffer += readCount;
+    length -= readCount;
+  }
+  if ((capture = getSocketHook(socketPointer->socketDescriptor, HOOK_CAPTURE)) != 0)
+  {
+    hookFunctions.capturePacket(capture, socketPointer->socketDescriptor, CAPTURE_RECV | CAPTURE_TCP, 0, dataBuffer - (packetSize - length), packetSize - length);
+  }
+  //logger("SUCCESS > received TCP data", socketPointer->socketDescriptor);
+  return packetSize - length;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: recvDataTCPTimeout
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int recvDataTCPTimeout(struct socketStruct* socketPointer, char* dataBuffer, int32_t packetSize,
+--                                   int64_t waitMicroseconds)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct whose
+--                                                     socket should be read from
+--                char * dataBuffer: An array for received data to be placed into
+--                int32_t packetSize: The number of characters to read
+--                int64_t waitMicroseconds: The maximum time to wait for packetSize characters.
+--                                          A negative value waits indefinitely.
+--
+-- RETURNS: The number of characters read into dataBuffer, 0 if the other side disconnected, or -1 on error.
+--
+-- NOTES:
+-- This function behaves like recvDataTCP but gives up once waitMicroseconds have elapsed. The deadline
+-- covers the whole read rather than each recv call. When the deadline expires lastSocketError is set to ERR_TIMEOUT
+-- and the number of characters read so far is returned, or -1 if nothing was read. The socket options are
+-- not modified so the function can be called on every tick without extra system calls. Timeouts are an
+-- expected result and are not logged.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t recvDataTCPTimeout(struct socketStruct *socketPointer, char *dataBuffer, int32_t packetSize, int64_t waitMicroseconds)
+{
+  struct captureLog *capture;
+  int64_t deadline;
+  int32_t readCount;
+  int32_t ready;
+  int32_t length = packetSize;
+
+  if (socketPointer == 0)
+  {
+    logger("ERROR > invalid socket passed to recvDataTCPTimeout", -1);
+    return -1;
+  }
+  if (dataBuffer == 0)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid data passed to recvDataTCPTimeout", lastSocketError);
+    return -1;
+  }
+
+  deadline = waitMicroseconds < 0 ? -1 : monotonicMicroseconds() + waitMicroseconds;
+
+  while (length > 0)
+  {
+    ready = waitForSocket(socketPointer->socketDescriptor, POLLIN, deadline);
+    if (ready == 0)
+    {
+      lastSocketError = ERR_TIMEOUT;
+      return length == packetSize ? -1 : packetSize - length;
+    }
+    if (ready == -1)
+    {
+      lastSocketError = receiveErrorCode(errno);
+      logger("ERROR > failed to wait for TCP data", lastSocketError);
+      return -1;
+    }
+
+    readCount = recv(socketPointer->socketDescriptor, dataBuffer, length, MSG_DONTWAIT);
+    if (readCount == 0)
+    {
+      // Other side disconnected
+      return readCount;
+    }
+    if (readCount == -1)
+    {
+      if (errno == EINTR || errno == EWOULDBLOCK || errno == EAGAIN)
+      {
+        continue;
+      }
+      lastSocketError = receiveErrorCode(errno);
+      logger("ERROR > failed to receive TCP data", lastSocketError);
+      return -1;
+    }
+    dataBuffer += readCount;
+    length -= readCount;
+  }
+  if ((capture = getSocketHook(socketPointer->socketDescriptor, HOOK_CAPTURE)) != 0)
+  {
+    hookFunctions.capturePacket(capture, socketPointer->socketDescriptor, CAPTURE_RECV | CAPTURE_TCP, 0, dataBuffer - (packetSize - length), packetSize - length);
+  }
+  //logger("SUCCESS > received TCP data", socketPointer->socketDescriptor);
+  return packetSize - length;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: recvData
+--
+-- DATE: April 3rd, 2019
+--
+-- REVISIONS: October 18, 2026
+--              -Moved error mapping into receiveErrorCode
+--            April 3, 2019
+--              -Added null checks for pointers
+--            January 23, 2019
+--              -Initial start
+--
+-- DESIGNER: Cameron Roberts, Simon Wu
+--
+-- PROGRAMMER: Cameron Roberts, Simon Wu, agent
+--
+-- INTERFACE: int recvData(struct socketStruct* socketPointer, char * dataBuffer, size_t dataBufferLength)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct whose
+--                                                     socket should be read from
+--                struct destination dest: A destination struct to fill with the address and port data was
+--                                         recieved from
+--                const char * dataBuffer: An array for received data to be placed into
+--                size_t dataBufferSize: The size of dataBuffer
+--
+-- RETURNS: On success the number of bytes read into dataBuffer is returned. 
+--          On error -1 is returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used to receive data from a bound UDP port.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t recvData(struct socketStruct *socketPointer, struct destination *dest, char *dataBuffer, size_t dataBufferSize)
+{
+  struct captureLog *capture;
+  struct sockaddr_in destSockAddr;
+  socklen_t destSockAddrSize = sizeof(destSockAddr);
+  int bytesReceived;
+
+  if (socketPointer == 0)
+  {
+    logger("ERROR > invalid socket passed to recvData", -1);
+    return -1;
+  }
+  if (dest == 0 || dataBuffer == 0)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid data or destination structure passed to recvData", lastSocketError);
+    return -1;
+  }
+
+  int retry = 1;
+  while(retry){
+    if ((bytesReceived = recvfrom(socketPointer->socketDescriptor, dataBuffer, dataBufferSize, 0, (struct sockaddr *)&destSockAddr, &destSockAddrSize)) < 0)
+    {
+      if(errno == EINTR){
+        continue;
+      }
+      retry = 0;
+
+      lastSocketError = receiveErrorCode(errno);
+      logger("ERROR > failed to receive UDP data", lastSocketError);
+      return -1;
+    }
+    retry = 0;
+  }
+
+  dest->address = destSockAddr.sin_addr.s_addr;
+  dest->port = destSockAddr.sin_port;
+
+  if ((capture = getSocketHook(socketPointer->socketDescriptor, HOOK_CAPTURE)) != 0)
+  {
+    hookFunctions.capturePacket(capture, socketPointer->socketDescriptor, CAPTURE_RECV, dest, dataBuffer, bytesReceived);
+  }
+  //logger("SUCCESS > received UDP data", socketPointer->socketDescriptor);
+  return bytesReceived;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: recvDataTimeout
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int recvDataTimeout(struct socketStruct* socketPointer, struct destination * dest, char * dataBuffer,
+--                                size_t dataBufferSize, int64_t waitMicroseconds)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct whose
+--                                                     socket should be read from
+--                struct destination dest: A destination struct to fill with the address and port data was
+--                                         recieved from
+--                char * dataBuffer: An array for received data to be placed into
+--                size_t dataBufferSize: The size of dataBuffer
+--                int64_t waitMicroseconds: The maximum time to wait for a datagram. A value of 0 only checks
+--                                          for a queued datagram and a negative value waits indefinitely.
+--
+-- RETURNS: On success the number of bytes read into dataBuffer is returned. 
+--          On error -1 is returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function behaves like recvData but waits at most waitMicroseconds for a datagram to arrive, using
+-- ppoll rather than the SO_RCVTIMEO socket option. If no datagram arrives in time lastSocketError is set to
+-- ERR_TIMEOUT. Timeouts are an expected result and are not logged.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t recvDataTimeout(struct socketStruct *socketPointer, struct destination *dest, char *dataBuffer, size_t dataBufferSize, int64_t waitMicroseconds)
+{
+  struct captureLog *capture;
+  struct sockaddr_in destSockAddr;
+  socklen_t destSockAddrSize = sizeof(destSockAddr);
+  int64_t deadline;
+  int32_t ready;
+  int bytesReceived;
+
+  if (socketPointer == 0)
+  {
+    logger("ERROR > invalid socket passed to recvDataTimeout", -1);
+    return -1;
+  }
+  if (dest == 0 || dataBuffer == 0)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid data or destination structure passed to recvDataTimeout", lastSocketError);
+    return -1;
+  }
+
+  deadline = waitMicroseconds < 0 ? -1 : monotonicMicroseconds() + waitMicroseconds;
+
+  for (;;)
+  {
+    ready = waitForSocket(socketPointer->socketDescriptor, POLLIN, deadline);
+    if (ready == 0)
+    {
+      lastSocketError = ERR_TIMEOUT;
+      return -1;
+    }
+    if (ready == -1)
+    {
+      lastSocketError = receiveErrorCode(errno);
+      logger("ERROR > failed to wait for UDP data", lastSocketError);
+      return -1;
+    }
+
+    destSockAddrSize = sizeof(destSockAddr);
+    if ((bytesReceived = recvfrom(socketPointer->socketDescriptor, dataBuffer, dataBufferSize, MSG_DONTWAIT, (struct sockaddr *)&destSockAddr, &destSockAddrSize)) >= 0)
+    {
+      break;
+    }
+    if (errno == EINTR || errno == EWOULDBLOCK || errno == EAGAIN)
+    {
+      continue;
+    }
+    lastSocketError = receiveErrorCode(errno);
+    logger("ERROR > failed to receive UDP data", lastSocketError);
+    return -1;
+  }
+
+  dest->address = destSockAddr.sin_addr.s_addr;
+  dest->port = destSockAddr.sin_port;
+
+  if ((capture = getSocketHook(socketPointer->socketDescriptor, HOOK_CAPTURE)) != 0)
+  {
+    hookFunctions.capturePacket(capture, socketPointer->socketDescriptor, CAPTURE_RECV, dest, dataBuffer, bytesReceived);
+  }
+  //logger("SUCCESS > received UDP data", socketPointer->socketDescriptor);
+  return bytesReceived;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: enableTimestamping
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int enableTimestamping(struct socketStruct* socketPointer, int32_t timestampFlags)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct to enable timestamping on
+--                int32_t timestampFlags: A combination of TIMESTAMP_SOFTWARE, TIMESTAMP_HARDWARE and
+--                                        TIMESTAMP_TX. A value of 0 disables timestamping.
+--
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used to request kernel timestamps (SO_TIMESTAMPING) on a UDP socket created by initSocket.
+-- Receive timestamps are returned by recvDataTimestamp and recvDataBatch. With TIMESTAMP_TX the kernel also
+-- queues a timestamp for every datagram sent, which must be read with recvTxTimestamp; an undrained error
+-- queue keeps the socket reporting POLLERR. Hardware timestamps are only produced when the network interface
+-- has been configured for them (SIOCSHWTSTAMP), otherwise the hardware fields are left at 0. Platforms
+-- without SO_TIMESTAMPING fail with ERR_ILLEGALOP.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t enableTimestamping(struct socketStruct *socketPointer, int32_t timestampFlags)
+{
+  if (socketPointer == 0)
+  {
+    logger("ERROR > invalid socket passed to enableTimestamping", -1);
+    return 0;
+  }
+
+#ifdef SO_TIMESTAMPING
+  uint32_t options = 0;
+
+  if (timestampFlags & TIMESTAMP_SOFTWARE)
+  {
+    options |= SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+    if (timestampFlags & TIMESTAMP_TX)
+    {
+      options |= SOF_TIMESTAMPING_TX_SOFTWARE;
+    }
+  }
+  if (timestampFlags & TIMESTAMP_HARDWARE)
+  {
+    options |= SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+    if (timestampFlags & TIMESTAMP_TX)
+    {
+      options |= SOF_TIMESTAMPING_TX_HARDWARE;
+    }
+  }
+  if (timestampFlags & TIMESTAMP_TX)
+  {
+    options |= SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+  }
+
+  if (setsockopt(socketPointer->socketDescriptor, SOL_SOCKET, SO_TIMESTAMPING, &options, sizeof(options)) == -1)
+  {
+    switch (errno)
+    {
+    case EBADF:
+      lastSocketError = ERR_BADSOCK;
+      break;
+    case ENOTSOCK:
+      lastSocketError = ERR_BADSOCK;
+      break;
+    case EINVAL:
+      lastSocketError = ERR_ILLEGALOP;
+      break;
+    case EPERM:
+      lastSocketError = ERR_PERMISSION;
+      break;
+    default:
+      lastSocketError = ERR_UNKNOWN;
+      break;
+    }
+    logger("ERROR > unable to enable timestamping on socket", lastSocketError);
+    return 0;
+  }
+  //logger("SUCCESS > enabled timestamping on socket", socketPointer->socketDescriptor);
+  return 1;
+#else
+  (void)timestampFlags;
+  lastSocketError = ERR_ILLEGALOP;
+  logger("ERROR > timestamping is not supported on this platform", lastSocketError);
+  return 0;
+#endif
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: recvDataTimestamp
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int recvDataTimestamp(struct socketStruct* socketPointer, struct destination * dest,
+--                                  struct packetTimestamp * timestamp, char * dataBuffer, size_t dataBufferSize)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct whose
+--                                                     socket should be read from
+--                struct destination dest: A destination struct to fill with the address and port data was
+--                                         recieved from
+--                struct packetTimestamp * timestamp: A struct to fill with the kernel receive timestamps
+--                char * dataBuffer: An array for received data to be placed into
+--                size_t dataBufferSize: The size of dataBuffer
+--
+-- RETURNS: On success the number of bytes read into dataBuffer is returned. 
+--          On error -1 is returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function behaves like recvData and additionally returns the time the datagram was received by the
+-- network stack (software) and network card (hardware) in nanoseconds since the epoch. Timestamps that were
+-- not provided by the kernel are set to 0. Timestamping must be enabled with enableTimestamping.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t recvDataTimestamp(struct socketStruct *socketPointer, struct destination *dest, struct packetTimestamp *timestamp, char *dataBuffer, size_t dataBufferSize)
+{
+  struct captureLog *capture;
+  struct sockaddr_in destSockAddr;
+  struct msghdr message;
+  struct iovec dataVector;
+  char control[256] __attribute__((aligned(8)));
+  int bytesReceived;
+
+  if (socketPointer == 0)
+  {
+    logger("ERROR > invalid socket passed to recvDataTimestamp", -1);
+    return -1;
+  }
+  if (dest == 0 || timestamp == 0 || dataBuffer == 0)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid data, destination or timestamp passed to recvDataTimestamp", lastSocketError);
+    return -1;
+  }
+
+  dataVector.iov_base = dataBuffer;
+  dataVector.iov_len = dataBufferSize;
+
+  do
+  {
+    memset(&message, 0, sizeof(message));
+    message.msg_name = &destSockAddr;
+    message.msg_namelen = sizeof(destSockAddr);
+    message.msg_iov = &dataVector;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+  } while ((bytesReceived = recvmsg(socketPointer->socketDescriptor, &message, 0)) < 0 && errno == EINTR);
+
+  if (bytesReceived < 0)
+  {
+    lastSocketError = receiveErrorCode(errno);
+    logger("ERROR > failed to receive UDP data", lastSocketError);
+    return -1;
+  }
+
+  dest->address = destSockAddr.sin_addr.s_addr;
+  dest->port = destSockAddr.sin_port;
+  readPacketTimestamp(&message, timestamp);
+
+  if ((capture = getSocketHook(socketPointer->socketDescriptor, HOOK_CAPTURE)) != 0)
+  {
+    hookFunctions.capturePacket(capture, socketPointer->socketDescriptor, CAPTURE_RECV, dest, dataBuffer, bytesReceived);
+  }
+  //logger("SUCCESS > received UDP data", socketPointer->socketDescriptor);
+  return bytesReceived;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: recvDataBatch
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS: October 18, 2026
+--              -Moved the body into receiveBatch so the tick loop can drain without blocking
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int recvDataBatch(struct socketStruct* socketPointer, struct receivedPacket * packets,
+--                              int32_t packetCount)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct whose
+--                                                     socket should be read from
+--                struct receivedPacket * packets: An array of packets whose dataBuffer and dataBufferSize
+--                                                 have been set by the caller
+--                int32_t packetCount: The number of entries in packets
+--
+-- RETURNS: On success the number of packets received is returned. 
+--          On error -1 is returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used to receive several datagrams from a bound UDP port with as few system calls as
+-- possible. It blocks (subject to any receive timeout) until at least one datagram is available and then
+-- returns every datagram already queued, up to packetCount. For each packet the source, timestamp and
+-- dataLength fields are filled in. Timestamps are 0 unless enabled with enableTimestamping.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t recvDataBatch(struct socketStruct *socketPointer, struct receivedPacket *packets, int32_t packetCount)
+{
+  return receiveBatch(socketPointer, packets, packetCount, 1);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: receiveBatch
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS: October 18, 2026
+--              -The recvmsg fallback no longer writes a length into the packet after the last one received
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int receiveBatch(struct socketStruct* socketPointer, struct receivedPacket * packets,
+--                             int32_t packetCount, int32_t waitForFirst)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct whose
+--                                                     socket should be read from
+--                struct receivedPacket * packets: An array of packets whose dataBuffer and dataBufferSize
+--                                                 have been set by the caller
+--                int32_t packetCount: The number of entries in packets
+--                int32_t waitForFirst: 1 to block for the first datagram as recvDataBatch does, 0 to only
+--                                      take datagrams that are already queued
+--
+-- RETURNS: The number of packets received. If waitForFirst is 0 and nothing is queued, 0 is returned and
+--          lastSocketError is set to ERR_TIMEOUT. On error -1 is returned and lastSocketError is set
+--          appropriately.
+--
+-- NOTES:
+-- The body of recvDataBatch, shared with the tick loop. Poll can report a datagram the kernel then drops,
+-- such as one with a bad checksum, so a loop that must not block past its deadline drains with
+-- waitForFirst set to 0 regardless of whether the socket itself is blocking.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t receiveBatch(struct socketStruct *socketPointer, struct receivedPacket *packets, int32_t packetCount, int32_t waitForFirst)
+{
+  struct captureLog *capture;
+  struct sockaddr_in sourceAddresses[RECV_BATCH_MAX];
+  struct iovec dataVectors[RECV_BATCH_MAX];
+  char control[RECV_BATCH_MAX][256] __attribute__((aligned(8)));
+  int32_t received = 0;
+  int32_t chunkSize;
+  int32_t chunkReceived;
+  int32_t i;
+#ifdef __linux__
+  struct mmsghdr messages[RECV_BATCH_MAX];
+#else
+  struct msghdr message;
+  ssize_t messageLength;
+#endif
+
+  if (socketPointer == 0)
+  {
+    logger("ERROR > invalid socket passed to recvDataBatch", -1);
+    return -1;
+  }
+  if (packets == 0 || packetCount <= 0)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid packet array passed to recvDataBatch", lastSocketError);
+    return -1;
+  }
+
+  while (received < packetCount)
+  {
+    chunkSize = packetCount - received < RECV_BATCH_MAX ? packetCount - received : RECV_BATCH_MAX;
+
+#ifdef __linux__
+    memset(messages, 0, sizeof(struct mmsghdr) * chunkSize);
+    for (i = 0; i < chunkSize; i++)
+    {
+      dataVectors[i].iov_base = packets[received + i].dataBuffer;
+      dataVectors[i].iov_len = packets[received + i].dataBufferSize;
+      messages[i].msg_hdr.msg_name = &sourceAddresses[i];
+      messages[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+      messages[i].msg_hdr.msg_iov = &dataVectors[i];
+      messages[i].msg_hdr.msg_iovlen = 1;
+      messages[i].msg_hdr.msg_control = control[i];
+      messages[i].msg_hdr.msg_controllen = sizeof(control[i]);
+    }
+    chunkReceived = recvmmsg(socketPointer->socketDescriptor, messages, chunkSize, received == 0 && waitForFirst ? MSG_WAITFORONE : MSG_DONTWAIT, 0);
+#else
+    // recvmmsg is Linux only, so take one datagram at a time, waiting for the first only as MSG_WAITFORONE does
+    for (chunkReceived = 0; chunkReceived < chunkSize; chunkReceived++)
+    {
+      memset(&message, 0, sizeof(message));
+      dataVectors[chunkReceived].iov_base = packets[received + chunkReceived].dataBuffer;
+      dataVectors[chunkReceived].iov_len = packets[received + chunkReceived].dataBufferSize;
+      message.msg_name = &sourceAddresses[chunkReceived];
+      message.msg_namelen = sizeof(struct sockaddr_in);
+      message.msg_iov = &dataVectors[chunkReceived];
+      message.msg_iovlen = 1;
+      message.msg_control = control[chunkReceived];
+      message.msg_controllen = sizeof(control[chunkReceived]);
+      if ((messageLength = recvmsg(socketPointer->socketDescriptor, &message, received + chunkReceived == 0 && waitForFirst ? 0 : MSG_DONTWAIT)) < 0)
+      {
+        break;
+      }
+      packets[received + chunkReceived].dataLength = messageLength;
+      readPacketTimestamp(&message, &packets[received + chunkReceived].timestamp);
+    }
+    if (chunkReceived == 0)
+    {
+      chunkReceived = -1;
+    }
+#endif
+
+    if (chunkReceived < 0)
+    {
+      if (errno == EINTR && received == 0)
+      {
+        continue;
+      }
+      if (received > 0 && (errno == EWOULDBLOCK || errno == EAGAIN || errno == EINTR))
+      {
+        break;
+      }
+      if (!waitForFirst && (errno == EWOULDBLOCK || errno == EAGAIN || errno == EINTR))
+      {
+        // Nothing was queued after all, an expected result that is not logged
+        lastSocketError = ERR_TIMEOUT;
+        return 0;
+      }
+      lastSocketError = receiveErrorCode(errno);
+      logger("ERROR > failed to receive UDP data", lastSocketError);
+      return received > 0 ? received : -1;
+    }
+
+    for (i = 0; i < chunkReceived; i++)
+    {
+      packets[received + i].source.address = sourceAddresses[i].sin_addr.s_addr;
+      packets[received + i].source.port = sourceAddresses[i].sin_port;
+#ifdef __linux__
+      packets[received + i].dataLength = messages[i].msg_len;
+      readPacketTimestamp(&messages[i].msg_hdr, &packets[received + i].timestamp);
+#endif
+      if ((capture = getSocketHook(socketPointer->socketDescriptor, HOOK_CAPTURE)) != 0)
+      {
+        hookFunctions.capturePacket(capture, socketPointer->socketDescriptor, CAPTURE_RECV, &packets[received + i].source, packets[received + i].dataBuffer, packets[received + i].dataLength);
+      }
+    }
+    received += chunkReceived;
+
+    if (chunkReceived < chunkSize)
+    {
+      break;
+    }
+  }
+
+  //logger("SUCCESS > received UDP data", socketPointer->socketDescriptor);
+  return received;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: recvTxTimestamp
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int recvTxTimestamp(struct socketStruct* socketPointer, uint32_t * sendIndex,
+--                                struct packetTimestamp * timestamp)
+--                struct socketStruct * socketPointer: A pointer to the socketStruct to read the timestamp from
+--                uint32_t * sendIndex: Set to the zero based index of the datagram the timestamp belongs to,
+--                                      counting from when timestamping was enabled
+--                struct packetTimestamp * timestamp: A struct to fill with the transmit timestamps
 --
--- RETURNS: On success 1 is returned. On error 0 is returned and lastError of the socket struct is set appropriately.
+-- RETURNS: 1 if a timestamp was read. 0 if no timestamp is queued, with lastSocketError set to ERR_TIMEOUT, or
+--          on error with lastSocketError set appropriately.
 --
 -- NOTES:
--- This function is used to send data on a bound UDP port. The data will be sent to the IP address and port
--- specified in the destination struct.
+-- This function reads one transmit timestamp from the socket error queue without blocking. Timestamping must
+-- be enabled with the TIMESTAMP_TX flag. The software and hardware timestamps of a datagram can arrive as
+-- separate entries with the same sendIndex.
 ----------------------------------------------------------------------------------------------------------------------*/
-int32_t sendData(struct socketStruct *socketPointer, struct destination *dest, const char *data, uint64_t dataLength)
+int32_t recvTxTimestamp(struct socketStruct *socketPointer, uint32_t *sendIndex, struct packetTimestamp *timestamp)
 {
   if (socketPointer == 0)
   {
-    logger("ERROR > invalid socket passed to sendData", -1);
+    logger("ERROR > invalid socket passed to recvTxTimestamp", -1);
     return 0;
   }
-  if (dest == 0 || data == 0)
+  if (sendIndex == 0 || timestamp == 0)
   {
-    socketPointer->lastError = ERR_ILLEGALOP;
-    logger("ERROR > invalid data or destination address passed to sendData", socketPointer->lastError);
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid index or timestamp passed to recvTxTimestamp", lastSocketError);
     return 0;
   }
-  struct sockaddr_in destSockAddr;
-  memset((char *)&destSockAddr, 0, sizeof(destSockAddr));
-  destSockAddr.sin_family = AF_INET;
-  destSockAddr.sin_port = dest->port;
-  destSockAddr.sin_addr.s_addr = dest->address;
-  if (sendto(socketPointer->socketDescriptor, data, dataLength, 0, (struct sockaddr *)&destSockAddr, sizeof(destSockAddr)) < 0)
+
+#ifdef SO_TIMESTAMPING
+  struct msghdr message;
+  struct cmsghdr *controlMessage;
+  struct sock_extended_err *extendedError;
+  char control[256] __attribute__((aligned(8)));
+  int32_t found = 0;
+  int32_t result;
+
+  do
   {
-    switch (errno)
+    memset(&message, 0, sizeof(message));
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+  } while ((result = recvmsg(socketPointer->socketDescriptor, &message, MSG_ERRQUEUE | MSG_DONTWAIT)) < 0 && errno == EINTR);
+
+  if (result < 0)
+  {
+    lastSocketError = receiveErrorCode(errno);
+    if (lastSocketError != ERR_TIMEOUT)
     {
-    case EBADF:
-      socketPointer->lastError = ERR_BADSOCK;
-      break;
-    case ENOTSOCK:
-      socketPointer->lastError = ERR_BADSOCK;
-      break;
-    case EMSGSIZE:
-      socketPointer->lastError = ERR_ILLEGALOP;
-      break;
-    case ENOMEM:
-      socketPointer->lastError = ERR_NOMEMORY;
-      break;
-    default:
-      socketPointer->lastError = ERR_UNKNOWN;
-      break;
+      logger("ERROR > failed to read transmit timestamp", lastSocketError);
     }
-    if (errno == EWOULDBLOCK || errno == EAGAIN)
+    return 0;
+  }
+
+  readPacketTimestamp(&message, timestamp);
+  for (controlMessage = CMSG_FIRSTHDR(&message); controlMessage != 0; controlMessage = CMSG_NXTHDR(&message, controlMessage))
+  {
+    if ((controlMessage->cmsg_level == IPPROTO_IP && controlMessage->cmsg_type == IP_RECVERR) ||
+        (controlMessage->cmsg_level == IPPROTO_IPV6 && controlMessage->cmsg_type == IPV6_RECVERR))
     {
-      socketPointer->lastError = ERR_TIMEOUT;
+      extendedError = (struct sock_extended_err *)CMSG_DATA(controlMessage);
+      if (extendedError->ee_errno == ENOMSG && extendedError->ee_origin == SO_EE_ORIGIN_TIMESTAMPING)
+      {
+        *sendIndex = extendedError->ee_data;
+        found = 1;
+      }
     }
-    logger("ERROR > failed to send UDP data", socketPointer->lastError);
+  }
+
+  if (!found)
+  {
+    lastSocketError = ERR_UNKNOWN;
+    logger("ERROR > unexpected entry in socket error queue", lastSocketError);
     return 0;
   }
-  //logger("SUCCESS > sent UDP data", socketPointer->socketDescriptor);
   return 1;
+#else
+  lastSocketError = ERR_ILLEGALOP;
+  logger("ERROR > timestamping is not supported on this platform", lastSocketError);
+  return 0;
+#endif
 }
 
 /*------------------------------------------------------------------------------------------------------------------
--- FUNCTION: recvDataTCP
+-- FUNCTION: readPacketTimestamp
 --
--- DATE: April 3rd, 2019
+-- DATE: October 18th, 2026
 --
--- REVISIONS: April 3, 2019
---              -Added null check for pointers
---            March 6, 2019
---              -Change failure return to return errno instead
---            January 23, 2019
---              -Initial start
+-- REVISIONS:
 --
--- DESIGNER: Simon Wu
+-- DESIGNER: agent
 --
--- PROGRAMMER: Simon Wu, Cameron Roberts
+-- PROGRAMMER: agent
 --
--- INTERFACE: int recvDataTCP(struct socketStruct* socketPointer, char* dataBuffer, int32_t packetSize)
---                struct socketStrict * socketPointer: A pointer to the socketStruct whose
---                                                     socket should be read from
---                const char * data: A char array containing the data to be sent
---                int32_t packetSize: The number of characters to read
+-- INTERFACE: static void readPacketTimestamp(struct msghdr * message, struct packetTimestamp * timestamp)
+--                struct msghdr * message: A message returned by recvmsg or recvmmsg
+--                struct packetTimestamp * timestamp: The struct to fill in
 --
--- RETURNS: The number of characters read into dataBuffer or -1 on error.
+-- RETURNS: void.
 --
 -- NOTES:
--- This function is used to recieve data from a connected TCP socket. The function will continue
--- until packetSize characters have been read or an error occurs. If an error occurs errno will
--- be set accordingly.
+-- Extracts the SCM_TIMESTAMPING control message, converting the software and raw hardware timestamps to
+-- nanoseconds. Missing timestamps are set to 0.
 ----------------------------------------------------------------------------------------------------------------------*/
-int32_t recvDataTCP(struct socketStruct *socketPointer, char *dataBuffer, int32_t packetSize)
+static void readPacketTimestamp(struct msghdr *message, struct packetTimestamp *timestamp)
 {
-  int readCount;
-  int32_t length = packetSize;
+  timestamp->software = 0;
+  timestamp->hardware = 0;
 
-  if (socketPointer == 0)
+#ifdef SO_TIMESTAMPING
+  struct cmsghdr *controlMessage;
+  struct scm_timestamping *times;
+
+  if (message->msg_controllen == 0)
   {
-    logger("ERROR > invalid socket passed to recvDataTCP", -1);
-    return 0;
+    return;
   }
-  if (dataBuffer == 0)
+  for (controlMessage = CMSG_FIRSTHDR(message); controlMessage != 0; controlMessage = CMSG_NXTHDR(message, controlMessage))
   {
-    socketPointer->lastError = ERR_ILLEGALOP;
-    logger("ERROR > invalid data passed to recvDataTCP", socketPointer->lastError);
-    return 0;
+    if (controlMessage->cmsg_level == SOL_SOCKET && controlMessage->cmsg_type == SCM_TIMESTAMPING)
+    {
+      times = (struct scm_timestamping *)CMSG_DATA(controlMessage);
+      timestamp->software = (int64_t)times->ts[0].tv_sec * 1000000000 + times->ts[0].tv_nsec;
+      timestamp->hardware = (int64_t)times->ts[2].tv_sec * 1000000000 + times->ts[2].tv_nsec;
+    }
   }
+#else
+  (void)message;
+#endif
+}
 
-  while ((readCount = recv((socketPointer->socketDescriptor), dataBuffer, length, 0)) < length)
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: receiveErrorCode
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static int receiveErrorCode(int errorNumber)
+--                int errorNumber: The errno value reported by a failed receive
+--
+-- RETURNS: The ERR_ code corresponding to errorNumber.
+--    
+-- NOTES:
+-- Maps recv and recvfrom failures to library error codes for the UDP and TCP receive functions.
+----------------------------------------------------------------------------------------------------------------------*/
+static int32_t receiveErrorCode(int32_t errorNumber)
+{
+  if (errorNumber == EWOULDBLOCK || errorNumber == EAGAIN)
   {
-    if (readCount == 0)
+    return ERR_TIMEOUT;
+  }
+  switch (errorNumber)
+  {
+  case EBADF:
+    return ERR_BADSOCK;
+  case ENOTSOCK:
+    return ERR_BADSOCK;
+  case ENOTCONN:
+    return ERR_ILLEGALOP;
+  case ENOMEM:
+    return ERR_NOMEMORY;
+  case ECONNREFUSED:
+    return ERR_CONREFUSED;
+  case ECONNRESET:
+    return ERR_CONRESET;
+  default:
+    return ERR_UNKNOWN;
+  }
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: sendErrorCode
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static int sendErrorCode(int errorNumber)
+--                int errorNumber: The errno value reported by a failed UDP send
+--
+-- RETURNS: The ERR_ code corresponding to errorNumber.
+--    
+-- NOTES:
+-- Maps UDP send failures to library error codes. A send timeout maps to ERR_TIMEOUT.
+----------------------------------------------------------------------------------------------------------------------*/
+static int32_t sendErrorCode(int32_t errorNumber)
+{
+  if (errorNumber == EWOULDBLOCK || errorNumber == EAGAIN)
+  {
+    return ERR_TIMEOUT;
+  }
+  switch (errorNumber)
+  {
+  case EBADF:
+    return ERR_BADSOCK;
+  case ENOTSOCK:
+    return ERR_BADSOCK;
+  case EMSGSIZE:
+    return ERR_ILLEGALOP;
+  case ENOMEM:
+    return ERR_NOMEMORY;
+  default:
+    return ERR_UNKNOWN;
+  }
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: streamSendErrorCode
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static int streamSendErrorCode(int errorNumber)
+--                int errorNumber: The errno value reported by a failed TCP send
+--
+-- RETURNS: The ERR_ code corresponding to errorNumber.
+--
+-- NOTES:
+-- Maps TCP send failures to library error codes, shared by sendDataTCP and sendDataTCPTimeout. A closed
+-- connection maps to ERR_CONRESET and a send timeout to ERR_TIMEOUT.
+----------------------------------------------------------------------------------------------------------------------*/
+static int32_t streamSendErrorCode(int32_t errorNumber)
+{
+  if (errorNumber == EWOULDBLOCK || errorNumber == EAGAIN)
+  {
+    return ERR_TIMEOUT;
+  }
+  switch (errorNumber)
+  {
+  case EBADF:
+    return ERR_BADSOCK;
+  case ENOTSOCK:
+    return ERR_BADSOCK;
+  case ENOTCONN:
+    return ERR_ILLEGALOP;
+  case EPIPE:
+    return ERR_CONRESET;
+  case ECONNRESET:
+    return ERR_CONRESET;
+  case ENOMEM:
+    return ERR_NOMEMORY;
+  default:
+    return ERR_UNKNOWN;
+  }
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: waitForSocket
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static int waitForSocket(int32_t socketDescriptor, int16_t events, int64_t deadline)
+--                int32_t socketDescriptor: The socket to wait on
+--                int16_t events: The poll events to wait for
+--                int64_t deadline: The monotonic time in microseconds to give up at, or -1 to wait indefinitely
+--
+-- RETURNS: 1 if the socket is ready, 0 if the deadline passed, or -1 on error with errno set.
+--    
+-- NOTES:
+-- Waits for readiness with ppoll so deadlines keep microsecond resolution. Platforms without ppoll fall
+-- back to poll with millisecond resolution. Interrupted waits are resumed
+-- with the remaining time. Error and hang up conditions are reported as ready so the following call on the
+-- socket reports the actual error.
+----------------------------------------------------------------------------------------------------------------------*/
+static int32_t waitForSocket(int32_t socketDescriptor, int16_t events, int64_t deadline)
+{
+  struct pollfd pollDescriptor;
+  struct timespec remaining;
+  int64_t remainingMicroseconds;
+  int result;
+
+  pollDescriptor.fd = socketDescriptor;
+  pollDescriptor.events = events;
+
+  for (;;)
+  {
+    pollDescriptor.revents = 0;
+    if (deadline < 0)
     {
-      // Other side disconnected
-      return readCount;
+      result = poll(&pollDescriptor, 1, -1);
     }
-    if (readCount == -1)
+    else
     {
-      switch (errno)
-      {
-      case EBADF:
-        socketPointer->lastError = ERR_BADSOCK;
-        break;
-      case ENOTSOCK:
-        socketPointer->lastError = ERR_BADSOCK;
-        break;
-      case ENOTCONN:
-        socketPointer->lastError = ERR_ILLEGALOP;
-        break;
-      case ENOMEM:
-        socketPointer->lastError = ERR_NOMEMORY;
-        break;
-      case ECONNREFUSED:
-        socketPointer->lastError = ERR_CONREFUSED;
-        break;
-      default:
-        socketPointer->lastError = ERR_UNKNOWN;
-        break;
-      }
-      if (errno == EWOULDBLOCK || errno == EAGAIN)
+      remainingMicroseconds = deadline - monotonicMicroseconds();
+      if (remainingMicroseconds < 0)
       {
-        socketPointer->lastError = ERR_TIMEOUT;
+        remainingMicroseconds = 0;
       }
-      logger("ERROR > failed to receive TCP data", socketPointer->lastError);
+#ifdef __linux__
+      remaining.tv_sec = remainingMicroseconds / 1000000;
+      remaining.tv_nsec = (remainingMicroseconds % 1000000) * 1000;
+      result = ppoll(&pollDescriptor, 1, &remaining, 0);
+#else
+      // ppoll is not available, round up to whole milliseconds
+      (void)remaining;
+      result = poll(&pollDescriptor, 1, (int)((remainingMicroseconds + 999) / 1000));
+#endif
+    }
+
+    if (result == -1 && errno == EINTR)
+    {
+      continue;
+    }
+    if (result <= 0)
+    {
+      return result;
+    }
+    if (pollDescriptor.revents & POLLNVAL)
+    {
+      errno = EBADF;
       return -1;
     }
-    dataBuffer += readCount;
-    length -= readCount;
+    return 1;
   }
-  //logger("SUCCESS > received TCP data", socketPointer->socketDescriptor);
-  return packetSize - length;
 }
 
 /*------------------------------------------------------------------------------------------------------------------
--- FUNCTION: recvData
+-- FUNCTION: waitIfNonBlocking
 --
--- DATE: April 3rd, 2019
+-- DATE: October 18th, 2026
 --
--- REVISIONS: April 3, 2019
---              -Added null checks for pointers
---            January 23, 2019
---              -Initial start
+-- REVISIONS:
 --
--- DESIGNER: Cameron Roberts, Simon Wu
+-- DESIGNER: agent
 --
--- PROGRAMMER: Cameron Roberts, Simon Wu
+-- PROGRAMMER: agent
 --
--- INTERFACE: int recvData(struct socketStruct* socketPointer, char * dataBuffer, size_t dataBufferLength)
---                struct socketStrict * socketPointer: A pointer to the socketStruct whose
---                                                     socket should be read from
---                struct destination dest: A destination struct to fill with the address and port data was
---                                         recieved from
---                const char * dataBuffer: An array for received data to be placed into
---                size_t dataBufferSize: The size of dataBuffer
+-- INTERFACE: static int waitIfNonBlocking(int32_t socketDescriptor, int16_t events)
+--                int32_t socketDescriptor: The socket that returned EAGAIN
+--                int16_t events: The poll events to wait for
 --
--- RETURNS: On success the number of bytes read into dataBuffer is returned. 
---          On error -1 is returned and lastError of the socket struct is set appropriately.
+-- RETURNS: 1 if the socket is non-blocking and is now ready, 0 if the socket is blocking, or -1 on error
+--          with errno set.
 --
 -- NOTES:
--- This function is used to receive data from a bound UDP port.
+-- Called once a call fails with EAGAIN to tell a socket without data or room apart from an expired
+-- SO_RCVTIMEO or SO_SNDTIMEO. A blocking socket keeps its errno so the caller reports ERR_TIMEOUT.
+-- The flags are only read on this slow path so the common case costs no extra system call.
 ----------------------------------------------------------------------------------------------------------------------*/
-int32_t recvData(struct socketStruct *socketPointer, struct destination *dest, char *dataBuffer, size_t dataBufferSize)
+static int32_t waitIfNonBlocking(int32_t socketDescriptor, int16_t events)
 {
-  struct sockaddr_in destSockAddr;
-  socklen_t destSockAddrSize = sizeof(destSockAddr);
-  int bytesReceived;
+  int32_t fileFlags = fcntl(socketDescriptor, F_GETFL);
 
-  if (socketPointer == 0)
+  if (fileFlags == -1)
   {
-    logger("ERROR > invalid socket passed to recvData", -1);
     return -1;
   }
-  if (dest == 0 || dataBuffer == 0)
+  if (!(fileFlags & O_NONBLOCK))
   {
-    socketPointer->lastError = ERR_ILLEGALOP;
-    logger("ERROR > invalid data or destination structure passed to recvData", socketPointer->lastError);
-    return -1;
+    errno = EAGAIN;
+    return 0;
+  }
+  return waitForSocket(socketDescriptor, events, -1);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: exchangeSocketHook
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int exchangeSocketHook(int32_t socketDescriptor, int32_t hook, void * value, void ** previous)
+--                int32_t socketDescriptor: The descriptor the hook belongs to
+--                int32_t hook: HOOK_CAPTURE or HOOK_NETEM
+--                void * value: The new hook, or null to remove it
+--                void ** previous: Set to the hook that was replaced, may be null
+--
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- Capture logs and network emulators are kept in a table indexed by descriptor rather than in the
+-- socketStruct, so a socketStruct filled in by hand around a descriptor from acceptClient never carries
+-- stale hooks. The table is split into pages that are allocated on first use and kept for the life of the
+-- process, which lets getSocketHook read it without a lock. Writers are serialized by hookLock, and
+-- hooksAttached lets sockets without hooks skip the table altogether.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t exchangeSocketHook(int32_t socketDescriptor, int32_t hook, void *value, void **previous)
+{
+  void **page;
+  void *replaced;
+
+  if (socketDescriptor < 0 || socketDescriptor >= HOOK_PAGES * HOOK_PAGE_SIZE || hook < 0 || hook >= HOOK_COUNT)
+  {
+    lastSocketError = ERR_BADSOCK;
+    return 0;
   }
 
-  int retry = 1;
-  while(retry){
-    if ((bytesReceived = recvfrom(socketPointer->socketDescriptor, dataBuffer, dataBufferSize, 0, (struct sockaddr *)&destSockAddr, &destSockAddrSize)) < 0)
+  pthread_mutex_lock(&hookLock);
+  if ((page = hookPages[socketDescriptor / HOOK_PAGE_SIZE]) == 0 && value != 0)
+  {
+    if ((page = calloc(HOOK_PAGE_SIZE * HOOK_COUNT, sizeof(void *))) == 0)
     {
-      if(errno == EINTR){
-        continue;
-      }
-      retry = 0;
-
-      switch (errno)
-      {
-      case EBADF:
-        socketPointer->lastError = ERR_BADSOCK;
-        break;
-      case ENOTSOCK:
-        socketPointer->lastError = ERR_BADSOCK;
-        break;
-      case ENOMEM:
-        socketPointer->lastError = ERR_NOMEMORY;
-        break;
-      case ECONNREFUSED:
-        socketPointer->lastError = ERR_CONREFUSED;
-        break;
-      default:
-        socketPointer->lastError = ERR_UNKNOWN;
-        break;
-      }
-      if (errno == EWOULDBLOCK || errno == EAGAIN)
-      {
-        socketPointer->lastError = ERR_TIMEOUT;
-      }
-      logger("ERROR > failed to receive UDP data", socketPointer->lastError);
-      return -1;
+      pthread_mutex_unlock(&hookLock);
+      lastSocketError = ERR_NOMEMORY;
+      return 0;
     }
-    retry = 0;
+    __atomic_store_n(&hookPages[socketDescriptor / HOOK_PAGE_SIZE], page, __ATOMIC_RELEASE);
   }
+  replaced = page == 0 ? 0 : __atomic_exchange_n(&page[(socketDescriptor % HOOK_PAGE_SIZE) * HOOK_COUNT + hook], value, __ATOMIC_ACQ_REL);
+  if (replaced == 0 && value != 0)
+  {
+    __atomic_add_fetch(&hooksAttached, 1, __ATOMIC_RELEASE);
+  }
+  else if (replaced != 0 && value == 0)
+  {
+    __atomic_sub_fetch(&hooksAttached, 1, __ATOMIC_RELEASE);
+  }
+  pthread_mutex_unlock(&hookLock);
 
-  dest->address = destSockAddr.sin_addr.s_addr;
-  dest->port = destSockAddr.sin_port;
-
-  //logger("SUCCESS > received UDP data", socketPointer->socketDescriptor);
-  return bytesReceived;
+  if (previous != 0)
+  {
+    *previous = replaced;
+  }
+  return 1;
 }
 
 /*------------------------------------------------------------------------------------------------------------------
@@ -744,24 +3194,29 @@ int32_t recvData(struct socketStruct *socketPointer, struct destination *dest, c
 --
 -- DATE: April 4th, 2019
 --
--- REVISIONS: April 4, 2019
+-- REVISIONS: October 18, 2026
+--              -Detaches through hookFunctions, only when capture.c and netem.c are linked in
+--              -Detaches network emulators and capture logs
+--            April 4, 2019
 --              -Added check for null pointer
 --            January 23, 2019
 --              -Initial start
 --
 -- DESIGNER: Cameron Roberts, Simon Wu
 --
--- PROGRAMMER: Cameron Roberts, Simon Wu
+-- PROGRAMMER: Cameron Roberts, Simon Wu, agent
 --
 -- INTERFACE: int closeSocket(struct socketStruct * socketPointer)
---                struct socketStrict * socketPointer: A pointer to the socketStruct whose
+--                struct socketStruct * socketPointer: A pointer to the socketStruct whose
 --                                                     socket should be closed
 --
 -- RETURNS: On success 1 is returned. 
---          On error 0 is returned and lastError of the socket struct is set appropriately.
+--          On error 0 is returned and lastSocketError is set appropriately.
 --
 -- NOTES:
--- This function is used to close a socket contained within a socketStruct.
+-- This function is used to close a socket contained within a socketStruct. A network emulator or capture
+-- log attached to the socket is detached first, so nothing sends on the descriptor once it is reused and
+-- the log can be closed afterwards.
 ----------------------------------------------------------------------------------------------------------------------*/
 int32_t closeSocket(struct socketStruct *socketPointer)
 {
@@ -770,21 +3225,29 @@ int32_t closeSocket(struct socketStruct *socketPointer)
     logger("ERROR: socket does not exist", -1);
     return 0;
   }
+  if (hookFunctions.detachNetem != 0)
+  {
+    hookFunctions.detachNetem(socketPointer);
+  }
+  if (hookFunctions.detachCapture != 0)
+  {
+    hookFunctions.detachCapture(socketPointer);
+  }
   if (close(socketPointer->socketDescriptor) == -1)
   {
     switch (errno)
     {
     case EBADF:
-      socketPointer->lastError = ERR_BADSOCK;
+      lastSocketError = ERR_BADSOCK;
       break;
     case EIO:
-      socketPointer->lastError = ERR_UNKNOWN;
+      lastSocketError = ERR_UNKNOWN;
       break;
     default:
-      socketPointer->lastError = ERR_UNKNOWN;
+      lastSocketError = ERR_UNKNOWN;
       break;
     }
-    logger("ERROR > failed to close socket", socketPointer->lastError);
+    logger("ERROR > failed to close socket", lastSocketError);
     return 0;
   }
   //logger("SUCCESS > socket closed", socketPointer->socketDescriptor);
@@ -803,13 +3266,14 @@ int32_t closeSocket(struct socketStruct *socketPointer)
 -- PROGRAMMER: Cameron Roberts
 --
 -- INTERFACE: void freeSocket(struct socketStruct * socketPointer)
---                struct socketStrict * socketPointer: A pointer to the socketStruct whose
+--                struct socketStruct * socketPointer: A pointer to the socketStruct whose
 --                                                     memory should be freed
 --
 -- RETURNS: void.
 --
 -- NOTES:
--- This function is used to free the memory allocated to a socketStruct.
+-- This function is used to free the memory allocated to a socketStruct. Capture logs and network emulators
+-- belong to the descriptor rather than the socketStruct, so they stay attached until closeSocket.
 ----------------------------------------------------------------------------------------------------------------------*/
 void freeSocket(struct socketStruct *socketPointer)
 {
@@ -821,22 +3285,28 @@ void freeSocket(struct socketStruct *socketPointer)
 --
 -- DATE: January 23rd, 2019
 --
--- REVISIONS: 
+-- REVISIONS: October 18, 2026
+--              -Returns the error of the calling thread rather than a field of the socketStruct
+--            January 23, 2019
+--              -Initial start
 --
 -- DESIGNER: Cameron Roberts
 --
--- PROGRAMMER: Cameron Roberts
+-- PROGRAMMER: Cameron Roberts, agent
 -- 
--- INTERFACE: int getSocketError()
+-- INTERFACE: int getSocketError(struct socketStruct* socketPointer)
+--                struct socketStruct * socketPointer: Unused, kept for compatibility
 --
--- RETURNS: The lastError value of the socketPointer
+-- RETURNS: The lastSocketError value of the calling thread
 --
 -- NOTES:
--- This function is used to retrieve errno
+-- This function is used to retrieve the ERR_ code of the most recent failed call made by the calling
+-- thread. Errors raised on other threads, even on the same socket, are not visible.
 ----------------------------------------------------------------------------------------------------------------------*/
 int32_t getSocketError(struct socketStruct *socketPointer)
 {
-  return socketPointer->lastError;
+  (void)socketPointer;
+  return lastSocketError;
 }
 
 /*------------------------------------------------------------------------------------------------------------------
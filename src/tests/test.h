@@ -0,0 +1,60 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include "../include/socket.h"
+
+// Unused by the benchmarks, which share the socket helpers below
+static int32_t testFailures __attribute__((unused));
+
+static inline void check(int32_t condition, const char *description)
+{
+  if (!condition)
+  {
+    testFailures++;
+    printf("  FAIL  %s (lastSocketError %d)\n", description, lastSocketError);
+  }
+}
+
+static inline int32_t enterTestDirectory(const char *name)
+{
+  char directory[] = "/tmp/libsocket-test-XXXXXX";
+
+  // logger writes log.txt in the working directory
+  if (mkdtemp(directory) == 0 || chdir(directory) == -1)
+  {
+    perror(name);
+    return 0;
+  }
+  return 1;
+}
+
+static inline int32_t finishTest(const char *name)
+{
+  printf("%s: %s\n", name, testFailures == 0 ? "PASS" : "FAIL");
+  return testFailures == 0 ? 0 : 1;
+}
+
+static inline struct socketStruct *openUDP(struct destination *bound)
+{
+  struct socketStruct *socketPointer = createSocket();
+  struct sockaddr_in address;
+  socklen_t addressLength = sizeof(address);
+
+  if (!initSocket(socketPointer) || !bindPort(socketPointer, 0) ||
+      getsockname(socketPointer->socketDescriptor, (struct sockaddr *)&address, &addressLength) == -1)
+  {
+    freeSocket(socketPointer);
+    return 0;
+  }
+  bound->address = htonl(INADDR_LOOPBACK);
+  bound->port = address.sin_port;
+  return socketPointer;
+}
+
+static inline void releaseSocket(struct socketStruct *socketPointer)
+{
+  closeSocket(socketPointer);
+  freeSocket(socketPointer);
+}
+
+#endif
@@ -0,0 +1,173 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: test_async.cpp - Loopback test of the C++20 coroutine layer in asyncsocket.hpp.
+--
+--
+-- PROGRAM: test_async
+--
+-- FUNCTIONS:
+-- int main()
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- NOTES:
+-- Built with -std=c++20 and run with "make test". A client and a server coroutine share one Reactor on
+-- loopback and check that:
+--     - asyncConnect and asyncAccept set up a connection, with the client address as the peer
+--     - a buffer far larger than the socket buffers goes through asyncSendTCP and asyncRecvTCP intact in
+--       both directions, so both sides suspend and resume part way
+--     - asyncSend and asyncRecv pass a datagram between two UDP sockets
+--     - asyncConnect to a port nobody listens on fails with ERR_CONREFUSED, mapped by connectErrorCode
+--     - awaiting a Task that was moved from throws std::logic_error
+----------------------------------------------------------------------------------------------------------------------*/
+
+#include <stdexcept>
+#include <vector>
+
+#include "../include/asyncsocket.hpp"
+#include "test.h"
+
+#define TEST_STREAM_SIZE    (8 * 1024 * 1024)
+
+using namespace libsocket;
+
+static uint16_t boundPort(Socket &socket)
+{
+  struct sockaddr_in address;
+  socklen_t addressLength = sizeof(address);
+
+  if (getsockname(socket.descriptor(), (struct sockaddr *)&address, &addressLength) == -1)
+  {
+    return 0;
+  }
+  return address.sin_port;
+}
+
+static void fillPattern(std::vector<char> &buffer, uint32_t seed)
+{
+  for (size_t i = 0; i < buffer.size(); i++)
+  {
+    buffer[i] = (char)((i * 31 + seed) >> 3);
+  }
+}
+
+static Task<void> serveEcho(Reactor &reactor, Socket &listener, int32_t &echoed)
+{
+  std::vector<char> buffer(TEST_STREAM_SIZE);
+  Socket client = co_await asyncAccept(reactor, listener);
+
+  check(client.valid(), "asyncAccept returns the connecting client");
+  check(client.peer().address == htonl(INADDR_LOOPBACK), "the accepted client has its peer address");
+  if (co_await asyncRecvTCP(reactor, client, buffer.data(), TEST_STREAM_SIZE) != TEST_STREAM_SIZE)
+  {
+    check(0, "the server receives the whole stream");
+    co_return;
+  }
+  echoed = co_await asyncSendTCP(reactor, client, buffer.data(), buffer.size());
+}
+
+static Task<void> runClient(Reactor &reactor, destination server, int32_t &matched)
+{
+  std::vector<char> sent(TEST_STREAM_SIZE);
+  std::vector<char> received(TEST_STREAM_SIZE);
+  Socket client = Socket::tcp();
+
+  fillPattern(sent, 7);
+  check(client.valid(), "create a non-blocking TCP socket");
+  check(co_await asyncConnect(reactor, client, server) == 1, "asyncConnect reaches the listener");
+  check(co_await asyncSendTCP(reactor, client, sent.data(), sent.size()) == 1, "asyncSendTCP sends the whole stream");
+  check(co_await asyncRecvTCP(reactor, client, received.data(), TEST_STREAM_SIZE) == TEST_STREAM_SIZE,
+        "asyncRecvTCP reads the whole echo");
+  matched = sent == received;
+}
+
+static Task<void> exchangeDatagram(Reactor &reactor, int32_t &matched)
+{
+  Socket first = Socket::udp(0);
+  Socket second = Socket::udp(0);
+  destination target = {htonl(INADDR_LOOPBACK), boundPort(second)};
+  destination source;
+  char dataBuffer[64] = {0};
+
+  check(first.valid() && second.valid(), "create two non-blocking UDP sockets");
+  // Start receiving first so the coroutine suspends before anything is sent
+  Task<int32_t> receive = asyncRecv(reactor, second, source, dataBuffer, sizeof(dataBuffer) - 1);
+  check(co_await asyncSend(reactor, first, target, "datagram", 8) == 1, "asyncSend sends a datagram");
+  check(co_await std::move(receive) == 8, "asyncRecv receives it");
+  matched = strcmp(dataBuffer, "datagram") == 0 && source.port == boundPort(first);
+}
+
+static Task<void> connectRefused(Reactor &reactor, int32_t &refused)
+{
+  Socket unused = Socket::tcp();
+  Socket client = Socket::tcp();
+  destination target = {htonl(INADDR_LOOPBACK), 0};
+
+  // Bind without listening to hold a port that refuses connections
+  if (!bindPort(unused.get(), 0) || (target.port = boundPort(unused)) == 0)
+  {
+    check(0, "reserve a port for the refused connect");
+    co_return;
+  }
+  refused = co_await asyncConnect(reactor, client, target) == 0 && lastSocketError == ERR_CONREFUSED;
+}
+
+static Task<void> awaitMovedTask(Reactor &reactor, int32_t &threw)
+{
+  Socket socket = Socket::udp(0);
+  destination source;
+  char dataBuffer[16];
+  Task<int32_t> receive = asyncRecv(reactor, socket, source, dataBuffer, sizeof(dataBuffer));
+  Task<int32_t> taken = std::move(receive);
+
+  try
+  {
+    co_await std::move(receive);
+  }
+  catch (const std::logic_error &)
+  {
+    threw = 1;
+  }
+}
+
+int main()
+{
+  Reactor reactor;
+  Socket listener;
+  destination server;
+  int32_t echoed = 0;
+  int32_t streamMatched = 0;
+  int32_t datagramMatched = 0;
+  int32_t refused = 0;
+  int32_t threw = 0;
+
+  if (!enterTestDirectory("test_async"))
+  {
+    return 1;
+  }
+
+  check(reactor.valid(), "create a reactor");
+  listener = Socket::listener(0);
+  check(listener.valid(), "listen on an ephemeral port");
+  server.address = htonl(INADDR_LOOPBACK);
+  server.port = boundPort(listener);
+
+  spawn(serveEcho(reactor, listener, echoed));
+  spawn(runClient(reactor, server, streamMatched));
+  spawn(exchangeDatagram(reactor, datagramMatched));
+  spawn(connectRefused(reactor, refused));
+  spawn(awaitMovedTask(reactor, threw));
+  reactor.run();
+
+  check(echoed == 1, "the server echoes the whole stream");
+  check(streamMatched, "the echoed stream matches what was sent");
+  check(datagramMatched, "the datagram arrives intact from the sending socket");
+  check(refused, "a refused connect reports ERR_CONREFUSED");
+  check(threw, "awaiting a moved-from Task throws std::logic_error");
+  return finishTest("test_async");
+}
@@ -0,0 +1,117 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: test_multicast.c - Loopback test of joining, sending to and leaving multicast groups.
+--
+--
+-- PROGRAM: test_multicast
+--
+-- FUNCTIONS:
+-- int main()
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- NOTES:
+-- Built and run with "make test". Everything goes over the loopback interface, so no multicast routing
+-- is needed. Two members share a port, each in its own group, and a sender on the same host checks that:
+--     - with IP_MULTICAST_LOOP on, a datagram sent with sendDataGroup reaches the member of its group only
+--     - one sendDataGroup call to both groups reaches both members
+--     - setMulticastLoopback(0) clears IP_MULTICAST_LOOP. Loopback itself hands every datagram it sends back
+--       to the host, so members still receive; that part can only be seen on a real interface
+--     - after leaveMulticastGroup, the member that left sees nothing
+-- If the host refuses to join a group on loopback the test is skipped rather than failed.
+----------------------------------------------------------------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include "test.h"
+
+#define TEST_PORT           47200
+#define TEST_WAIT           200000
+
+static struct socketStruct *openMember(uint32_t groupAddress)
+{
+  struct socketStruct *member = createSocket();
+  struct socketTuning tuning;
+
+  memset(&tuning, 0, sizeof(tuning));
+  tuning.reuseAddress = 1;
+  if (!initSocketTuned(member, &tuning) || !bindPort(member, htons(TEST_PORT)) ||
+      !joinMulticastGroup(member, groupAddress, htonl(INADDR_LOOPBACK)))
+  {
+    releaseSocket(member);
+    return 0;
+  }
+  return member;
+}
+
+static int32_t receiveFrom(struct socketStruct *member, const char *expected)
+{
+  struct destination source;
+  char dataBuffer[64];
+  int32_t length = recvDataTimeout(member, &source, dataBuffer, sizeof(dataBuffer) - 1, TEST_WAIT);
+
+  if (length <= 0)
+  {
+    return 0;
+  }
+  dataBuffer[length] = 0;
+  return strcmp(dataBuffer, expected) == 0;
+}
+
+int main()
+{
+  struct socketStruct *first;
+  struct socketStruct *second;
+  struct socketStruct *sender = createSocket();
+  struct destination groups[2];
+  uint8_t loop = 1;
+  socklen_t loopLength = sizeof(loop);
+
+  if (!enterTestDirectory("test_multicast"))
+  {
+    return 1;
+  }
+
+  groups[0].address = inet_addr("239.255.42.1");
+  groups[0].port = htons(TEST_PORT);
+  groups[1].address = inet_addr("239.255.42.2");
+  groups[1].port = htons(TEST_PORT);
+  if ((first = openMember(groups[0].address)) == 0 || (second = openMember(groups[1].address)) == 0)
+  {
+    printf("test_multicast: SKIP, unable to join a group on loopback (lastSocketError %d)\n", lastSocketError);
+    return 0;
+  }
+
+  check(initSocket(sender), "create the sender");
+  check(setMulticastInterface(sender, htonl(INADDR_LOOPBACK)), "send groups out of loopback");
+  check(setMulticastTTL(sender, 1), "keep groups on this network");
+  check(setMulticastLoopback(sender, 1), "deliver groups to members on this host");
+
+  check(sendDataGroup(sender, &groups[0], 1, "first", 5) == 1, "send to the first group");
+  check(receiveFrom(first, "first"), "member of the first group receives it");
+  check(!receiveFrom(second, "first"), "member of another group on the same port does not");
+
+  check(sendDataGroup(sender, groups, 2, "both", 4) == 2, "send one datagram to both groups");
+  check(receiveFrom(first, "both"), "first member receives the datagram for both groups");
+  check(receiveFrom(second, "both"), "second member receives the datagram for both groups");
+
+  check(setMulticastLoopback(sender, 0), "turn loopback off");
+  check(getsockopt(sender->socketDescriptor, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, &loopLength) == 0 && loop == 0,
+        "IP_MULTICAST_LOOP is cleared");
+
+  check(setMulticastLoopback(sender, 1), "turn loopback back on");
+  check(leaveMulticastGroup(second, groups[1].address, htonl(INADDR_LOOPBACK)), "leave the second group");
+  check(sendDataGroup(sender, groups, 2, "after", 5) == 2, "send to both groups after leaving");
+  check(receiveFrom(first, "after"), "the remaining member still receives");
+  check(!receiveFrom(second, "after"), "the member that left does not");
+
+  releaseSocket(sender);
+  releaseSocket(first);
+  releaseSocket(second);
+  return finishTest("test_multicast");
+}
@@ -0,0 +1,158 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: test_netem.c - Loopback test that the network emulator repeats itself for the same seed.
+--
+--
+-- PROGRAM: test_netem
+--
+-- FUNCTIONS:
+-- int main()
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- NOTES:
+-- Built and run with "make test". Three senders with a shim each send the same numbered datagrams to a
+-- receiver of their own, the first two with the same seed and the third with another. The test checks that:
+--     - the same seed loses, reorders and duplicates the same number of datagrams
+--     - the same seed delivers the same datagrams in the same order, reordered and duplicated ones included
+--     - the emulator really disturbed the traffic, and another seed disturbs it differently
+-- Delivery order depends on when each datagram is due, which netemSend counts from the time of the send.
+-- A rate limit the sender always stays ahead of makes every departure follow from the first one, so due
+-- times, and with them the order, come from the seed alone. The delay is at least the jitter so no
+-- datagram is due before it leaves.
+----------------------------------------------------------------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include "../include/netem.h"
+#include "test.h"
+
+#define TEST_SHIMS          3
+#define TEST_DATAGRAMS      150
+#define TEST_PAYLOAD        125
+#define TEST_RATE           500000
+#define TEST_DELAY          20000
+#define TEST_JITTER         15000
+#define TEST_SEED           0x5EED
+#define TEST_WAIT           500000
+
+struct shimRun{
+    struct socketStruct *sender;
+    struct socketStruct *receiver;
+    struct destination target;
+    struct netemStats stats;
+    uint32_t received[2 * TEST_DATAGRAMS];
+    uint32_t receivedCount;
+};
+
+static int32_t openRun(struct shimRun *run, uint64_t seed)
+{
+  struct netemConfig config;
+  struct destination bound;
+
+  memset(&config, 0, sizeof(config));
+  config.seed = seed;
+  config.lossRate = 0.1;
+  config.reorderRate = 0.1;
+  config.duplicateRate = 0.1;
+  config.delayMicroseconds = TEST_DELAY;
+  config.jitterMicroseconds = TEST_JITTER;
+  config.delayDistribution = NETEM_UNIFORM;
+  config.rateBitsPerSecond = TEST_RATE;
+  run->receivedCount = 0;
+  run->receiver = openUDP(&run->target);
+  run->sender = openUDP(&bound);
+  return run->receiver != 0 && run->sender != 0 && attachNetem(run->sender, &config);
+}
+
+static void receiveRun(struct shimRun *run)
+{
+  struct destination source;
+  char dataBuffer[TEST_PAYLOAD];
+  uint32_t number;
+
+  while (run->receivedCount < 2 * TEST_DATAGRAMS &&
+         recvDataTimeout(run->receiver, &source, dataBuffer, sizeof(dataBuffer), TEST_WAIT) == TEST_PAYLOAD)
+  {
+    memcpy(&number, dataBuffer, sizeof(number));
+    run->received[run->receivedCount++] = number;
+  }
+  getNetemStats(run->sender, &run->stats);
+}
+
+static int32_t sameOutcome(struct shimRun *first, struct shimRun *second)
+{
+  return first->stats.lost == second->stats.lost && first->stats.reordered == second->stats.reordered &&
+         first->stats.duplicated == second->stats.duplicated && first->receivedCount == second->receivedCount &&
+         memcmp(first->received, second->received, first->receivedCount * sizeof(uint32_t)) == 0;
+}
+
+int main()
+{
+  static struct shimRun runs[TEST_SHIMS];
+  char payload[TEST_PAYLOAD];
+  uint32_t outOfOrder = 0;
+  uint32_t number;
+  int32_t i;
+
+  if (!enterTestDirectory("test_netem"))
+  {
+    return 1;
+  }
+
+  for (i = 0; i < TEST_SHIMS; i++)
+  {
+    check(openRun(&runs[i], i < 2 ? TEST_SEED : TEST_SEED + 1), "attach a shim to a sender");
+  }
+
+  // A 125 byte datagram takes 2ms at the rate, far longer than a send through the shim
+  memset(payload, 0, sizeof(payload));
+  for (number = 0; number < TEST_DATAGRAMS; number++)
+  {
+    memcpy(payload, &number, sizeof(number));
+    for (i = 0; i < TEST_SHIMS; i++)
+    {
+      sendData(runs[i].sender, &runs[i].target, payload, sizeof(payload));
+    }
+  }
+  for (i = 0; i < TEST_SHIMS; i++)
+  {
+    receiveRun(&runs[i]);
+  }
+
+  for (i = 0; i < TEST_SHIMS; i++)
+  {
+    printf("  seed %#x: %llu lost, %llu reordered, %llu duplicated, %u received\n", i < 2 ? TEST_SEED : TEST_SEED + 1,
+           (unsigned long long)runs[i].stats.lost, (unsigned long long)runs[i].stats.reordered,
+           (unsigned long long)runs[i].stats.duplicated, runs[i].receivedCount);
+  }
+  for (i = 1; i < (int32_t)runs[0].receivedCount; i++)
+  {
+    outOfOrder += runs[0].received[i] <= runs[0].received[i - 1];
+  }
+  check(runs[0].stats.lost > 0 && runs[0].stats.reordered > 0 && runs[0].stats.duplicated > 0,
+        "the shim lost, reordered and duplicated datagrams");
+  check(outOfOrder > 0, "datagrams arrived out of order");
+  check(runs[0].receivedCount == runs[0].stats.delivered &&
+        runs[0].stats.delivered == TEST_DATAGRAMS - runs[0].stats.lost + runs[0].stats.duplicated,
+        "every datagram that was not lost was delivered");
+  check(runs[0].stats.lost == runs[1].stats.lost, "the same seed loses the same number of datagrams");
+  check(runs[0].stats.reordered == runs[1].stats.reordered, "the same seed reorders the same number of datagrams");
+  check(runs[0].stats.duplicated == runs[1].stats.duplicated, "the same seed duplicates the same number of datagrams");
+  check(runs[0].receivedCount == runs[1].receivedCount &&
+        memcmp(runs[0].received, runs[1].received, runs[0].receivedCount * sizeof(uint32_t)) == 0,
+        "the same seed delivers the same datagrams in the same order");
+  check(!sameOutcome(&runs[0], &runs[2]), "another seed disturbs the traffic differently");
+
+  for (i = 0; i < TEST_SHIMS; i++)
+  {
+    releaseSocket(runs[i].sender);
+    releaseSocket(runs[i].receiver);
+  }
+  return finishTest("test_netem");
+}
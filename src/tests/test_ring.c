@@ -0,0 +1,150 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: test_ring.c - Loopback test of the AF_PACKET ring receiver and its port filter.
+--
+--
+-- PROGRAM: test_ring
+--
+-- FUNCTIONS:
+-- int main()
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- NOTES:
+-- Built and run with "make test". A receiver on lo with a few small blocks is fed numbered datagrams in
+-- rounds, with datagrams for a neighbouring port mixed in. Each round is read back before the next is sent,
+-- so the receiver walks many blocks, partly filled ones retired by the block timeout among them, and wraps
+-- the ring several times. The test checks that:
+--     - every datagram for the port arrives once, in order, with its payload, length and source intact
+--     - the BPF filter keeps datagrams for the other port out of the ring. recvDataRing would skip them
+--       anyway, so this shows in the ring statistics rather than in what is received
+--     - an empty ring times out with ERR_TIMEOUT
+--     - getRingStats counts exactly the datagrams that passed the filter, with no drops
+-- Opening a packet socket needs CAP_NET_RAW; without it the test is skipped rather than failed.
+----------------------------------------------------------------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include "../include/ringrecv.h"
+#include "test.h"
+
+#define TEST_BLOCK_SIZE     8192
+#define TEST_BLOCK_COUNT    4
+#define TEST_ROUNDS         40
+#define TEST_ROUND_SIZE     10
+#define TEST_PAYLOAD        1000
+
+static int32_t sendNumbered(struct socketStruct *sender, struct destination *target, uint32_t number)
+{
+  char payload[TEST_PAYLOAD];
+
+  memset(payload, (char)number, sizeof(payload));
+  memcpy(payload, &number, sizeof(number));
+  return sendData(sender, target, payload, sizeof(payload));
+}
+
+int main()
+{
+  struct ringReceiver *receiver;
+  struct ringStats stats;
+  struct socketStruct *sender;
+  struct socketStruct *bound;
+  struct socketStruct *other;
+  struct destination senderAddress;
+  struct destination boundAddress;
+  struct destination otherAddress;
+  struct destination source;
+  const char *payload;
+  uint32_t expected = 0;
+  uint32_t number;
+  uint32_t sent = 0;
+  uint32_t outOfOrder = 0;
+  uint32_t badPayloads = 0;
+  uint32_t badSources = 0;
+  uint32_t blocksWalked = 0;
+  struct tpacket_block_desc *lastBlock = 0;
+  int32_t length;
+  int32_t round;
+  int32_t i;
+
+  if (!enterTestDirectory("test_ring"))
+  {
+    return 1;
+  }
+
+  // A socket bound to each port keeps the kernel from answering with port unreachable
+  sender = openUDP(&senderAddress);
+  bound = openUDP(&boundAddress);
+  other = openUDP(&otherAddress);
+  if ((receiver = openRingReceiver(boundAddress.port, "lo", TEST_BLOCK_SIZE, TEST_BLOCK_COUNT)) == 0)
+  {
+    printf("test_ring: SKIP, unable to open a packet ring on lo (lastSocketError %d)\n", lastSocketError);
+    return 0;
+  }
+
+  check(recvDataRing(receiver, &source, &payload, 0) == -1 && lastSocketError == ERR_TIMEOUT,
+        "an empty ring times out");
+
+  for (round = 0; round < TEST_ROUNDS; round++)
+  {
+    for (i = 0; i < TEST_ROUND_SIZE; i++)
+    {
+      sent += sendNumbered(sender, &boundAddress, sent);
+      sendNumbered(sender, &otherAddress, 0xFFFFFFFF);
+    }
+    while (expected < sent && (length = recvDataRing(receiver, &source, &payload, 1000000)) >= 0)
+    {
+      if (receiver->heldBlock != lastBlock)
+      {
+        lastBlock = receiver->heldBlock;
+        blocksWalked++;
+      }
+      memcpy(&number, payload, sizeof(number));
+      if (number != expected)
+      {
+        outOfOrder++;
+      }
+      if (length != TEST_PAYLOAD || payload[TEST_PAYLOAD - 1] != (char)number)
+      {
+        badPayloads++;
+      }
+      if (source.address != htonl(INADDR_LOOPBACK) || source.port != senderAddress.port)
+      {
+        badSources++;
+      }
+      expected = number + 1;
+    }
+  }
+
+  check(sent == TEST_ROUNDS * TEST_ROUND_SIZE, "every datagram was sent");
+  check(expected == sent, "every datagram for the port came out of the ring");
+  check(outOfOrder == 0, "datagrams came out once and in order across blocks");
+  check(badPayloads == 0, "payloads and lengths are intact");
+  check(badSources == 0, "source address and port are reported");
+  check(blocksWalked > 2 * TEST_BLOCK_COUNT, "the receiver walked enough blocks to wrap the ring");
+  check(recvDataRing(receiver, &source, &payload, 20000) == -1 && lastSocketError == ERR_TIMEOUT,
+        "nothing is left in the ring once every datagram is read");
+
+  check(getRingStats(receiver, &stats), "read the ring statistics");
+  printf("  ring: %llu packets, %llu drops, %llu freezes, %u blocks walked in a ring of %d blocks of %d bytes\n",
+         (unsigned long long)stats.packets, (unsigned long long)stats.drops, (unsigned long long)stats.freezes,
+         blocksWalked, TEST_BLOCK_COUNT, TEST_BLOCK_SIZE);
+#ifdef PACKET_IGNORE_OUTGOING
+  check(stats.packets == sent, "the ring counted only the datagrams for the port, the filter dropped the rest");
+#else
+  // Older kernels also hand the outgoing copy on loopback to the ring, which recvDataRing skips
+  check(stats.packets >= sent, "the ring counted the datagrams that passed the filter");
+#endif
+  check(stats.drops == 0, "no datagrams were dropped");
+
+  closeRingReceiver(receiver);
+  releaseSocket(sender);
+  releaseSocket(bound);
+  releaseSocket(other);
+  return finishTest("test_ring");
+}
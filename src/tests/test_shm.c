@@ -0,0 +1,250 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: test_shm.c - Loopback test of the shared memory localChannel and its TCP fallback.
+--
+--
+-- PROGRAM: test_shm
+--
+-- FUNCTIONS:
+-- int main()
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- NOTES:
+-- Built and run with "make test". Channels are set up on fixed ports of this host, with acceptLocal in a
+-- second thread or process, since connectLocal waits for the server to hand over the shared memory. The
+-- test checks that:
+--     - a channel between two ends on this host uses shared memory, and messages go both ways intact
+--     - messages of varying sizes pass the end of the smallest ring many times, both with the wrap marker
+--       and without, and one larger than half a ring is refused with ERR_ILLEGALOP
+--     - when the peer process exits without closing, recvLocal drains what it sent and then returns 0, and
+--       sendLocal fails with ERR_CONRESET once the ring is full
+--     - when the unix socket for the port is taken, both ends fall back to TCP behind the same calls, which
+--       then also carry messages larger than a ring
+-- An alarm stops the test if a channel blocks forever.
+----------------------------------------------------------------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stddef.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include "../include/shmtransport.h"
+#include "test.h"
+
+#define TEST_PORT           47210
+#define TEST_RING           4096
+#define TEST_WRAP_MESSAGES  200
+#define TEST_LARGE_MESSAGE  100000
+#define TEST_ALARM          30
+
+struct acceptJob{
+    struct localChannel *listener;
+    struct localChannel *accepted;
+};
+
+static void *acceptPeer(void *argument)
+{
+  struct acceptJob *job = argument;
+
+  job->accepted = acceptLocal(job->listener);
+  return 0;
+}
+
+static struct destination localPort(uint16_t port)
+{
+  struct destination dest;
+
+  dest.address = htonl(INADDR_LOOPBACK);
+  dest.port = htons(port);
+  return dest;
+}
+
+static int32_t openPair(uint16_t port, struct localChannel **listener, struct localChannel **server, struct localChannel **client)
+{
+  struct destination dest = localPort(port);
+  struct acceptJob job;
+  pthread_t acceptor;
+
+  if ((*listener = listenLocal(htons(port), TEST_RING)) == 0)
+  {
+    return 0;
+  }
+  job.listener = *listener;
+  job.accepted = 0;
+  pthread_create(&acceptor, 0, acceptPeer, &job);
+  *client = connectLocal(&dest);
+  pthread_join(acceptor, 0);
+  *server = job.accepted;
+  return *server != 0 && *client != 0;
+}
+
+static void fillMessage(char *message, uint32_t length, uint32_t number)
+{
+  uint32_t i;
+
+  for (i = 0; i < length; i++)
+  {
+    message[i] = (char)(number * 7 + i);
+  }
+}
+
+static void testRoundTrip()
+{
+  struct localChannel *listener;
+  struct localChannel *server;
+  struct localChannel *client;
+  char dataBuffer[64];
+
+  check(openPair(TEST_PORT, &listener, &server, &client), "open a channel on this host");
+  check(isLocalShared(server) && isLocalShared(client), "both ends use shared memory");
+  check(sendLocal(client, "ping", 4), "send from the client");
+  check(recvLocal(server, dataBuffer, sizeof(dataBuffer)) == 4 && memcmp(dataBuffer, "ping", 4) == 0,
+        "the server receives the message");
+  check(sendLocal(server, "pong!", 5), "send from the server");
+  check(recvLocal(client, dataBuffer, sizeof(dataBuffer)) == 5 && memcmp(dataBuffer, "pong!", 5) == 0,
+        "the client receives the reply");
+  check(sendLocal(client, "truncated", 9) && recvLocal(server, dataBuffer, 4) == 4 && memcmp(dataBuffer, "trun", 4) == 0,
+        "a message larger than the buffer is truncated");
+  closeLocal(client);
+  closeLocal(server);
+  closeLocal(listener);
+}
+
+static void testWrap()
+{
+  struct localChannel *listener;
+  struct localChannel *server;
+  struct localChannel *client;
+  char message[TEST_RING];
+  char dataBuffer[TEST_RING];
+  uint64_t ringBytes = 0;
+  uint32_t badMessages = 0;
+  uint32_t length;
+  uint32_t i;
+
+  check(openPair(TEST_PORT + 1, &listener, &server, &client), "open a channel with the smallest ring");
+  for (i = 0; i < TEST_WRAP_MESSAGES; i++)
+  {
+    // Lengths step through every 8 byte alignment so messages end at many offsets, some right at the end
+    length = 1 + (i * 331) % (TEST_RING / 2 - 8);
+    fillMessage(message, length, i);
+    if (!sendLocal(client, message, length) || recvLocal(server, dataBuffer, sizeof(dataBuffer)) != (int32_t)length ||
+        memcmp(dataBuffer, message, length) != 0)
+    {
+      badMessages++;
+    }
+    ringBytes += (sizeof(uint32_t) + length + 7) & ~7u;
+  }
+  check(badMessages == 0, "every message passes the end of the ring intact");
+  check(ringBytes > 20 * TEST_RING, "the messages wrapped the ring many times");
+  check(!sendLocal(client, message, TEST_RING / 2) && lastSocketError == ERR_ILLEGALOP,
+        "a message larger than half the ring is refused");
+  closeLocal(client);
+  closeLocal(server);
+  closeLocal(listener);
+}
+
+static void testPeerExit()
+{
+  struct destination dest = localPort(TEST_PORT + 2);
+  struct localChannel *listener;
+  struct localChannel *server;
+  struct localChannel *client;
+  char message[1000];
+  char dataBuffer[64];
+  int32_t status;
+  int32_t sends;
+  pid_t child;
+
+  if ((listener = listenLocal(dest.port, TEST_RING)) == 0)
+  {
+    check(0, "listen for the exiting peer");
+    return;
+  }
+  if ((child = fork()) == 0)
+  {
+    // Leave without closeLocal, as a crashing process would
+    if ((client = connectLocal(&dest)) == 0 || !isLocalShared(client) || !sendLocal(client, "last words", 10))
+    {
+      _exit(1);
+    }
+    _exit(0);
+  }
+
+  server = acceptLocal(listener);
+  check(server != 0 && isLocalShared(server), "accept the peer process over shared memory");
+  check(waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0,
+        "the peer process connected, sent and exited");
+  check(recvLocal(server, dataBuffer, sizeof(dataBuffer)) == 10 && memcmp(dataBuffer, "last words", 10) == 0,
+        "a message sent before the peer exited is still received");
+  check(recvLocal(server, dataBuffer, sizeof(dataBuffer)) == 0, "recvLocal then reports the peer gone");
+  fillMessage(message, sizeof(message), 0);
+  for (sends = 0; sends <= TEST_RING / (int32_t)sizeof(message) && sendLocal(server, message, sizeof(message)); sends++)
+  {
+  }
+  check(sends <= TEST_RING / (int32_t)sizeof(message) && lastSocketError == ERR_CONRESET,
+        "sendLocal fails with ERR_CONRESET once the ring is full");
+  closeLocal(server);
+  closeLocal(listener);
+}
+
+static void testFallback()
+{
+  struct localChannel *listener;
+  struct localChannel *server;
+  struct localChannel *client;
+  struct sockaddr_un squatAddress;
+  socklen_t squatLength;
+  char *message = malloc(TEST_LARGE_MESSAGE);
+  char *dataBuffer = malloc(TEST_LARGE_MESSAGE);
+  int32_t squatter;
+
+  // A bound unix socket that never listens keeps listenLocal off the name and refuses connectLocal
+  memset(&squatAddress, 0, sizeof(squatAddress));
+  squatAddress.sun_family = AF_UNIX;
+  squatLength = offsetof(struct sockaddr_un, sun_path) + 1 +
+                snprintf(squatAddress.sun_path + 1, sizeof(squatAddress.sun_path) - 1, "libsocket-%u", TEST_PORT + 3);
+  squatter = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+  check(bind(squatter, (struct sockaddr *)&squatAddress, squatLength) == 0, "take the unix socket name of the port");
+
+  check(openPair(TEST_PORT + 3, &listener, &server, &client), "open a channel without the unix socket");
+  check(!isLocalShared(server) && !isLocalShared(client), "both ends fall back to TCP");
+  check(sendLocal(client, "ping", 4), "send from the client over TCP");
+  check(recvLocal(server, dataBuffer, TEST_LARGE_MESSAGE) == 4 && memcmp(dataBuffer, "ping", 4) == 0,
+        "the server receives the framed message");
+  fillMessage(message, TEST_LARGE_MESSAGE, 3);
+  check(sendLocal(server, message, TEST_LARGE_MESSAGE), "send a message larger than a ring over TCP");
+  check(recvLocal(client, dataBuffer, TEST_LARGE_MESSAGE) == TEST_LARGE_MESSAGE &&
+        memcmp(dataBuffer, message, TEST_LARGE_MESSAGE) == 0, "the client receives it whole");
+  closeLocal(client);
+  check(recvLocal(server, dataBuffer, TEST_LARGE_MESSAGE) == 0, "the server sees the client disconnect");
+  closeLocal(server);
+  closeLocal(listener);
+  close(squatter);
+  free(message);
+  free(dataBuffer);
+}
+
+int main()
+{
+  if (!enterTestDirectory("test_shm"))
+  {
+    return 1;
+  }
+  alarm(TEST_ALARM);
+
+  testRoundTrip();
+  testWrap();
+  testPeerExit();
+  testFallback();
+
+  return finishTest("test_shm");
+}
@@ -0,0 +1,233 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: test_tick.c - Tests for the fixed timestep tick loop.
+--
+--
+-- PROGRAM: test_tick
+--
+-- FUNCTIONS:
+-- int main()
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- NOTES:
+-- Built and run with "make test". Checks that runTickLoop:
+--     - keeps ticks on the start + n * tickMicroseconds grid without drifting
+--     - reports a slow onTick as one call with elapsedTicks covering every boundary it ran past, and counts
+--       those boundaries as missed and the tick as an overrun
+--     - hands datagrams to onPacket between ticks and sends what onTick queued at the end of the tick
+-- Timing bounds are loose so the test passes on a loaded machine; they only catch a loop that drifts,
+-- stalls or loses count.
+----------------------------------------------------------------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <time.h>
+
+#include "../include/tick.h"
+#include "test.h"
+
+#define TEST_TICK           10000
+#define TEST_TICKS          50
+#define TEST_SLOW_TICK      5
+#define TEST_SLOW_SLEEP     35000
+#define TEST_DATAGRAMS      20
+
+struct tickRecord{
+    int64_t startMicroseconds;
+    uint64_t lastTick;
+    uint32_t calls;
+    uint32_t gaps;
+    uint32_t slowElapsed;
+    uint64_t stopAt;
+    int32_t slow;
+    int32_t received;
+    struct destination replyTo;
+    int32_t haveReply;
+};
+
+static int64_t nowMicroseconds()
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+static void recordTick(struct tickLoop *loop, uint64_t tick, uint32_t elapsedTicks, void *context)
+{
+  struct tickRecord *record = context;
+  struct timespec pause;
+
+  record->calls++;
+  if (tick != record->lastTick + elapsedTicks)
+  {
+    record->gaps++;
+  }
+  if (record->calls == TEST_SLOW_TICK + 1)
+  {
+    record->slowElapsed = elapsedTicks;
+  }
+  record->lastTick = tick;
+
+  if (record->slow && record->calls == TEST_SLOW_TICK)
+  {
+    pause.tv_sec = 0;
+    pause.tv_nsec = TEST_SLOW_SLEEP * 1000L;
+    nanosleep(&pause, 0);
+  }
+  if (record->haveReply)
+  {
+    queueTickSend(loop, &record->replyTo, (const char *)&tick, sizeof(tick));
+  }
+  if (tick >= record->stopAt)
+  {
+    stopTickLoop(loop);
+  }
+}
+
+static void recordPacket(struct tickLoop *loop, struct receivedPacket *packet, void *context)
+{
+  struct tickRecord *record = context;
+
+  (void)loop;
+  record->received++;
+  record->replyTo = packet->source;
+  record->haveReply = 1;
+}
+
+static struct tickLoop *startLoop(struct socketStruct *socketPointer, struct tickRecord *record)
+{
+  struct tickConfig config;
+
+  memset(&config, 0, sizeof(config));
+  config.tickMicroseconds = TEST_TICK;
+  config.onTick = recordTick;
+  config.onPacket = recordPacket;
+  config.context = record;
+  record->startMicroseconds = nowMicroseconds();
+  return createTickLoop(socketPointer, &config);
+}
+
+static void testCadence()
+{
+  struct destination bound;
+  struct socketStruct *server = openUDP(&bound);
+  struct tickRecord record;
+  struct tickStats stats;
+  struct tickLoop *loop;
+  int64_t elapsed;
+
+  memset(&record, 0, sizeof(record));
+  record.stopAt = TEST_TICKS;
+  loop = startLoop(server, &record);
+  check(loop != 0, "create a tick loop");
+  check(runTickLoop(loop), "run the loop until onTick stops it");
+  elapsed = nowMicroseconds() - record.startMicroseconds;
+  getTickStats(loop, &stats);
+
+  printf("  cadence: %llu ticks in %lld us, %llu missed, max lateness %lld us\n", (unsigned long long)stats.ticks,
+         (long long)elapsed, (unsigned long long)stats.missedTicks, (long long)stats.maxLatenessMicroseconds);
+  check(record.lastTick >= TEST_TICKS, "tick numbers reach the stop tick");
+  check(record.gaps == 0, "each tick number advances by elapsedTicks");
+  check(stats.ticks + stats.missedTicks == record.lastTick, "every boundary is either run or counted as missed");
+  // The last tick is due at exactly TEST_TICKS intervals, so anything well past that is drift
+  check(elapsed >= TEST_TICKS * TEST_TICK && elapsed < TEST_TICKS * TEST_TICK + 10 * TEST_TICK,
+        "ticks stay on the grid without drifting");
+  freeTickLoop(loop);
+  releaseSocket(server);
+}
+
+static void testOverrun()
+{
+  struct destination bound;
+  struct socketStruct *server = openUDP(&bound);
+  struct tickRecord record;
+  struct tickStats stats;
+  struct tickLoop *loop;
+
+  memset(&record, 0, sizeof(record));
+  record.stopAt = TEST_SLOW_TICK + 10;
+  record.slow = 1;
+  loop = startLoop(server, &record);
+  runTickLoop(loop);
+  getTickStats(loop, &stats);
+
+  printf("  overrun: slow tick followed by elapsedTicks %u, %llu missed, %llu overruns, max work %lld us\n",
+         record.slowElapsed, (unsigned long long)stats.missedTicks, (unsigned long long)stats.overruns,
+         (long long)stats.maxWorkMicroseconds);
+  // A 35ms tick on a 10ms grid runs past three boundaries, the first of which is the next tick itself
+  check(record.slowElapsed >= 3, "the tick after a slow one reports every boundary that passed");
+  check(stats.missedTicks >= 2, "boundaries passed during the slow tick are counted as missed");
+  check(stats.overruns >= 1, "the slow tick is counted as an overrun");
+  check(stats.maxWorkMicroseconds >= TEST_SLOW_SLEEP, "work time includes the slow onTick");
+  check(record.gaps == 0, "tick numbers stay on the grid after the overrun");
+  freeTickLoop(loop);
+  releaseSocket(server);
+}
+
+static void *sendDatagrams(void *argument)
+{
+  struct destination *target = argument;
+  struct destination bound;
+  struct destination source;
+  struct socketStruct *client = openUDP(&bound);
+  char dataBuffer[64];
+  int32_t i;
+
+  for (i = 0; i < TEST_DATAGRAMS; i++)
+  {
+    sendData(client, target, "ping", 4);
+  }
+  // The loop answers on every tick once it knows where to send
+  if (recvDataTimeout(client, &source, dataBuffer, sizeof(dataBuffer), 1000000) != sizeof(uint64_t))
+  {
+    check(0, "a reply queued in onTick arrives");
+  }
+  releaseSocket(client);
+  return 0;
+}
+
+static void testPackets()
+{
+  struct destination bound;
+  struct socketStruct *server = openUDP(&bound);
+  struct tickRecord record;
+  struct tickStats stats;
+  struct tickLoop *loop;
+  pthread_t sender;
+
+  memset(&record, 0, sizeof(record));
+  record.stopAt = 20;
+  loop = startLoop(server, &record);
+  pthread_create(&sender, 0, sendDatagrams, &bound);
+  runTickLoop(loop);
+  pthread_join(sender, 0);
+  getTickStats(loop, &stats);
+
+  check(record.received == TEST_DATAGRAMS, "every datagram reaches onPacket");
+  check(stats.packetsReceived == TEST_DATAGRAMS, "received datagrams are counted");
+  check(stats.packetsSent > 0 && stats.sendErrors == 0, "queued replies are sent at the end of each tick");
+  freeTickLoop(loop);
+  releaseSocket(server);
+}
+
+int main()
+{
+  if (!enterTestDirectory("test_tick"))
+  {
+    return 1;
+  }
+
+  testCadence();
+  testOverrun();
+  testPackets();
+
+  return finishTest("test_tick");
+}
@@ -0,0 +1,332 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: tsan_stress.c - Concurrency stress test for the socket functions, run under ThreadSanitizer.
+--
+--
+-- PROGRAM: tsan_stress
+--
+-- FUNCTIONS:
+-- int main()
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- NOTES:
+-- Built and run with "make tsan", which compiles the library sources into the program with
+-- -fsanitize=thread. It checks the concurrency rule in socket.c:
+--     - one thread sends while another receives on the same UDP socketStruct, in both directions
+--     - one thread writes a TCP stream while another reads the echo on the same socketStruct
+--     - capture logs are attached and detached on one socket while others send and receive through the
+--       descriptor table
+--     - threads that keep failing in different ways each read back only their own error code
+-- ThreadSanitizer reports any data race and fails the run. The checks here only verify the data arrived
+-- and the error codes were right.
+----------------------------------------------------------------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+
+#include "../include/capture.h"
+#include "test.h"
+
+#define STRESS_DATAGRAMS    20000
+#define STRESS_STREAM       (4 << 20)
+#define STRESS_CHUNK        4096
+#define STRESS_ERRORS       2000
+#define STRESS_ATTACHES     2000
+
+struct udpPeer{
+    struct socketStruct * socket;
+    struct destination target;
+    int32_t received;
+    int32_t sendFailures;
+};
+
+struct tcpPeer{
+    struct socketStruct * socket;
+    int64_t bytes;
+    int32_t failed;
+};
+
+struct errorThread{
+    int32_t expected;
+    struct socketStruct * socket;
+    struct destination target;
+    int32_t mismatches;
+};
+
+static int32_t stopAttaching;
+
+static void *sendDatagrams(void *argument)
+{
+  struct udpPeer *peer = argument;
+  int32_t i;
+
+  for (i = 0; i < STRESS_DATAGRAMS; i++)
+  {
+    if (!sendData(peer->socket, &peer->target, (const char *)&i, sizeof(i)))
+    {
+      peer->sendFailures++;
+    }
+  }
+  return 0;
+}
+
+static void *receiveDatagrams(void *argument)
+{
+  struct udpPeer *peer = argument;
+  struct destination source;
+  char dataBuffer[64];
+
+  // Loopback can drop under a burst, so stop once the sender has been quiet for a while
+  while (recvDataTimeout(peer->socket, &source, dataBuffer, sizeof(dataBuffer), 500000) > 0)
+  {
+    peer->received++;
+  }
+  return 0;
+}
+
+static void *writeStream(void *argument)
+{
+  struct tcpPeer *peer = argument;
+  char chunk[STRESS_CHUNK];
+  int64_t sent;
+
+  memset(chunk, 's', sizeof(chunk));
+  for (sent = 0; sent < STRESS_STREAM; sent += sizeof(chunk))
+  {
+    if (!sendDataTCP(peer->socket, chunk, sizeof(chunk)))
+    {
+      peer->failed = 1;
+      break;
+    }
+  }
+  return 0;
+}
+
+static void *readStream(void *argument)
+{
+  struct tcpPeer *peer = argument;
+  char chunk[STRESS_CHUNK];
+
+  while (peer->bytes < STRESS_STREAM)
+  {
+    if (recvDataTCP(peer->socket, chunk, sizeof(chunk)) != sizeof(chunk))
+    {
+      peer->failed = 1;
+      break;
+    }
+    peer->bytes += sizeof(chunk);
+  }
+  return 0;
+}
+
+static void *echoStream(void *argument)
+{
+  struct tcpPeer *peer = argument;
+  char chunk[STRESS_CHUNK];
+
+  while (peer->bytes < STRESS_STREAM)
+  {
+    if (recvDataTCP(peer->socket, chunk, sizeof(chunk)) != sizeof(chunk) ||
+        !sendDataTCP(peer->socket, chunk, sizeof(chunk)))
+    {
+      peer->failed = 1;
+      break;
+    }
+    peer->bytes += sizeof(chunk);
+  }
+  return 0;
+}
+
+static void *provokeErrors(void *argument)
+{
+  struct errorThread *thread = argument;
+  char dataBuffer[16];
+  struct destination source;
+  int32_t i;
+
+  for (i = 0; i < STRESS_ERRORS; i++)
+  {
+    switch (thread->expected)
+    {
+    case ERR_TIMEOUT:
+      recvDataTimeout(thread->socket, &source, dataBuffer, sizeof(dataBuffer), 0);
+      break;
+    case ERR_ILLEGALOP:
+      sendData(thread->socket, &thread->target, 0, 1);
+      break;
+    case ERR_ADDRINUSE:
+      bindPort(thread->socket, thread->target.port);
+      break;
+    }
+    if (getSocketError(thread->socket) != thread->expected)
+    {
+      thread->mismatches++;
+    }
+  }
+  return 0;
+}
+
+static void *churnCapture(void *argument)
+{
+  struct socketStruct *socketPointer = argument;
+  struct captureLog *log = openCapture("stress.cap", 1 << 20);
+  int32_t i;
+
+  for (i = 0; i < STRESS_ATTACHES && !__atomic_load_n(&stopAttaching, __ATOMIC_RELAXED); i++)
+  {
+    attachCapture(socketPointer, log);
+    detachCapture(socketPointer);
+  }
+  closeCapture(log);
+  return 0;
+}
+
+static void stressDatagrams(struct captureLog *log)
+{
+  struct destination firstBound;
+  struct destination secondBound;
+  struct udpPeer first;
+  struct udpPeer second;
+  struct udpPeer firstReceiver;
+  struct udpPeer secondReceiver;
+  struct socketTuning tuning;
+  pthread_t threads[5];
+  struct destination spareBound;
+  struct socketStruct *spare = openUDP(&spareBound);
+
+  memset(&first, 0, sizeof(first));
+  memset(&second, 0, sizeof(second));
+  first.socket = openUDP(&firstBound);
+  second.socket = openUDP(&secondBound);
+  memset(&tuning, 0, sizeof(tuning));
+  tuning.receiveBufferSize = 4 << 20;
+  tuneSocket(first.socket, &tuning);
+  tuneSocket(second.socket, &tuning);
+  first.target = secondBound;
+  second.target = firstBound;
+  firstReceiver = first;
+  secondReceiver = second;
+  attachCapture(first.socket, log);
+
+  // Each socketStruct is sent on by one thread and received on by another at the same time
+  pthread_create(&threads[0], 0, receiveDatagrams, &firstReceiver);
+  pthread_create(&threads[1], 0, receiveDatagrams, &secondReceiver);
+  pthread_create(&threads[2], 0, sendDatagrams, &first);
+  pthread_create(&threads[3], 0, sendDatagrams, &second);
+  pthread_create(&threads[4], 0, churnCapture, spare);
+  pthread_join(threads[2], 0);
+  pthread_join(threads[3], 0);
+  pthread_join(threads[0], 0);
+  pthread_join(threads[1], 0);
+  __atomic_store_n(&stopAttaching, 1, __ATOMIC_RELAXED);
+  pthread_join(threads[4], 0);
+
+  printf("  udp: %d and %d of %d datagrams received\n", firstReceiver.received, secondReceiver.received, STRESS_DATAGRAMS);
+  check(firstReceiver.received > 0 && secondReceiver.received > 0, "datagrams flow both ways");
+  check(first.sendFailures == 0 && second.sendFailures == 0, "no sendData failures");
+  releaseSocket(first.socket);
+  releaseSocket(second.socket);
+  releaseSocket(spare);
+}
+
+static void stressStream()
+{
+  struct socketStruct *listener = createSocket();
+  struct socketStruct *client = createSocket();
+  struct socketStruct server;
+  struct destination bound;
+  struct sockaddr_in address;
+  socklen_t addressLength = sizeof(address);
+  struct tcpPeer writer;
+  struct tcpPeer reader;
+  struct tcpPeer echo;
+  pthread_t threads[3];
+
+  initSocketTCP(listener);
+  bindPort(listener, 0);
+  listenTCP(listener, 1);
+  getsockname(listener->socketDescriptor, (struct sockaddr *)&address, &addressLength);
+  bound.address = htonl(INADDR_LOOPBACK);
+  bound.port = address.sin_port;
+  initSocketTCP(client);
+  check(connectPort(client, &bound), "connect the stream pair");
+  // A legacy caller wrapping the descriptor from acceptClient in its own struct
+  server.socketDescriptor = acceptClient(listener);
+  releaseSocket(listener);
+
+  memset(&writer, 0, sizeof(writer));
+  writer.socket = client;
+  reader = writer;
+  echo = writer;
+  echo.socket = &server;
+
+  pthread_create(&threads[0], 0, echoStream, &echo);
+  pthread_create(&threads[1], 0, readStream, &reader);
+  pthread_create(&threads[2], 0, writeStream, &writer);
+  pthread_join(threads[2], 0);
+  pthread_join(threads[1], 0);
+  pthread_join(threads[0], 0);
+
+  check(!writer.failed && !reader.failed && !echo.failed, "stream sent, echoed and read without errors");
+  check(reader.bytes == STRESS_STREAM, "whole stream echoed back");
+  closeSocket(&server);
+  releaseSocket(client);
+}
+
+static void stressErrors()
+{
+  struct errorThread threads[3];
+  pthread_t handles[3];
+  struct destination bound;
+  struct socketStruct *quiet = openUDP(&bound);
+  struct socketStruct *taken = createSocket();
+  int32_t i;
+
+  initSocket(taken);
+  memset(threads, 0, sizeof(threads));
+  threads[0].expected = ERR_TIMEOUT;
+  threads[0].socket = quiet;
+  threads[1].expected = ERR_ILLEGALOP;
+  threads[1].socket = quiet;
+  threads[1].target = bound;
+  threads[2].expected = ERR_ADDRINUSE;
+  threads[2].socket = taken;
+  threads[2].target = bound;
+
+  for (i = 0; i < 3; i++)
+  {
+    pthread_create(&handles[i], 0, provokeErrors, &threads[i]);
+  }
+  for (i = 0; i < 3; i++)
+  {
+    pthread_join(handles[i], 0);
+    check(threads[i].mismatches == 0, "each thread reads back its own error code");
+  }
+  releaseSocket(quiet);
+  releaseSocket(taken);
+}
+
+int main()
+{
+  struct captureLog *log;
+
+  if (!enterTestDirectory("tsan_stress"))
+  {
+    return 1;
+  }
+  log = openCapture("udp.cap", 16 << 20);
+
+  stressDatagrams(log);
+  stressStream();
+  stressErrors();
+
+  check(closeCapture(log), "capture log closes once its socket is closed");
+  return finishTest("tsan_stress");
+}
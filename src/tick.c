@@ -0,0 +1,474 @@
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: tick.c - Fixed timestep server loop driven by a timerfd and socket readiness.
+--
+--
+-- PROGRAM: libsocket
+--
+-- FUNCTIONS:
+-- struct tickLoop * createTickLoop(struct socketStruct * socketPointer, struct tickConfig * config)
+-- int queueTickSend(struct tickLoop * loop, struct destination * dest, const char * data, uint32_t dataLength)
+-- int runTickLoop(struct tickLoop * loop)
+-- void stopTickLoop(struct tickLoop * loop)
+-- void getTickStats(struct tickLoop * loop, struct tickStats * stats)
+-- void freeTickLoop(struct tickLoop * loop)
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- NOTES:
+-- A tickLoop runs the usual game server loop on a bound UDP socket: receive until the tick is due, run the
+-- simulation, send the results. runTickLoop waits with poll on the socket and on a timerfd armed with an
+-- absolute first expiry and a fixed interval, so ticks stay on the start + n * tickMicroseconds grid and
+-- never drift the way repeated sleeps or receive timeouts do. Between ticks datagrams are read with
+-- recvDataBatch and handed to onPacket one at a time. When the timer expires, onTick runs and every
+-- datagram queued with queueTickSend during the tick is sent together with sendDataBatch.
+--
+-- If a tick takes longer than the interval, the timer reports how many boundaries passed. onTick is called
+-- once with elapsedTicks set to that count so the simulation can step more than once or skip ahead, and
+-- the extra boundaries are counted as missed. getTickStats reports how late each tick started against its
+-- boundary (the jitter), how long the work took, and how many ticks overran into the next one.
+--
+-- All callbacks run on the thread that called runTickLoop, and only that thread may queue sends. recvData
+-- and friends should not be used on the socket while the loop runs. Datagrams are drained without
+-- blocking even on a blocking socket, so one dropped by the kernel after poll reported it, such as one
+-- with a bad checksum, can not hold the loop past the next tick.
+----------------------------------------------------------------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+
+#include "include/tick.h"
+#include "include/internal.h"
+
+static void runTick(struct tickLoop *loop, uint64_t expirations);
+static void flushSends(struct tickLoop *loop);
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: createTickLoop
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: struct tickLoop * createTickLoop(struct socketStruct * socketPointer, struct tickConfig * config)
+--                struct socketStruct * socketPointer: A bound UDP socket to serve
+--                struct tickConfig * config: The tick interval and callbacks. sendQueueLength and
+--                                            maxPacketSize may be 0 to use TICK_DEFAULT_SENDS and
+--                                            TICK_DEFAULT_PACKET. Either callback may be null.
+--
+-- RETURNS: On success a pointer to a tickLoop is returned. On error a null pointer is returned and
+--          lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used to set up a loop before running it. The receive and send buffers are allocated
+-- once here, so the loop itself does not allocate.
+----------------------------------------------------------------------------------------------------------------------*/
+struct tickLoop *createTickLoop(struct socketStruct *socketPointer, struct tickConfig *config)
+{
+  struct tickLoop *loop;
+  uint32_t i;
+
+  if (socketPointer == 0)
+  {
+    logger("ERROR > invalid socket passed to createTickLoop", -1);
+    return 0;
+  }
+  if (config == 0 || config->tickMicroseconds <= 0)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid config passed to createTickLoop", lastSocketError);
+    return 0;
+  }
+  if ((loop = calloc(1, sizeof(struct tickLoop))) == 0)
+  {
+    lastSocketError = ERR_NOMEMORY;
+    logger("ERROR > unable to allocate tick loop", lastSocketError);
+    return 0;
+  }
+
+  loop->socket = socketPointer;
+  loop->config = *config;
+  loop->config.sendQueueLength = config->sendQueueLength == 0 ? TICK_DEFAULT_SENDS : config->sendQueueLength;
+  loop->config.maxPacketSize = config->maxPacketSize == 0 ? TICK_DEFAULT_PACKET : config->maxPacketSize;
+  if ((loop->timerDescriptor = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK)) == -1)
+  {
+    lastSocketError = errno == ENOMEM ? ERR_NOMEMORY : ERR_UNKNOWN;
+    logger("ERROR > unable to create tick timer", lastSocketError);
+    free(loop);
+    return 0;
+  }
+
+  loop->receiveBuffer = malloc((size_t)RECV_BATCH_MAX * loop->config.maxPacketSize);
+  loop->sendPackets = calloc(loop->config.sendQueueLength, sizeof(struct sendPacket));
+  loop->sendBuffer = malloc((size_t)loop->config.sendQueueLength * loop->config.maxPacketSize);
+  if (loop->receiveBuffer == 0 || loop->sendPackets == 0 || loop->sendBuffer == 0)
+  {
+    lastSocketError = ERR_NOMEMORY;
+    logger("ERROR > unable to allocate tick loop buffers", lastSocketError);
+    freeTickLoop(loop);
+    return 0;
+  }
+  for (i = 0; i < RECV_BATCH_MAX; i++)
+  {
+    loop->receivePackets[i].dataBuffer = loop->receiveBuffer + (size_t)i * loop->config.maxPacketSize;
+    loop->receivePackets[i].dataBufferSize = loop->config.maxPacketSize;
+  }
+  for (i = 0; i < loop->config.sendQueueLength; i++)
+  {
+    loop->sendPackets[i].data = loop->sendBuffer + (size_t)i * loop->config.maxPacketSize;
+  }
+  return loop;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: queueTickSend
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int queueTickSend(struct tickLoop * loop, struct destination * dest, const char * data,
+--                              uint32_t dataLength)
+--                struct tickLoop * loop: The loop to send on
+--                struct destination * dest: Where the datagram is going
+--                const char * data: The datagram, copied before returning
+--                uint32_t dataLength: The length of the datagram, at most maxPacketSize
+--
+-- RETURNS: On success 1 is returned. On error 0 is returned and lastSocketError is set appropriately.
+--
+-- NOTES:
+-- This function is used from onTick or onPacket to queue a datagram for the end of the current tick. If
+-- the queue fills up it is sent early rather than dropping anything.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t queueTickSend(struct tickLoop *loop, struct destination *dest, const char *data, uint32_t dataLength)
+{
+  struct sendPacket *packet;
+
+  if (loop == 0)
+  {
+    logger("ERROR > invalid loop passed to queueTickSend", -1);
+    return 0;
+  }
+  if (dest == 0 || data == 0 || dataLength > loop->config.maxPacketSize)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > invalid datagram passed to queueTickSend", lastSocketError);
+    return 0;
+  }
+
+  if (loop->sendQueued == loop->config.sendQueueLength)
+  {
+    flushSends(loop);
+  }
+  packet = &loop->sendPackets[loop->sendQueued++];
+  packet->dest = *dest;
+  packet->dataLength = dataLength;
+  memcpy((char *)packet->data, data, dataLength);
+  return 1;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: runTickLoop
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS: October 18, 2026
+--              -Drain with receiveBatch so a datagram dropped after poll can not block past the tick
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: int runTickLoop(struct tickLoop * loop)
+--                struct tickLoop * loop: The loop to run
+--
+-- RETURNS: 1 once stopTickLoop has been called. On error 0 is returned and lastSocketError is set
+--          appropriately.
+--
+-- NOTES:
+-- This function is used to run the server. The first tick is due one interval after the call. A timer
+-- expiry is handled before waiting datagrams, so a flood of traffic can not hold back a tick; datagrams
+-- that arrive after the boundary belong to the next tick. Sends still queued when the loop stops are sent
+-- before returning.
+----------------------------------------------------------------------------------------------------------------------*/
+int32_t runTickLoop(struct tickLoop *loop)
+{
+  struct itimerspec schedule;
+  struct pollfd descriptors[2];
+  uint64_t expirations;
+  int64_t firstTick;
+  int32_t received;
+  int32_t result = 1;
+  int32_t i;
+
+  if (loop == 0)
+  {
+    logger("ERROR > invalid loop passed to runTickLoop", -1);
+    return 0;
+  }
+
+  loop->startMicroseconds = monotonicMicroseconds();
+  loop->tick = 0;
+  firstTick = loop->startMicroseconds + loop->config.tickMicroseconds;
+  schedule.it_value.tv_sec = firstTick / 1000000;
+  schedule.it_value.tv_nsec = (firstTick % 1000000) * 1000;
+  schedule.it_interval.tv_sec = loop->config.tickMicroseconds / 1000000;
+  schedule.it_interval.tv_nsec = (loop->config.tickMicroseconds % 1000000) * 1000;
+  if (timerfd_settime(loop->timerDescriptor, TFD_TIMER_ABSTIME, &schedule, 0) == -1)
+  {
+    lastSocketError = ERR_ILLEGALOP;
+    logger("ERROR > unable to start tick timer", lastSocketError);
+    return 0;
+  }
+
+  descriptors[0].fd = loop->timerDescriptor;
+  descriptors[0].events = POLLIN;
+  descriptors[1].fd = loop->socket->socketDescriptor;
+  descriptors[1].events = POLLIN;
+  atomic_store(&loop->running, 1);
+
+  while (atomic_load(&loop->running))
+  {
+    if (poll(descriptors, 2, -1) == -1)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      lastSocketError = errno == ENOMEM ? ERR_NOMEMORY : ERR_UNKNOWN;
+      logger("ERROR > failed to wait for tick or data", lastSocketError);
+      result = 0;
+      break;
+    }
+    if (descriptors[1].revents & POLLNVAL)
+    {
+      lastSocketError = ERR_BADSOCK;
+      logger("ERROR > socket closed while tick loop was running", lastSocketError);
+      result = 0;
+      break;
+    }
+
+    if ((descriptors[0].revents & POLLIN) && read(loop->timerDescriptor, &expirations, sizeof(expirations)) == sizeof(expirations))
+    {
+      runTick(loop, expirations);
+      continue;
+    }
+
+    if (descriptors[1].revents & (POLLIN | POLLERR))
+    {
+      if ((received = receiveBatch(loop->socket, loop->receivePackets, RECV_BATCH_MAX, 0)) > 0)
+      {
+        loop->stats.packetsReceived += received;
+        loop->stats.receiveBatches++;
+        for (i = 0; i < received && loop->config.onPacket != 0; i++)
+        {
+          loop->config.onPacket(loop, &loop->receivePackets[i], loop->config.context);
+        }
+      }
+    }
+  }
+
+  memset(&schedule, 0, sizeof(schedule));
+  timerfd_settime(loop->timerDescriptor, 0, &schedule, 0);
+  atomic_store(&loop->running, 0);
+  flushSends(loop);
+  return result;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: stopTickLoop
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: void stopTickLoop(struct tickLoop * loop)
+--                struct tickLoop * loop: The loop to stop
+--
+-- RETURNS: void.
+--
+-- NOTES:
+-- This function is used to make runTickLoop return, from a callback or from another thread. The loop
+-- notices at the latest when the next tick is due.
+----------------------------------------------------------------------------------------------------------------------*/
+void stopTickLoop(struct tickLoop *loop)
+{
+  if (loop != 0)
+  {
+    atomic_store(&loop->running, 0);
+  }
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: getTickStats
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: void getTickStats(struct tickLoop * loop, struct tickStats * stats)
+--                struct tickLoop * loop: The loop to report on
+--                struct tickStats * stats: Filled with the totals since the loop was created
+--
+-- RETURNS: void.
+--
+-- NOTES:
+-- This function is used to see how steady the tick is. Lateness is how long after its boundary each tick
+-- started and work is how long the tick callback and the flush took, so the mean of each is the total
+-- divided by ticks. A tick overruns when its work ends after the next boundary. Call it from a callback or
+-- after runTickLoop returns.
+----------------------------------------------------------------------------------------------------------------------*/
+void getTickStats(struct tickLoop *loop, struct tickStats *stats)
+{
+  if (loop == 0)
+  {
+    memset(stats, 0, sizeof(struct tickStats));
+    return;
+  }
+  *stats = loop->stats;
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: freeTickLoop
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: void freeTickLoop(struct tickLoop * loop)
+--                struct tickLoop * loop: A loop that is not running
+--
+-- RETURNS: void.
+--
+-- NOTES:
+-- This function is used to release a loop. The socket is left open.
+----------------------------------------------------------------------------------------------------------------------*/
+void freeTickLoop(struct tickLoop *loop)
+{
+  if (loop == 0)
+  {
+    return;
+  }
+  close(loop->timerDescriptor);
+  free(loop->receiveBuffer);
+  free(loop->sendPackets);
+  free(loop->sendBuffer);
+  free(loop);
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: runTick
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static void runTick(struct tickLoop * loop, uint64_t expirations)
+--                struct tickLoop * loop: The running loop
+--                uint64_t expirations: The number of tick boundaries passed since the last tick
+--
+-- RETURNS: void.
+--
+-- NOTES:
+-- Runs onTick, flushes the queued sends and records lateness, work time and overruns.
+----------------------------------------------------------------------------------------------------------------------*/
+static void runTick(struct tickLoop *loop, uint64_t expirations)
+{
+  int64_t start = monotonicMicroseconds();
+  int64_t lateness;
+  int64_t end;
+
+  loop->tick += expirations;
+  lateness = start - (loop->startMicroseconds + (int64_t)loop->tick * loop->config.tickMicroseconds);
+  lateness = lateness < 0 ? 0 : lateness;
+  loop->stats.ticks++;
+  loop->stats.missedTicks += expirations - 1;
+  loop->stats.totalLatenessMicroseconds += lateness;
+  if (lateness > loop->stats.maxLatenessMicroseconds)
+  {
+    loop->stats.maxLatenessMicroseconds = lateness;
+  }
+
+  if (loop->config.onTick != 0)
+  {
+    loop->config.onTick(loop, loop->tick, expirations, loop->config.context);
+  }
+  flushSends(loop);
+
+  end = monotonicMicroseconds();
+  loop->stats.totalWorkMicroseconds += end - start;
+  if (end - start > loop->stats.maxWorkMicroseconds)
+  {
+    loop->stats.maxWorkMicroseconds = end - start;
+  }
+  if (end > loop->startMicroseconds + (int64_t)(loop->tick + 1) * loop->config.tickMicroseconds)
+  {
+    loop->stats.overruns++;
+  }
+}
+
+/*------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: flushSends
+--
+-- DATE: October 18th, 2026
+--
+-- REVISIONS:
+--
+-- DESIGNER: agent
+--
+-- PROGRAMMER: agent
+--
+-- INTERFACE: static void flushSends(struct tickLoop * loop)
+--                struct tickLoop * loop: The loop whose queue should be sent
+--
+-- RETURNS: void.
+--
+-- NOTES:
+-- Sends the queue with sendDataBatch. A datagram that fails is counted and skipped so the rest still go out.
+----------------------------------------------------------------------------------------------------------------------*/
+static void flushSends(struct tickLoop *loop)
+{
+  uint32_t sent = 0;
+  int32_t result;
+
+  while (sent < loop->sendQueued)
+  {
+    result = sendDataBatch(loop->socket, loop->sendPackets + sent, loop->sendQueued - sent);
+    loop->stats.packetsSent += result;
+    sent += result;
+    if (sent < loop->sendQueued)
+    {
+      loop->stats.sendErrors++;
+      sent++;
+    }
+  }
+  loop->sendQueued = 0;
+}